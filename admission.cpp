@@ -0,0 +1,141 @@
+#include "admission.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+    // Leaves value alone when the variable is unset or not a positive number
+    template <typename T>
+    void readEnvironment(const char* name, T& value) {
+        const char* text = std::getenv(name);
+        if (text == nullptr) {
+            return;
+        }
+        char* end = nullptr;
+        double parsed = std::strtod(text, &end);
+        if (end != text && *end == '\0' && parsed > 0) {
+            value = static_cast<T>(parsed);
+        }
+    }
+}
+
+AdmissionLimits AdmissionLimits::fromEnvironment() {
+    AdmissionLimits limits;
+    readEnvironment("TOC_MAX_CONNECTIONS", limits.max_connections);
+    readEnvironment("TOC_MAX_CHEAP_PENDING", limits.max_cheap_pending);
+    readEnvironment("TOC_MAX_EXPENSIVE_PENDING", limits.max_expensive_pending);
+    readEnvironment("TOC_MAX_CLIENT_PENDING", limits.max_client_pending);
+    readEnvironment("TOC_RATE", limits.tokens_per_second);
+    readEnvironment("TOC_BURST", limits.burst);
+
+    std::size_t wait_ms = static_cast<std::size_t>(limits.max_queue_wait.count());
+    readEnvironment("TOC_MAX_QUEUE_WAIT_MS", wait_ms);
+    limits.max_queue_wait = std::chrono::milliseconds(wait_ms);
+    return limits;
+}
+
+AdmissionControl::AdmissionControl(const AdmissionLimits& limits) : limits_(limits) {}
+
+bool AdmissionControl::openConnection() {
+    if (connections_ >= limits_.max_connections) {
+        return false;
+    }
+    ++connections_;
+    return true;
+}
+
+void AdmissionControl::closeConnection() {
+    --connections_;
+}
+
+RequestClass AdmissionControl::classify(const std::string& method, const std::string& path,
+    std::size_t content_length) const {
+    if (method != "POST") {
+        return RequestClass::Cheap;
+    }
+    if (path == "/dfa") {
+        return content_length <= limits_.small_request_bytes ? RequestClass::Cheap : RequestClass::Expensive;
+    }
+    // Edits are incremental and closing only drops the session
+    if (path == "/session/edit" || path == "/session/close") {
+        return RequestClass::Cheap;
+    }
+    return RequestClass::Expensive;
+}
+
+AdmissionDecision AdmissionControl::admit(const std::string& client, RequestClass request_class,
+    Clock::time_point now) {
+    std::size_t& pending = request_class == RequestClass::Cheap ? cheap_pending_ : expensive_pending_;
+    std::size_t max_pending = request_class == RequestClass::Cheap ? limits_.max_cheap_pending : limits_.max_expensive_pending;
+    if (pending >= max_pending) {
+        return { AdmissionResult::Overloaded, 1 };
+    }
+
+    auto it = buckets_.find(client);
+    if (it == buckets_.end()) {
+        if (buckets_.size() >= limits_.max_clients) {
+            evictIdle(now);
+            if (buckets_.size() >= limits_.max_clients) {
+                return { AdmissionResult::Overloaded, 1 };
+            }
+        }
+        it = buckets_.emplace(client, Bucket{ limits_.burst, now, 0 }).first;
+    }
+
+    Bucket& bucket = it->second;
+    refill(bucket, now);
+    if (bucket.pending >= limits_.max_client_pending) {
+        return { AdmissionResult::RateLimited, 1 };
+    }
+
+    // A cost above the burst could never be paid, so it is capped at a full bucket
+    double cost = std::min(request_class == RequestClass::Cheap ? 1.0 : limits_.expensive_cost, limits_.burst);
+    if (bucket.tokens < cost) {
+        double wait = std::ceil((cost - bucket.tokens) / limits_.tokens_per_second);
+        return { AdmissionResult::RateLimited, std::max<std::uint32_t>(1, static_cast<std::uint32_t>(wait)) };
+    }
+
+    bucket.tokens -= cost;
+    ++bucket.pending;
+    ++pending;
+    return { AdmissionResult::Admitted, 0 };
+}
+
+void AdmissionControl::release(const std::string& client, RequestClass request_class) {
+    --(request_class == RequestClass::Cheap ? cheap_pending_ : expensive_pending_);
+    auto it = buckets_.find(client);
+    if (it != buckets_.end()) {
+        --it->second.pending;
+    }
+}
+
+std::size_t AdmissionControl::pending(RequestClass request_class) const {
+    return request_class == RequestClass::Cheap ? cheap_pending_ : expensive_pending_;
+}
+
+RequestClass AdmissionControl::next(bool cheap_waiting, bool expensive_waiting) {
+    if (cheap_waiting && (!expensive_waiting || cheap_streak_ < limits_.cheap_per_expensive)) {
+        ++cheap_streak_;
+        return RequestClass::Cheap;
+    }
+    cheap_streak_ = 0;
+    return RequestClass::Expensive;
+}
+
+void AdmissionControl::refill(Bucket& bucket, Clock::time_point now) const {
+    double seconds = std::chrono::duration<double>(now - bucket.updated).count();
+    bucket.tokens = std::min(limits_.burst, bucket.tokens + seconds * limits_.tokens_per_second);
+    bucket.updated = now;
+}
+
+void AdmissionControl::evictIdle(Clock::time_point now) {
+    for (auto it = buckets_.begin(); it != buckets_.end();) {
+        refill(it->second, now);
+        if (it->second.pending == 0 && it->second.tokens >= limits_.burst) {
+            it = buckets_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
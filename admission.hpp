@@ -0,0 +1,102 @@
+#ifndef ADMISSION_HPP
+#define ADMISSION_HPP
+
+#include <string>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// Requests are split by how much work they can cause: static files and small DFA runs are
+// cheap, conversions, searches and parses are expensive
+enum class RequestClass { Cheap, Expensive };
+
+struct AdmissionLimits {
+    // Open sockets, counting ones still sending their head and upgraded /trace sockets
+    std::size_t max_connections = 512;
+    // Requests admitted but not yet answered, per class
+    std::size_t max_cheap_pending = 256;
+    std::size_t max_expensive_pending = 32;
+    // Requests one client may have admitted at once
+    std::size_t max_client_pending = 8;
+    // Per-client token bucket; a cheap request costs one token, an expensive one more
+    double tokens_per_second = 20;
+    double burst = 40;
+    double expensive_cost = 5;
+    // A POST /dfa with a body up to this size is cheap
+    std::size_t small_request_bytes = 4096;
+    // Cheap requests served in a row before a waiting expensive one goes first
+    std::size_t cheap_per_expensive = 8;
+    // A request that waited longer than this is answered 503 instead of being served
+    std::chrono::milliseconds max_queue_wait{ 10000 };
+    // Clients tracked at once; idle full buckets are dropped to make room
+    std::size_t max_clients = 65536;
+
+    // Defaults overridden by the TOC_MAX_CONNECTIONS, TOC_MAX_CHEAP_PENDING,
+    // TOC_MAX_EXPENSIVE_PENDING, TOC_MAX_CLIENT_PENDING, TOC_RATE, TOC_BURST and
+    // TOC_MAX_QUEUE_WAIT_MS environment variables
+    static AdmissionLimits fromEnvironment();
+};
+
+enum class AdmissionResult {
+    Admitted,
+    // 429: the client ran out of tokens or has too many requests pending
+    RateLimited,
+    // 503: the class is at its pending limit or the client table is full
+    Overloaded
+};
+
+struct AdmissionDecision {
+    AdmissionResult result;
+    // Seconds the client should wait before retrying, for the Retry-After header
+    std::uint32_t retry_after;
+};
+
+// Admission decisions for the HTTP server, made from the request head alone so an
+// over-limit request is turned away before its body is read. The server owns the queues;
+// this only counts what is in them, so each class stays bounded and one client cannot fill
+// the expensive slots. Not thread-safe: the server calls it from its io_context.
+class AdmissionControl {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit AdmissionControl(const AdmissionLimits& limits = AdmissionLimits());
+
+    const AdmissionLimits& limits() const { return limits_; }
+
+    // False when the connection limit is reached; otherwise the caller must closeConnection
+    bool openConnection();
+    void closeConnection();
+    std::size_t connections() const { return connections_; }
+
+    RequestClass classify(const std::string& method, const std::string& path, std::size_t content_length) const;
+
+    // Charges the client's bucket and takes a pending slot when admitted; every admitted
+    // request must be released once it is answered or dropped
+    AdmissionDecision admit(const std::string& client, RequestClass request_class, Clock::time_point now);
+    void release(const std::string& client, RequestClass request_class);
+    std::size_t pending(RequestClass request_class) const;
+
+    // Which queue to serve next when the given ones have requests waiting. Cheap requests go
+    // first, but never more than cheap_per_expensive in a row while expensive ones wait.
+    RequestClass next(bool cheap_waiting, bool expensive_waiting);
+
+private:
+    struct Bucket {
+        double tokens;
+        Clock::time_point updated;
+        std::size_t pending;
+    };
+
+    void refill(Bucket& bucket, Clock::time_point now) const;
+    void evictIdle(Clock::time_point now);
+
+    AdmissionLimits limits_;
+    std::unordered_map<std::string, Bucket> buckets_;
+    std::size_t connections_ = 0;
+    std::size_t cheap_pending_ = 0;
+    std::size_t expensive_pending_ = 0;
+    std::size_t cheap_streak_ = 0;
+};
+
+#endif
@@ -0,0 +1,166 @@
+#include "antichain.hpp"
+#include "budget.hpp"
+#include <vector>
+
+namespace {
+
+struct SearchNode {
+    std::uint32_t left_state;
+    StateSet right_states;
+    std::uint32_t parent;
+    std::uint32_t symbol;
+    bool alive;
+};
+
+const std::uint32_t NO_NODE = 0xffffffffu;
+
+// Minimal right sets per left state; nodes pushed out by a smaller set are marked dead
+// so they are skipped when they come off the queue
+class Antichain {
+public:
+    explicit Antichain(std::uint32_t left_states) : buckets(left_states) {}
+
+    // Adds the node unless an existing one subsumes it; returns whether it was added
+    bool insert(std::vector<SearchNode>& nodes, std::uint32_t id) {
+        std::vector<std::uint32_t>& bucket = buckets[nodes[id].left_state];
+        const StateSet& candidate = nodes[id].right_states;
+
+        for (std::uint32_t existing : bucket) {
+            if (nodes[existing].right_states.isSubsetOf(candidate)) {
+                return false;
+            }
+        }
+
+        std::size_t kept = 0;
+        for (std::uint32_t existing : bucket) {
+            if (candidate.isSubsetOf(nodes[existing].right_states)) {
+                nodes[existing].alive = false;
+            }
+            else {
+                bucket[kept++] = existing;
+            }
+        }
+        bucket.resize(kept);
+        bucket.push_back(id);
+        return true;
+    }
+
+private:
+    std::vector<std::vector<std::uint32_t>> buckets;
+};
+
+std::string spellPath(const std::vector<SearchNode>& nodes, std::uint32_t id, const NFA& nfa) {
+    std::vector<std::uint32_t> path;
+    for (; nodes[id].parent != NO_NODE; id = nodes[id].parent) {
+        path.push_back(nodes[id].symbol);
+    }
+
+    std::string word;
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        word += nfa.symbolName(*it);
+    }
+    return word;
+}
+
+}
+
+bool isSubset(const NFA& left, const NFA& right, std::string& counterexample) {
+    std::vector<std::uint32_t> right_symbols;
+    for (std::uint32_t symbol = 0; symbol < left.symbolCount(); ++symbol) {
+        right_symbols.push_back(right.symbolId(left.symbolName(symbol)));
+    }
+
+    std::vector<SearchNode> nodes;
+    Antichain antichain(left.stateCount());
+    StateSet right_initial = right.initialStates();
+    StateSet right_empty(right.stateCount());
+
+    // A pair fails when the left state accepts and no right state in the set does
+    auto addNode = [&](std::uint32_t left_state, StateSet right_states, std::uint32_t parent, std::uint32_t symbol) {
+        ResourceBudget::chargeStates();
+        bool failed = left.isAccepting(left_state) && !right_states.intersects(right.acceptStates());
+        nodes.push_back(SearchNode{ left_state, std::move(right_states), parent, symbol, true });
+        if (failed) {
+            counterexample = spellPath(nodes, nodes.size() - 1, left);
+            return true;
+        }
+        if (!antichain.insert(nodes, nodes.size() - 1)) {
+            nodes.pop_back();
+        }
+        return false;
+    };
+
+    bool failed = false;
+    left.initialStates().forEach([&](std::uint32_t left_state) {
+        failed = failed || addNode(left_state, right_initial, NO_NODE, 0);
+    });
+    if (failed) {
+        return false;
+    }
+
+    for (std::uint32_t current = 0; current < nodes.size(); ++current) {
+        if (!nodes[current].alive) {
+            continue;
+        }
+
+        StateSet left_states(left.stateCount());
+        left_states.insert(nodes[current].left_state);
+
+        for (std::uint32_t symbol = 0; symbol < left.symbolCount(); ++symbol) {
+            StateSet left_next = left.step(left_states, symbol);
+            if (left_next.empty()) {
+                continue;
+            }
+
+            StateSet right_next = right_symbols[symbol] == SymbolTable::NO_SYMBOL
+                ? right_empty : right.step(nodes[current].right_states, right_symbols[symbol]);
+
+            left_next.forEach([&](std::uint32_t left_state) {
+                failed = failed || addNode(left_state, right_next, current, symbol);
+            });
+            if (failed) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool isUniversal(const NFA& nfa, std::string& counterexample) {
+    // The same search with a single left state that loops on every symbol and always accepts
+    std::vector<SearchNode> nodes;
+    Antichain antichain(1);
+
+    auto addNode = [&](StateSet states, std::uint32_t parent, std::uint32_t symbol) {
+        ResourceBudget::chargeStates();
+        bool failed = !states.intersects(nfa.acceptStates());
+        nodes.push_back(SearchNode{ 0, std::move(states), parent, symbol, true });
+        if (failed) {
+            counterexample = spellPath(nodes, nodes.size() - 1, nfa);
+            return true;
+        }
+        if (!antichain.insert(nodes, nodes.size() - 1)) {
+            nodes.pop_back();
+        }
+        return false;
+    };
+
+    if (addNode(nfa.initialStates(), NO_NODE, 0)) {
+        return false;
+    }
+
+    for (std::uint32_t current = 0; current < nodes.size(); ++current) {
+        if (!nodes[current].alive) {
+            continue;
+        }
+
+        for (std::uint32_t symbol = 0; symbol < nfa.symbolCount(); ++symbol) {
+            if (addNode(nfa.step(nodes[current].right_states, symbol), current, symbol)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,20 @@
+#ifndef ANTICHAIN_HPP
+#define ANTICHAIN_HPP
+
+#include <string>
+#include "nfa.hpp"
+
+// Language inclusion and universality for NFAs without determinizing them. The search
+// runs over pairs of a left state and an epsilon-closed set of right states, keeping
+// only pairs whose right set is minimal under inclusion: if (p, S) has been seen, any
+// (p, S') with S ⊆ S' cannot fail where (p, S) would not, so it is dropped. Usually a
+// small fraction of the subsets the subset construction would build is ever visited.
+
+// L(left) ⊆ L(right); on failure writes a string accepted by left but not by right.
+// Symbols are matched by name, and a left symbol missing from right empties the right set.
+bool isSubset(const NFA& left, const NFA& right, std::string& counterexample);
+
+// L(nfa) = Σ* over its own alphabet; on failure writes a string the NFA rejects
+bool isUniversal(const NFA& nfa, std::string& counterexample);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <cstddef>
+#include <memory_resource>
+#include "budget.hpp"
+
+// Upstream for the arena: plain heap blocks, charged against the active request budget
+class BudgetedResource : public std::pmr::memory_resource {
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        ResourceBudget::chargeMemory(bytes);
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// Monotonic bump allocator for everything a single request builds. Individual
+// deallocations are no-ops; the whole region is returned at once when the
+// arena goes out of scope, so construct it before the objects that use it.
+// Blocks taken beyond the inline buffer count against the active ResourceBudget.
+class RequestArena {
+public:
+    static constexpr std::size_t INLINE_SIZE = 16 * 1024;
+
+    RequestArena()
+        : pool(inline_buffer, sizeof(inline_buffer), &upstream) {}
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &pool; }
+
+private:
+    alignas(std::max_align_t) unsigned char inline_buffer[INLINE_SIZE];
+    BudgetedResource upstream;
+    std::pmr::monotonic_buffer_resource pool;
+};
+
+#endif
@@ -2,12 +2,19 @@
 #include <iostream>
 #include <sstream>
 
+Automaton::Automaton(std::pmr::memory_resource* memory)
+    : memory(memory), states(memory), alphabet(memory), start_state(NO_STATE), accept_states(memory),
+    tokenizer(memory), has_unknown_names(false) {}
+
 Automaton::Automaton(const std::string& states_str, const std::string& alphabet_str,
-    const std::string& start_state_str, const std::string& accept_states_str) {
+    const std::string& start_state_str, const std::string& accept_states_str,
+    std::pmr::memory_resource* memory)
+    : Automaton(memory) {
     parseStates(states_str);
     parseAlphabet(alphabet_str);
     parseStartState(start_state_str);
     parseAcceptStates(accept_states_str);
+    tokenizer.build(alphabet);
 }
 
 void Automaton::parseStates(const std::string& states_str) {
@@ -16,7 +23,7 @@ void Automaton::parseStates(const std::string& states_str) {
 
     while (std::getline(iss, state, ',')) {
         if (state == "\\n") break;
-        states.push_back(state);
+        if (!state.empty()) states.intern(state);
     }
 }
 
@@ -30,21 +37,37 @@ void Automaton::parseAlphabet(const std::string& alphabet_str) {
 
     while (std::getline(iss, symbol, ',')) {
         if (symbol == "\\n") break;
-        alphabet.insert(symbol);
+        if (!symbol.empty()) alphabet.intern(symbol);
     }
 }
 
 void Automaton::parseStartState(const std::string& start_state_str) {
-    start_state = start_state_str;
-    start_state.erase(0, start_state.find("n") + 1);
-    start_state.erase(0, start_state.find("n") + 2);
-    start_state.erase(start_state.find(","));
+    std::istringstream iss(start_state_str);
+    std::string start_state_name;
+
+    // Skip to the third section by its literal \n separators; searching for the letter 'n' broke
+    // on state names that contain one
+    for (int i = 0; i < 2; i++)
+        while (std::getline(iss, start_state_name, ',')) {
+            if (start_state_name == "\\n") break;
+        }
+
+    start_state = NO_STATE;
+    while (std::getline(iss, start_state_name, ',')) {
+        if (start_state_name == "\\n") break;
+        if (!start_state_name.empty()) {
+            start_state = states.find(start_state_name);
+            break;
+        }
+    }
 }
 
 void Automaton::parseAcceptStates(const std::string& accept_states_str) {
     std::istringstream iss(accept_states_str);
     std::string accept_state;
 
+    accept_states.resize(states.size());
+
     for (int i = 0; i < 3; i++)
         while (std::getline(iss, accept_state, ',')) {
             if (accept_state == "\\n") break;
@@ -52,6 +75,19 @@ void Automaton::parseAcceptStates(const std::string& accept_states_str) {
 
     while (std::getline(iss, accept_state, ',')) {
         if (accept_state == "\\n") break;
-        accept_states.insert(accept_state);
+        if (accept_state.empty()) continue;
+
+        std::uint32_t id = states.find(accept_state);
+        if (id == NO_STATE) {
+            has_unknown_names = true;
+        }
+        else {
+            accept_states.insert(id);
+        }
     }
-}
\ No newline at end of file
+}
+
+bool Automaton::validateNames() const {
+    // Names were resolved while parsing, so this no longer scans the state list
+    return start_state != NO_STATE && !has_unknown_names;
+}
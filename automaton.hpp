@@ -3,29 +3,55 @@
 
 #include <string>
 #include <vector>
-#include <unordered_set>
+#include <cstdint>
+#include <memory_resource>
+#include "symbol_table.hpp"
+#include "symbol_tokenizer.hpp"
+#include "state_set.hpp"
 
 class Automaton {
 public:
-    Automaton() {}
+    static constexpr std::uint32_t NO_STATE = SymbolTable::NO_SYMBOL;
+
+    Automaton(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
     Automaton(const std::string& states_str, const std::string& alphabet_str,
-        const std::string& start_state_str, const std::string& accept_states_str);
+        const std::string& start_state_str, const std::string& accept_states_str,
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource());
     virtual ~Automaton() = default;
 
     virtual bool validate() const = 0;
     virtual bool accepts(const std::string& input_str) const = 0;
     virtual std::string toString() const = 0;
 
+    // True when the definition referred to a state or symbol it never declared
+    bool hasUnknownNames() const { return has_unknown_names; }
+    // The longest-match splitter accepts() reads input with
+    const SymbolTokenizer& symbolTokenizer() const { return tokenizer; }
+
 protected:
-    std::vector<std::string> states;
-    std::unordered_set<std::string> alphabet;
-    std::string start_state;
-    std::unordered_set<std::string> accept_states;
+    // All containers allocate from this resource, typically a per-request arena
+    std::pmr::memory_resource* memory;
+
+    // Every state and symbol name is interned once while parsing; the engines
+    // only ever see the resulting dense ids
+    SymbolTable states;
+    SymbolTable alphabet;
+    std::uint32_t start_state;
+    StateSet accept_states;
+    // The alphabet compiled for splitting input into symbol ids; every constructor builds it
+    // once the alphabet is complete, so accepts() never mutates shared state
+    SymbolTokenizer tokenizer;
+
+    // Set when the definition refers to a state or symbol that was never declared
+    bool has_unknown_names;
 
     void parseStates(const std::string& states_str);
     void parseAlphabet(const std::string& alphabet_str);
     void parseStartState(const std::string& start_state_str);
     void parseAcceptStates(const std::string& accept_states_str);
+
+    // Checks the parts every automaton shares: start state, accept states and transition names
+    bool validateNames() const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,83 @@
+#include "big_unsigned.hpp"
+#include <sstream>
+#include <iomanip>
+
+BigUnsigned::BigUnsigned(std::uint64_t value) {
+    while (value > 0) {
+        limbs.push_back(static_cast<std::uint32_t>(value % BASE));
+        value /= BASE;
+    }
+}
+
+BigUnsigned& BigUnsigned::operator+=(const BigUnsigned& other) {
+    if (limbs.size() < other.limbs.size()) {
+        limbs.resize(other.limbs.size(), 0);
+    }
+
+    std::uint32_t carry = 0;
+    for (size_t i = 0; i < limbs.size(); ++i) {
+        std::uint32_t sum = limbs[i] + carry + (i < other.limbs.size() ? other.limbs[i] : 0);
+        carry = sum >= BASE;
+        limbs[i] = carry ? sum - BASE : sum;
+        if (!carry && i >= other.limbs.size()) {
+            break;
+        }
+    }
+    if (carry) {
+        limbs.push_back(carry);
+    }
+
+    return *this;
+}
+
+BigUnsigned BigUnsigned::operator+(const BigUnsigned& other) const {
+    BigUnsigned result = *this;
+    result += other;
+    return result;
+}
+
+BigUnsigned BigUnsigned::operator*(const BigUnsigned& other) const {
+    BigUnsigned result;
+    if (isZero() || other.isZero()) {
+        return result;
+    }
+
+    // Schoolbook multiplication with 64-bit accumulation per limb
+    std::vector<std::uint64_t> accumulator(limbs.size() + other.limbs.size() + 1, 0);
+    for (size_t i = 0; i < limbs.size(); ++i) {
+        std::uint64_t carry = 0;
+        for (size_t j = 0; j < other.limbs.size(); ++j) {
+            std::uint64_t current = accumulator[i + j] + std::uint64_t(limbs[i]) * other.limbs[j] + carry;
+            accumulator[i + j] = current % BASE;
+            carry = current / BASE;
+        }
+        for (size_t k = i + other.limbs.size(); carry > 0; ++k) {
+            std::uint64_t current = accumulator[k] + carry;
+            accumulator[k] = current % BASE;
+            carry = current / BASE;
+        }
+    }
+
+    result.limbs.assign(accumulator.begin(), accumulator.end());
+    result.trim();
+    return result;
+}
+
+std::string BigUnsigned::toString() const {
+    if (limbs.empty()) {
+        return "0";
+    }
+
+    std::ostringstream oss;
+    oss << limbs.back();
+    for (size_t i = limbs.size() - 1; i-- > 0;) {
+        oss << std::setw(9) << std::setfill('0') << limbs[i];
+    }
+    return oss.str();
+}
+
+void BigUnsigned::trim() {
+    while (!limbs.empty() && limbs.back() == 0) {
+        limbs.pop_back();
+    }
+}
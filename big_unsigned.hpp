@@ -0,0 +1,27 @@
+#ifndef BIG_UNSIGNED_HPP
+#define BIG_UNSIGNED_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Arbitrary precision non-negative integer, stored as base 10^9 limbs with
+// the least significant limb first so decimal output needs no conversion
+class BigUnsigned {
+public:
+    BigUnsigned(std::uint64_t value = 0);
+
+    bool isZero() const { return limbs.empty(); }
+    BigUnsigned& operator+=(const BigUnsigned& other);
+    BigUnsigned operator*(const BigUnsigned& other) const;
+    BigUnsigned operator+(const BigUnsigned& other) const;
+    std::string toString() const;
+
+private:
+    static constexpr std::uint32_t BASE = 1000000000u;
+    std::vector<std::uint32_t> limbs;
+
+    void trim();
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include "budget.hpp"
+#include <algorithm>
+
+thread_local ResourceBudget* ResourceBudget::current = nullptr;
+
+ResourceBudget::ResourceBudget(const BudgetLimits& limits)
+    : limits(limits), start(std::chrono::steady_clock::now()), states(0), memory(0), ticks(0), previous(current) {
+    current = this;
+}
+
+ResourceBudget::~ResourceBudget() {
+    current = previous;
+    // The memory stays allocated in the request arena; the enclosing budget notices on its next charge
+    if (previous) {
+        previous->memory += memory;
+    }
+}
+
+void ResourceBudget::chargeStates(std::uint64_t count) {
+    ResourceBudget* budget = current;
+    if (!budget) {
+        return;
+    }
+
+    budget->states += count;
+    if (budget->states > budget->limits.max_states) {
+        budget->exceed("states");
+    }
+    budget->checkDeadline();
+}
+
+void ResourceBudget::chargeMemory(std::size_t bytes) {
+    ResourceBudget* budget = current;
+    if (!budget) {
+        return;
+    }
+
+    budget->memory += bytes;
+    if (budget->memory > budget->limits.max_memory) {
+        budget->exceed("memory");
+    }
+}
+
+void ResourceBudget::checkpoint() {
+    ResourceBudget* budget = current;
+    if (budget) {
+        budget->checkDeadline();
+    }
+}
+
+BudgetLimits ResourceBudget::remaining() {
+    BudgetLimits left;
+    ResourceBudget* budget = current;
+    if (!budget) {
+        return left;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - budget->start);
+    left.max_states = budget->limits.max_states - std::min(budget->states, budget->limits.max_states);
+    left.max_memory = budget->limits.max_memory - std::min(budget->memory, budget->limits.max_memory);
+    left.deadline = std::max(budget->limits.deadline - elapsed, std::chrono::milliseconds(0));
+    return left;
+}
+
+void ResourceBudget::checkDeadline() {
+    if (++ticks % CHECK_INTERVAL != 0) {
+        return;
+    }
+    if (std::chrono::steady_clock::now() - start > limits.deadline) {
+        exceed("deadline");
+    }
+}
+
+void ResourceBudget::exceed(const char* limit) const {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    throw BudgetExceeded(limit, states, memory, elapsed.count());
+}
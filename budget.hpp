@@ -0,0 +1,73 @@
+#ifndef BUDGET_HPP
+#define BUDGET_HPP
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <stdexcept>
+
+struct BudgetLimits {
+    std::uint64_t max_states = 200000;
+    std::size_t max_memory = std::size_t(64) << 20;
+    std::chrono::milliseconds deadline{ 2000 };
+};
+
+// Thrown by the budget hooks once a limit is crossed; carries what was used up to that point
+class BudgetExceeded : public std::runtime_error {
+public:
+    BudgetExceeded(const std::string& limit, std::uint64_t states, std::size_t memory, std::uint64_t elapsed_us)
+        : std::runtime_error(limit + " limit exceeded"), limit_name(limit), states_used(states),
+        memory_used(memory), elapsed(elapsed_us) {}
+
+    const std::string& limit() const { return limit_name; }
+    std::uint64_t states() const { return states_used; }
+    std::size_t memory() const { return memory_used; }
+    std::uint64_t elapsedMicros() const { return elapsed; }
+
+private:
+    std::string limit_name;
+    std::uint64_t states_used;
+    std::size_t memory_used;
+    std::uint64_t elapsed;
+};
+
+// Per-request limits for the engines whose work can blow up (subset construction, product
+// and antichain searches, parsing). A budget is the active one for its thread from
+// construction to destruction. Engines report progress through the static hooks, which do
+// nothing when no budget is active and throw BudgetExceeded once a limit is crossed, so
+// the request unwinds through the normal exception path. A nested budget hands the memory
+// it was charged to the enclosing one when it ends.
+class ResourceBudget {
+public:
+    explicit ResourceBudget(const BudgetLimits& limits = BudgetLimits());
+    ~ResourceBudget();
+    ResourceBudget(const ResourceBudget&) = delete;
+    ResourceBudget& operator=(const ResourceBudget&) = delete;
+
+    // Counts automaton states, search nodes or parser states the caller just created
+    static void chargeStates(std::uint64_t count = 1);
+    // Counts bytes taken from the request arena's upstream allocator
+    static void chargeMemory(std::size_t bytes);
+    // Deadline check for inner loops; the clock is only read every CHECK_INTERVAL calls
+    static void checkpoint();
+    // What is left of the active budget, for a nested budget that must not outlast it;
+    // default limits when no budget is active
+    static BudgetLimits remaining();
+
+private:
+    static constexpr std::uint32_t CHECK_INTERVAL = 256;
+    static thread_local ResourceBudget* current;
+
+    BudgetLimits limits;
+    std::chrono::steady_clock::time_point start;
+    std::uint64_t states;
+    std::size_t memory;
+    std::uint32_t ticks;
+    ResourceBudget* previous;
+
+    void checkDeadline();
+    [[noreturn]] void exceed(const char* limit) const;
+};
+
+#endif
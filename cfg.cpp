@@ -1,91 +1,169 @@
 #include "cfg.hpp"
+#include "parse_tables.hpp"
+#include "earley.hpp"
+#include "grammar_analysis.hpp"
+#include "parse_forest.hpp"
+#include "symbol_tokenizer.hpp"
 #include <sstream>
 #include <algorithm>
 
-CFG::CFG(const std::string& cfg_str) : Grammar(cfg_str) {}
+struct CFG::Parsers {
+    GrammarRules rules;
+    GrammarAnalysis analysis;
+    FirstFollow sets;
+    LL1Table ll1;
+    LALRTable lalr;
+    EarleyRecognizer earley;
+    SymbolTokenizer terminals;
+
+    explicit Parsers(const Grammar& grammar)
+        : rules(grammar), analysis(rules), sets(rules), ll1(rules, sets), lalr(rules, sets), earley(rules, sets) {
+        terminals.build(grammar.terminalSymbols());
+    }
+};
+
+CFG::CFG(const std::string& cfg_str, std::pmr::memory_resource* memory) : Grammar(cfg_str, memory) {}
 
 bool CFG::validate() const {
     // Check if the start variable is a valid variable
-    if (variables.find(start_variable) == variables.end()) {
+    if (start_variable == SymbolTable::NO_SYMBOL) {
         return false;
     }
 
-    // Check if all productions are valid
-    for (const auto& entry : productions) {
-        const std::string& variable = entry.first;
-        const std::vector<std::string>& production_rules = entry.second;
+    // Production symbols were resolved while parsing, so there is nothing left to re-scan
+    return !has_unknown_symbols;
+}
 
-        // Check if the variable is a valid variable
-        if (!isVariable(variable)) {
-            return false;
-        }
+bool CFG::generates(const std::string& str) const {
+    std::vector<std::uint32_t> tokens;
+    if (!validate()) {
+        return false;
+    }
 
-        // Check if all production rules are valid
-        for (const std::string& rule : production_rules) {
-            if (!isValidProduction(rule)) {
-                return false;
-            }
-        }
+    // The analyses settle an empty language and the empty string without parsing
+    const Parsers& compiled = compiledParsers();
+    if (compiled.analysis.isEmpty() || !tokenize(str, tokens)) {
+        return false;
+    }
+    if (tokens.empty()) {
+        return compiled.analysis.isNullable(start_variable);
     }
 
-    return true;
+    // Deterministic grammars get a linear table-driven parse; everything else falls back to Earley
+    if (compiled.ll1.isDeterministic()) {
+        return compiled.ll1.recognize(tokens);
+    }
+    if (compiled.lalr.isDeterministic()) {
+        return compiled.lalr.recognize(tokens);
+    }
+    return compiled.earley.recognize(tokens);
 }
 
-bool CFG::generates(const std::string& str) const {
-    // TODO: CFG generates given string
-    return false;
+std::string CFG::parserKind() const {
+    const Parsers& compiled = compiledParsers();
+    if (compiled.ll1.isDeterministic()) {
+        return "LL(1)";
+    }
+    if (compiled.lalr.isDeterministic()) {
+        return "LALR(1)";
+    }
+    return "Earley";
+}
+
+std::vector<std::string> CFG::parseConflicts() const {
+    const Parsers& compiled = compiledParsers();
+    std::vector<std::string> conflicts = compiled.ll1.conflictList();
+    conflicts.insert(conflicts.end(), compiled.lalr.conflictList().begin(), compiled.lalr.conflictList().end());
+    return conflicts;
+}
+
+std::unique_ptr<ParseForest> CFG::parseForest(const std::string& str, std::pmr::memory_resource* memory) const {
+    std::vector<std::uint32_t> tokens;
+    if (!validate() || !tokenize(str, tokens)) {
+        return nullptr;
+    }
+    // Earley keeps every partial parse, whatever recognizer generates() would have picked
+    return std::make_unique<ParseForest>(compiledParsers().earley, tokens, memory);
+}
+
+const GrammarAnalysis& CFG::analysis() const {
+    return compiledParsers().analysis;
+}
+
+bool CFG::languageIsEmpty() const {
+    return analysis().isEmpty();
+}
+
+bool CFG::languageIsFinite() const {
+    return hasFiniteLanguage(chomskyNormalForm());
+}
+
+const GrammarRules& CFG::chomskyNormalForm() const {
+    if (!chomsky) {
+        chomsky = std::make_shared<const GrammarRules>(toChomskyNormalForm(compiledParsers().rules));
+    }
+    return *chomsky;
+}
+
+const GrammarRules& CFG::greibachNormalForm() const {
+    if (!greibach) {
+        greibach = std::make_shared<const GrammarRules>(toGreibachNormalForm(chomskyNormalForm()));
+    }
+    return *greibach;
 }
 
 std::string CFG::toString() const {
     std::ostringstream oss;
 
     // Convert variables to string
-    for (const std::string& variable : variables) {
-        oss << variable << ",";
+    for (std::uint32_t i = 0; i < variables.size(); ++i) {
+        oss << variables.name(i) << (i < variables.size() - 1 ? "," : "");
     }
-    oss.seekp(-1, std::ios_base::end);
     oss << "\n";
 
     // Convert terminals to string
-    for (const std::string& terminal : terminals) {
-        oss << terminal << ",";
+    for (std::uint32_t i = 0; i < terminals.size(); ++i) {
+        oss << terminals.name(i) << (i < terminals.size() - 1 ? "," : "");
     }
-    oss.seekp(-1, std::ios_base::end);
     oss << "\n";
 
     // Convert start variable to string
-    oss << start_variable << "\n";
+    if (start_variable != SymbolTable::NO_SYMBOL) {
+        oss << variables.name(start_variable);
+    }
+    oss << "\n";
 
-    // Convert productions to string
-    for (const auto& entry : productions) {
-        const std::string& variable = entry.first;
-        const std::vector<std::string>& production_rules = entry.second;
+    // Convert productions to string; symbols are space separated unless all are single characters
+    for (std::uint32_t variable = 0; variable < productions.size(); ++variable) {
+        for (const auto& rule : productions[variable]) {
+            bool compact = std::all_of(rule.begin(), rule.end(),
+                [this](std::uint32_t symbol) { return symbolName(symbol).size() == 1; });
 
-        for (const std::string& rule : production_rules) {
-            oss << variable << " " << rule << "\n";
+            oss << variables.name(variable) << " ->";
+            if (rule.empty()) {
+                oss << " e";
+            }
+            for (size_t i = 0; i < rule.size(); ++i) {
+                oss << (compact && i > 0 ? "" : " ") << symbolName(rule[i]);
+            }
+            oss << "\n";
         }
     }
 
     return oss.str();
 }
 
-bool CFG::isValidProduction(const std::string& production) const {
-    std::istringstream iss(production);
-    std::string symbol;
-
-    while (iss >> symbol) {
-        if (!isVariable(symbol) && !isTerminal(symbol)) {
-            return false;
-        }
+const CFG::Parsers& CFG::compiledParsers() const {
+    if (!parsers) {
+        parsers = std::make_shared<const Parsers>(*this);
     }
-
-    return true;
+    return *parsers;
 }
 
-bool CFG::isVariable(const std::string& symbol) const {
-    return variables.find(symbol) != variables.end();
+bool CFG::tokenize(const std::string& str, std::vector<std::uint32_t>& tokens) const {
+    // Longest match against the declared terminals, the same rule productions are split by
+    return compiledParsers().terminals.forEach(str, [&tokens](std::uint32_t terminal) {
+        tokens.push_back(terminal);
+        return true;
+    });
 }
-
-bool CFG::isTerminal(const std::string& symbol) const {
-    return terminals.find(symbol) != terminals.end();
-}
\ No newline at end of file
@@ -2,18 +2,47 @@
 #define CFG_HPP
 
 #include "grammar.hpp"
+#include <memory>
+#include <vector>
+
+struct GrammarRules;
+class GrammarAnalysis;
+class ParseForest;
 
 class CFG : public Grammar {
 public:
-    CFG(const std::string& cfg_str);
+    CFG(const std::string& cfg_str, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
     bool validate() const override;
     bool generates(const std::string& str) const override;
     std::string toString() const override;
 
+    // Recognizer generates() dispatches to: "LL(1)", "LALR(1)" or "Earley"
+    std::string parserKind() const;
+    // LL(1) and LALR(1) table conflicts that ruled out the cheaper recognizers
+    std::vector<std::string> parseConflicts() const;
+
+    // Nullable, productive and reachable variables, computed with the parsers
+    const GrammarAnalysis& analysis() const;
+    bool languageIsEmpty() const;
+    bool languageIsFinite() const;
+    // Every derivation of str, or null when str does not split into terminals; the forest
+    // refers to this grammar's compiled rules and must not outlive it
+    std::unique_ptr<ParseForest> parseForest(const std::string& str,
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const;
+
+    // Normal forms of the grammar with useless symbols removed, each built on first use
+    const GrammarRules& chomskyNormalForm() const;
+    const GrammarRules& greibachNormalForm() const;
+
 private:
-    bool isValidProduction(const std::string& production) const;
-    bool isVariable(const std::string& symbol) const;
-    bool isTerminal(const std::string& symbol) const;
+    struct Parsers;
+    // Built on first use and shared between copies; nothing in it refers back to the grammar
+    mutable std::shared_ptr<const Parsers> parsers;
+    mutable std::shared_ptr<const GrammarRules> chomsky;
+    mutable std::shared_ptr<const GrammarRules> greibach;
+
+    const Parsers& compiledParsers() const;
+    bool tokenize(const std::string& str, std::vector<std::uint32_t>& tokens) const;
 };
 
-#endif
\ No newline at end of file
+#endif
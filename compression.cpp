@@ -0,0 +1,92 @@
+#include "compression.hpp"
+#include <cctype>
+#include <cstdlib>
+#include <zlib.h>
+
+namespace {
+
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+    return text;
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+ContentEncoding negotiateEncoding(std::string_view accept_encoding) {
+    bool gzip = false, deflate = false;
+
+    while (!accept_encoding.empty()) {
+        std::size_t comma = accept_encoding.find(',');
+        std::string_view entry = accept_encoding.substr(0, comma);
+        accept_encoding.remove_prefix(comma == std::string_view::npos ? accept_encoding.size() : comma + 1);
+
+        std::size_t semicolon = entry.find(';');
+        std::string_view coding = trim(entry.substr(0, semicolon));
+        bool allowed = true;
+        if (semicolon != std::string_view::npos) {
+            std::string_view parameter = trim(entry.substr(semicolon + 1));
+            if (parameter.size() > 2 && (parameter[0] == 'q' || parameter[0] == 'Q') && parameter[1] == '=') {
+                allowed = std::atof(std::string(parameter.substr(2)).c_str()) > 0;
+            }
+        }
+
+        if (equalsIgnoreCase(coding, "gzip") || equalsIgnoreCase(coding, "x-gzip")) gzip = allowed;
+        else if (equalsIgnoreCase(coding, "deflate")) deflate = allowed;
+    }
+
+    if (gzip) return ContentEncoding::Gzip;
+    if (deflate) return ContentEncoding::Deflate;
+    return ContentEncoding::Identity;
+}
+
+const char* encodingName(ContentEncoding encoding) {
+    switch (encoding) {
+    case ContentEncoding::Gzip: return "gzip";
+    case ContentEncoding::Deflate: return "deflate";
+    default: return "identity";
+    }
+}
+
+bool compressBody(std::string_view body, ContentEncoding encoding, std::string& out) {
+    if (encoding == ContentEncoding::Identity) {
+        return false;
+    }
+
+    z_stream stream{};
+    // Window bits 15 + 16 asks zlib for a gzip header and trailer instead of the zlib wrapper
+    int window_bits = encoding == ContentEncoding::Gzip ? 15 + 16 : 15;
+    if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+
+    // deflateBound is an upper limit, so a single deflate call always finishes
+    std::string compressed(deflateBound(&stream, body.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(body.data()));
+    stream.avail_in = static_cast<uInt>(body.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&compressed[0]);
+    stream.avail_out = static_cast<uInt>(compressed.size());
+
+    int result = deflate(&stream, Z_FINISH);
+    std::size_t written = stream.total_out;
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        return false;
+    }
+
+    compressed.resize(written);
+    out = std::move(compressed);
+    return true;
+}
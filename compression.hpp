@@ -0,0 +1,20 @@
+#ifndef COMPRESSION_HPP
+#define COMPRESSION_HPP
+
+#include <string>
+#include <string_view>
+
+enum class ContentEncoding { Identity, Gzip, Deflate };
+
+// Picks gzip, then deflate, from an Accept-Encoding header value, skipping codings with q=0
+ContentEncoding negotiateEncoding(std::string_view accept_encoding);
+
+const char* encodingName(ContentEncoding encoding);
+
+// Compresses body in the given coding ("deflate" is the zlib format, as HTTP defines it). Uses
+// zlib's fastest level: conversion results are generated text with a lot of repetition, and
+// most of the size comes off at level 1 while costing a fraction of the default level's time.
+// Returns false, leaving out untouched, if zlib fails.
+bool compressBody(std::string_view body, ContentEncoding encoding, std::string& out);
+
+#endif
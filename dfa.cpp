@@ -2,8 +2,10 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <cctype>
 
-DFA::DFA(const std::string& dfa_str) {
+DFA::DFA(const std::string& dfa_str, std::pmr::memory_resource* memory)
+    : Automaton(memory), transitions(memory) {
     std::istringstream iss(dfa_str);
     std::string line;
 
@@ -17,132 +19,245 @@ DFA::DFA(const std::string& dfa_str) {
     parseAcceptStates(line);
     std::getline(iss, line);
     parseTransitions(line);
+    tokenizer.build(alphabet);
+}
+
+DFA::DFA(const SymbolTable& alphabet, std::pmr::memory_resource* memory)
+    : Automaton(memory), transitions(memory) {
+    for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+        this->alphabet.intern(alphabet.name(symbol));
+    }
+    tokenizer.build(this->alphabet);
 }
 
 bool DFA::validate() const {
+    // Start state, accept states and every transition were resolved to ids
+    // while parsing, so all that is left is to check nothing failed to resolve
+    return validateNames();
+}
 
-    // Check if the start state is a valid state
-    if (std::find(states.begin(), states.end(), start_state) == states.end()) {
+bool DFA::accepts(const std::string& input_str) const {
+    std::uint32_t current_state = start_state;
+    if (current_state == NO_STATE) {
         return false;
     }
 
-    // Check if all accept states are valid states
-    for (const std::string& accept_state : accept_states) {
-        if (std::find(states.begin(), states.end(), accept_state) == states.end()) {
-            return false;
-        }
+    // The tokenizer stops on text that does not spell an alphabet symbol
+    bool consumed = tokenizer.forEach(input_str, [&](std::uint32_t symbol_id) {
+        // Get the next state based on the current state and symbol
+        current_state = next(current_state, symbol_id);
+        return current_state != NO_STATE;
+    });
+
+    // Check if the final state is an accept state
+    return consumed && accept_states.contains(current_state);
+}
+
+std::string DFA::toString() const {
+    // Sized up front from the longest names, so large conversion results are built in one allocation
+    std::size_t transition_count = 0;
+    for (std::uint32_t next_state : transitions) {
+        transition_count += next_state != NO_STATE;
     }
+    std::size_t state_width = states.maxNameLength() + 1;
+    std::string text;
+    text.reserve((2 * states.size() + 1) * state_width + alphabet.size() * (alphabet.maxNameLength() + 1) + 4 +
+        transition_count * (2 * state_width + alphabet.maxNameLength() + 2));
 
-    // Check if all transitions are valid
-    for (const auto& state_transitions : transitions) {
-        const std::string& state = state_transitions.first;
-        const auto& symbol_next_state = state_transitions.second;
+    // States, alphabet, start state and accept states, one line each
+    for (std::uint32_t i = 0; i < states.size(); ++i) {
+        if (i > 0) text += ',';
+        text += states.name(i);
+    }
+    text += '\n';
 
-        // Check if the state is a valid state
-        if (std::find(states.begin(), states.end(), state) == states.end()) {
-            return false;
-        }
+    for (std::uint32_t i = 0; i < alphabet.size(); ++i) {
+        if (i > 0) text += ',';
+        text += alphabet.name(i);
+    }
+    text += '\n';
 
-        // Check if all transition symbols are valid alphabet symbols
-        for (const auto& symbol_state : symbol_next_state) {
-            const std::string& symbol = symbol_state.first;
-            const std::string& next_state = symbol_state.second;
+    if (start_state != NO_STATE) {
+        text += states.name(start_state);
+    }
+    text += '\n';
 
-            if (alphabet.find(symbol) == alphabet.end()) {
-                return false;
-            }
+    bool first = true;
+    accept_states.forEach([&](std::uint32_t accept_state) {
+        if (!first) text += ',';
+        text += states.name(accept_state);
+        first = false;
+    });
+    text += '\n';
 
-            // Check if the next state is a valid state
-            if (std::find(states.begin(), states.end(), next_state) == states.end()) {
-                return false;
+    // Then one transition per line
+    for (std::uint32_t state = 0; state < states.size(); ++state) {
+        for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+            std::uint32_t next_state = next(state, symbol);
+            if (next_state != NO_STATE) {
+                text += states.name(state);
+                text += ',';
+                text += alphabet.name(symbol);
+                text += ',';
+                text += states.name(next_state);
+                text += '\n';
             }
         }
     }
 
-    return true;
+    return text;
 }
 
-bool DFA::accepts(const std::string& input_str) const {
-    std::string current_state = start_state;
-
-    for (char symbol : input_str) {
-        std::string symbol_str(1, symbol);
+// Names go into // comments, where a trailing backslash would splice in the next line
+static std::string commentText(std::string_view name) {
+    std::string text(name);
+    std::replace(text.begin(), text.end(), '\\', '/');
+    return text;
+}
 
-        // Check if the symbol is a valid alphabet symbol
-        if (alphabet.find(symbol_str) == alphabet.end()) {
-            return false;
+// Emits nested switches reading the symbols that extend prefix one byte at a time, recording
+// the longest complete symbol seen so far: the greedy longest match SymbolTokenizer makes
+static void emitSymbolSwitch(std::ostringstream& oss, const SymbolTable& alphabet, const std::string& prefix,
+    const std::string& indent) {
+    oss << indent << "if (q != end) switch (static_cast<unsigned char>(*q++)) {\n";
+    std::vector<bool> seen(256, false);
+    for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+        const std::pmr::string& name = alphabet.name(symbol);
+        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        unsigned char c = static_cast<unsigned char>(name[prefix.size()]);
+        if (seen[c]) {
+            continue;
         }
+        seen[c] = true;
 
-        // Get the next state based on the current state and symbol
-        auto state_iter = transitions.find(current_state);
-        if (state_iter != transitions.end()) {
-            auto symbol_iter = state_iter->second.find(symbol_str);
-            if (symbol_iter != state_iter->second.end()) {
-                current_state = symbol_iter->second;
-            }
-            else {
-                return false;
-            }
+        std::string child = prefix + static_cast<char>(c);
+        oss << indent << "case " << static_cast<int>(c) << ":\n";
+        std::uint32_t child_symbol = alphabet.find(child);
+        if (child_symbol != SymbolTable::NO_SYMBOL) {
+            oss << indent << "    best = " << child_symbol << ";\n";
+            oss << indent << "    best_end = q;\n";
+        }
+        bool extended = false;
+        for (std::uint32_t other = 0; other < alphabet.size() && !extended; ++other) {
+            const std::pmr::string& other_name = alphabet.name(other);
+            extended = other_name.size() > child.size() && other_name.compare(0, child.size(), child) == 0;
         }
-        else {
-            return false;
+        if (extended) {
+            emitSymbolSwitch(oss, alphabet, child, indent + "    ");
         }
+        oss << indent << "    break;\n";
     }
-
-    // Check if the final state is an accept state
-    return accept_states.find(current_state) != accept_states.end();
+    oss << indent << "}\n";
 }
 
-std::string DFA::toString() const {
+std::string DFA::toCpp(const std::string& function_name) const {
     std::ostringstream oss;
-
-    // Convert states to string
-    for (size_t i = 0; i < states.size(); ++i) {
-        oss << states[i];
-        if (i < states.size() - 1) {
-            oss << ",";
-        }
+    oss << "// Generated direct-coded matcher: one label per state, one switch per input symbol.\n";
+    oss << "// Equivalent to DFA::accepts for the machine below; regenerate rather than edit.\n";
+    oss << "//\n";
+    oss << "// states: ";
+    for (std::uint32_t i = 0; i < states.size(); ++i) {
+        oss << (i > 0 ? "," : "") << commentText(states.name(i));
+    }
+    oss << "\n// alphabet: ";
+    for (std::uint32_t i = 0; i < alphabet.size(); ++i) {
+        oss << (i > 0 ? "," : "") << commentText(alphabet.name(i));
     }
-    oss << "n";
+    oss << "\n";
+    oss << "#include <string_view>\n\n";
+    oss << "inline bool " << function_name << "(std::string_view input) {\n";
 
-    // Convert alphabet to string
-    for (const std::string& symbol : alphabet) {
-        oss << symbol << ",";
+    if (start_state == NO_STATE) {
+        oss << "    static_cast<void>(input);\n    return false;\n}\n";
+        return oss.str();
     }
-    oss.seekp(-1, std::ios_base::end);
-    oss << "n";
 
-    // Convert start state to string
-    oss << start_state << "n";
+    oss << "    const char* p = input.data();\n";
+    oss << "    const char* const end = p + input.size();\n";
+
+    // With multi-character symbols the input is split the way accepts() splits it, by a
+    // longest-match switch over the alphabet, and the states switch on symbol ids instead
+    bool single_characters = alphabet.maxNameLength() <= 1;
+    if (!single_characters) {
+        oss << "    // Id of the longest alphabet symbol at p, moving p past it; -1 when none matches\n";
+        oss << "    auto next_symbol = [&]() {\n";
+        oss << "        int best = -1;\n";
+        oss << "        const char* best_end = p;\n";
+        oss << "        const char* q = p;\n";
+        emitSymbolSwitch(oss, alphabet, "", "        ");
+        oss << "        p = best_end;\n";
+        oss << "        return best;\n";
+        oss << "    };\n";
+    }
+    oss << "    goto s" << start_state << ";\n";
 
-    // Convert accept states to string
-    for (const std::string& accept_state : accept_states) {
-        oss << accept_state << ",";
+    // Only states reachable from the start get a label, so the output has no dead code
+    std::vector<std::uint32_t> order{ start_state };
+    std::vector<bool> emitted(states.size(), false);
+    emitted[start_state] = true;
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+            std::uint32_t next_state = next(order[i], symbol);
+            if (next_state != NO_STATE && !emitted[next_state]) {
+                emitted[next_state] = true;
+                order.push_back(next_state);
+            }
+        }
     }
-    oss.seekp(-1, std::ios_base::end);
-    oss << "n";
 
-    // Convert transitions to string
-    for (const auto& state_transitions : transitions) {
-        const std::string& state = state_transitions.first;
-        const auto& symbol_next_state = state_transitions.second;
+    for (std::uint32_t state : order) {
+        oss << "s" << state << ": // " << commentText(states.name(state)) << "\n";
+        oss << "    if (p == end) return " << (accept_states.contains(state) ? "true" : "false") << ";\n";
+        oss << (single_characters ? "    switch (static_cast<unsigned char>(*p++)) {\n" : "    switch (next_symbol()) {\n");
 
-        for (const auto& symbol_state : symbol_next_state) {
-            const std::string& symbol = symbol_state.first;
-            const std::string& next_state = symbol_state.second;
+        for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+            std::uint32_t next_state = next(state, symbol);
+            if (next_state == NO_STATE) {
+                continue;
+            }
 
-            oss << state << "," << symbol << "," << next_state << "n";
+            const std::pmr::string& name = alphabet.name(symbol);
+            if (single_characters) {
+                unsigned char c = static_cast<unsigned char>(name[0]);
+                oss << "    case " << static_cast<int>(c) << ":";
+                if (std::isalnum(c)) {
+                    oss << " // '" << name << "'";
+                }
+            }
+            else {
+                oss << "    case " << symbol << ": // " << commentText(name);
+            }
+            oss << "\n        goto s" << next_state << ";\n";
         }
+        oss << "    default:\n        return false;\n    }\n";
     }
 
+    oss << "}\n";
     return oss.str();
 }
 
+std::uint32_t DFA::addState(std::string_view name, bool accepting) {
+    if (states.find(name) != NO_STATE) {
+        return NO_STATE;
+    }
+    std::uint32_t state = states.intern(name);
+    transitions.resize(states.size() * alphabet.size(), NO_STATE);
+    accept_states.resize(states.size());
+    if (accepting) {
+        accept_states.insert(state);
+    }
+    return state;
+}
+
 void DFA::parseTransitions(const std::string& transitions_str) {
     std::istringstream iss(transitions_str);
     std::string state, symbol, next_state, blank;
     std::string prev_state, prev_symbol, prev_next_state;
 
+    transitions.assign(states.size() * alphabet.size(), NO_STATE);
+
     for (int i = 0; i < 4; i++)
         while (std::getline(iss, blank, ',')) {
             if (blank == "\\n") break;
@@ -160,6 +275,14 @@ void DFA::parseTransitions(const std::string& transitions_str) {
         prev_symbol = symbol;
         prev_next_state = next_state;
 
-        transitions[state][symbol] = next_state;
+        std::uint32_t state_id = states.find(state);
+        std::uint32_t symbol_id = alphabet.find(symbol);
+        std::uint32_t next_state_id = states.find(next_state);
+        if (state_id == NO_STATE || symbol_id == SymbolTable::NO_SYMBOL || next_state_id == NO_STATE) {
+            has_unknown_names = true;
+            continue;
+        }
+
+        transitions[state_id * alphabet.size() + symbol_id] = next_state_id;
     }
-}
\ No newline at end of file
+}
@@ -2,19 +2,48 @@
 #define DFA_HPP
 
 #include "automaton.hpp"
-#include <unordered_map>
+#include <string_view>
 
 class DFA : public Automaton {
 public:
-    DFA(const std::string& dfa_str);
+    DFA(const std::string& dfa_str, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    // Starts an empty machine over the given alphabet, to be filled in with the builder calls below
+    DFA(const SymbolTable& alphabet, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
     bool validate() const override;
     bool accepts(const std::string& input_str) const override;
     std::string toString() const override;
+    // Self-contained C++ source for a bool function_name(std::string_view) with the same
+    // behaviour as accepts(), direct-coded as labels and gotos with no table lookups. Multi-
+    // character alphabets get an inlined longest-match switch that splits the input first.
+    std::string toCpp(const std::string& function_name = "matches") const;
+
+    // Id of the new state, or NO_STATE, with nothing changed, when the name is already taken
+    std::uint32_t addState(std::string_view name, bool accepting);
+    void setStartState(std::uint32_t state) { start_state = state; }
+    void setTransition(std::uint32_t state, std::uint32_t symbol, std::uint32_t next_state) {
+        transitions[state * alphabet.size() + symbol] = next_state;
+    }
+
+    // Read access to the compiled table for the engines built on top of it
+    std::uint32_t stateCount() const { return states.size(); }
+    std::uint32_t symbolCount() const { return alphabet.size(); }
+    std::uint32_t startState() const { return start_state; }
+    std::uint32_t next(std::uint32_t state, std::uint32_t symbol) const {
+        return transitions[state * alphabet.size() + symbol];
+    }
+    bool isAccepting(std::uint32_t state) const { return accept_states.contains(state); }
+    const std::pmr::string& stateName(std::uint32_t state) const { return states.name(state); }
+    const std::pmr::string& symbolName(std::uint32_t symbol) const { return alphabet.name(symbol); }
+    std::uint32_t stateId(std::string_view state) const { return states.find(state); }
+    std::uint32_t symbolId(std::string_view symbol) const { return alphabet.find(symbol); }
+    const SymbolTable& symbols() const { return alphabet; }
 
 private:
-    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> transitions;
+    // Row-major |Q| x |Σ| table of next-state ids; NO_STATE where no transition is defined
+    std::pmr::vector<std::uint32_t> transitions;
 
     void parseTransitions(const std::string& transitions_str);
 };
 
-#endif
\ No newline at end of file
+#endif
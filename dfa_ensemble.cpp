@@ -0,0 +1,90 @@
+#include "dfa_ensemble.hpp"
+#include "budget.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+DFAEnsemble::DFAEnsemble(const std::vector<const DFA*>& machines, std::pmr::memory_resource* memory)
+    : machine_count(machines.size()), column_count(1), table(memory), accepting_rows(memory), starts(memory),
+    machine_ids(memory) {
+    std::fill(std::begin(columns), std::end(columns), 0);
+
+    // Union alphabet over the single-character machines, one column per distinct byte
+    std::uint64_t rows = 1;
+    for (std::uint32_t id = 0; id < machines.size(); ++id) {
+        const DFA& dfa = *machines[id];
+        if (dfa.symbols().maxNameLength() > 1) {
+            tokenized.emplace_back(id, &dfa);
+            continue;
+        }
+        machine_ids.push_back(id);
+        rows += dfa.stateCount();
+        for (std::uint32_t symbol = 0; symbol < dfa.symbolCount(); ++symbol) {
+            unsigned char byte = static_cast<unsigned char>(dfa.symbolName(symbol)[0]);
+            if (columns[byte] == 0) {
+                columns[byte] = column_count++;
+            }
+        }
+    }
+    if (rows * column_count > 0xffffffffull) {
+        throw std::length_error("DFA ensemble table too large");
+    }
+    ResourceBudget::chargeStates(rows);
+
+    table.assign(rows * column_count, 0);
+    accepting_rows.assign(rows, 0);
+    starts.reserve(machine_ids.size());
+    std::uint32_t base = 1;
+    for (std::uint32_t id : machine_ids) {
+        const DFA& dfa = *machines[id];
+        for (std::uint32_t state = 0; state < dfa.stateCount(); ++state) {
+            std::uint32_t* row = table.data() + std::size_t(base + state) * column_count;
+            for (std::uint32_t symbol = 0; symbol < dfa.symbolCount(); ++symbol) {
+                std::uint32_t next = dfa.next(state, symbol);
+                if (next != DFA::NO_STATE) {
+                    row[columns[static_cast<unsigned char>(dfa.symbolName(symbol)[0])]] = (base + next) * column_count;
+                }
+            }
+            accepting_rows[base + state] = dfa.isAccepting(state);
+        }
+        starts.push_back(dfa.startState() == DFA::NO_STATE ? 0 : (base + dfa.startState()) * column_count);
+        base += dfa.stateCount();
+    }
+}
+
+std::vector<std::uint64_t> DFAEnsemble::accepts(std::string_view input) const {
+    std::vector<std::uint64_t> bitmap((machine_count + 63) / 64, 0);
+
+    std::vector<std::uint32_t> current(starts.begin(), starts.end());
+    std::uint32_t* state = current.data();
+    const std::uint32_t* next = table.data();
+    std::size_t count = current.size();
+    for (std::size_t pos = 0; pos < input.size() && count > 0; ++pos) {
+        std::uint32_t column = columns[static_cast<unsigned char>(input[pos])];
+        if (column == 0) {
+            // No machine declares this byte, so every one of them rejects
+            std::fill(current.begin(), current.end(), 0);
+            break;
+        }
+        // Independent lanes and no branches, so the compiler can vectorize this into gathers
+        for (std::size_t i = 0; i < count; ++i) {
+            state[i] = next[state[i] + column];
+        }
+        if ((pos & 63) == 63 && std::all_of(current.begin(), current.end(), [](std::uint32_t s) { return s == 0; })) {
+            break;
+        }
+        ResourceBudget::checkpoint();
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        if (accepting_rows[state[i] / column_count]) {
+            bitmap[machine_ids[i] / 64] |= std::uint64_t(1) << (machine_ids[i] % 64);
+        }
+    }
+    std::string text(input);
+    for (const auto& [id, dfa] : tokenized) {
+        if (dfa->accepts(text)) {
+            bitmap[id / 64] |= std::uint64_t(1) << (id % 64);
+        }
+    }
+    return bitmap;
+}
@@ -0,0 +1,49 @@
+#ifndef DFA_ENSEMBLE_HPP
+#define DFA_ENSEMBLE_HPP
+
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+#include "dfa.hpp"
+
+// Many DFAs run over one input at once, for grading a string against every submission to an
+// exercise. Machines whose alphabets are single characters are compiled into one shared table:
+// each input byte is decoded once to a column of the union alphabet, and the current states
+// of all machines sit in one contiguous array of row offsets that every byte advances with a
+// single branch-free gather. A shared dead row (row 0) takes missing transitions and symbols a
+// machine does not declare, so each machine accepts exactly what DFA::accepts does.
+//
+// Machines with multi-character symbols would each split the input differently; they are run
+// one at a time through DFA::accepts, so the ensemble refers to them and must not outlive them.
+class DFAEnsemble {
+public:
+    DFAEnsemble(const std::vector<const DFA*>& machines,
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    std::size_t size() const { return machine_count; }
+
+    // Bit i % 64 of word i / 64 is set when machine i accepts input
+    std::vector<std::uint64_t> accepts(std::string_view input) const;
+    static bool test(const std::vector<std::uint64_t>& bitmap, std::size_t machine) {
+        return (bitmap[machine / 64] >> (machine % 64)) & 1;
+    }
+
+private:
+    std::size_t machine_count;
+    // Union-alphabet column of each byte; column 0 is for bytes no machine declares
+    std::uint32_t columns[256];
+    std::uint32_t column_count;
+    // Rows of every machine's states after the dead row; entries are the offset
+    // (row * column_count) of the next row, so a step is one load
+    std::pmr::vector<std::uint32_t> table;
+    std::pmr::vector<std::uint8_t> accepting_rows;
+    // Start row offset and machine index of each machine in the table
+    std::pmr::vector<std::uint32_t> starts;
+    std::pmr::vector<std::uint32_t> machine_ids;
+    std::vector<std::pair<std::uint32_t, const DFA*>> tokenized;
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "dfa_language.hpp"
+#include "budget.hpp"
+#include "symbol_tokenizer.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    void requireUniqueSplitting(const DFA& dfa) {
+        if (!SymbolTokenizer::splitsUniquely(dfa.symbols())) {
+            throw std::invalid_argument("alphabet symbols do not split back uniquely by longest match");
+        }
+    }
+}
+
+BigUnsigned countAccepted(const DFA& dfa, std::uint64_t length) {
+    requireUniqueSplitting(dfa);
+    const std::uint32_t state_count = dfa.stateCount();
+    const std::uint32_t symbol_count = dfa.symbolCount();
+    if (dfa.startState() == DFA::NO_STATE) {
+        return BigUnsigned(0);
+    }
+
+    if (length <= std::uint64_t(64) * state_count) {
+        // ways[q] = number of accepted strings of the current length starting from q
+        std::vector<BigUnsigned> ways(state_count);
+        for (std::uint32_t state = 0; state < state_count; ++state) {
+            ways[state] = BigUnsigned(dfa.isAccepting(state) ? 1 : 0);
+        }
+
+        for (std::uint64_t step = 0; step < length; ++step) {
+            ResourceBudget::checkpoint();
+            std::vector<BigUnsigned> next_ways(state_count);
+            for (std::uint32_t state = 0; state < state_count; ++state) {
+                for (std::uint32_t symbol = 0; symbol < symbol_count; ++symbol) {
+                    std::uint32_t next_state = dfa.next(state, symbol);
+                    if (next_state != DFA::NO_STATE) {
+                        next_ways[state] += ways[next_state];
+                    }
+                }
+            }
+            ways.swap(next_ways);
+        }
+
+        return ways[dfa.startState()];
+    }
+
+    // matrix[q * n + p] = number of symbols leading from q to p
+    std::vector<BigUnsigned> matrix(state_count * state_count);
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        for (std::uint32_t symbol = 0; symbol < symbol_count; ++symbol) {
+            std::uint32_t next_state = dfa.next(state, symbol);
+            if (next_state != DFA::NO_STATE) {
+                matrix[state * state_count + next_state] += BigUnsigned(1);
+            }
+        }
+    }
+
+    // Row vector e_start * matrix^length, by repeated squaring
+    std::vector<BigUnsigned> row(state_count);
+    row[dfa.startState()] = BigUnsigned(1);
+
+    while (length > 0) {
+        if (length & 1) {
+            std::vector<BigUnsigned> next_row(state_count);
+            for (std::uint32_t from = 0; from < state_count; ++from) {
+                if (row[from].isZero()) continue;
+                for (std::uint32_t to = 0; to < state_count; ++to) {
+                    if (!matrix[from * state_count + to].isZero()) {
+                        next_row[to] += row[from] * matrix[from * state_count + to];
+                    }
+                }
+            }
+            row.swap(next_row);
+        }
+
+        length >>= 1;
+        if (length > 0) {
+            std::vector<BigUnsigned> squared(state_count * state_count);
+            for (std::uint32_t i = 0; i < state_count; ++i) {
+                ResourceBudget::checkpoint();
+                for (std::uint32_t k = 0; k < state_count; ++k) {
+                    const BigUnsigned& left = matrix[i * state_count + k];
+                    if (left.isZero()) continue;
+                    for (std::uint32_t j = 0; j < state_count; ++j) {
+                        if (!matrix[k * state_count + j].isZero()) {
+                            squared[i * state_count + j] += left * matrix[k * state_count + j];
+                        }
+                    }
+                }
+            }
+            matrix.swap(squared);
+        }
+    }
+
+    BigUnsigned total;
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        if (dfa.isAccepting(state)) {
+            total += row[state];
+        }
+    }
+    return total;
+}
+
+ShortlexEnumerator::ShortlexEnumerator(const DFA& dfa)
+    : dfa(dfa), length(0), empty_lengths(0), started(false), finished(false) {
+    requireUniqueSplitting(dfa);
+    for (std::uint32_t symbol = 0; symbol < dfa.symbolCount(); ++symbol) {
+        symbol_order.push_back(symbol);
+    }
+    std::sort(symbol_order.begin(), symbol_order.end(), [&dfa](std::uint32_t a, std::uint32_t b) {
+        return dfa.symbolName(a) < dfa.symbolName(b);
+    });
+
+    if (dfa.startState() == DFA::NO_STATE) {
+        finished = true;
+    }
+}
+
+bool ShortlexEnumerator::next(std::string& word) {
+    if (finished) {
+        return false;
+    }
+
+    bool found = started ? advance() : startLength();
+    started = true;
+    if (!found) {
+        finished = true;
+        return false;
+    }
+
+    word.clear();
+    for (std::uint32_t choice : path_choices) {
+        word += dfa.symbolName(symbol_order[choice]);
+    }
+    return true;
+}
+
+void ShortlexEnumerator::extendReach(std::uint32_t steps) {
+    while (reach.size() <= steps) {
+        StateSet states(dfa.stateCount());
+        if (reach.empty()) {
+            for (std::uint32_t state = 0; state < dfa.stateCount(); ++state) {
+                if (dfa.isAccepting(state)) states.insert(state);
+            }
+        }
+        else {
+            const StateSet& previous = reach.back();
+            for (std::uint32_t state = 0; state < dfa.stateCount(); ++state) {
+                for (std::uint32_t symbol = 0; symbol < dfa.symbolCount(); ++symbol) {
+                    std::uint32_t next_state = dfa.next(state, symbol);
+                    if (next_state != DFA::NO_STATE && previous.contains(next_state)) {
+                        states.insert(state);
+                        break;
+                    }
+                }
+            }
+        }
+        reach.push_back(states);
+    }
+}
+
+bool ShortlexEnumerator::startLength() {
+    const std::uint32_t state_count = dfa.stateCount();
+
+    while (true) {
+        ResourceBudget::checkpoint();
+        extendReach(length);
+        if (reach[length].contains(dfa.startState())) {
+            empty_lengths = 0;
+            path_states.assign(1, dfa.startState());
+            path_choices.clear();
+
+            // Take the smallest symbol at every step that can still finish in time
+            for (std::uint32_t depth = 0; depth < length; ++depth) {
+                for (std::uint32_t choice = 0; choice < symbol_order.size(); ++choice) {
+                    std::uint32_t next_state = dfa.next(path_states[depth], symbol_order[choice]);
+                    if (next_state != DFA::NO_STATE && reach[length - depth - 1].contains(next_state)) {
+                        path_choices.push_back(choice);
+                        path_states.push_back(next_state);
+                        break;
+                    }
+                }
+            }
+            return true;
+        }
+
+        // An accepted string of length >= |Q| implies a shorter one at most |Q| symbols
+        // shorter, so |Q| empty lengths in a row past |Q| means the language is exhausted
+        ++empty_lengths;
+        if (length >= state_count && empty_lengths >= state_count) {
+            return false;
+        }
+        ++length;
+    }
+}
+
+bool ShortlexEnumerator::advance() {
+    // Find the deepest position whose choice can be bumped to a later symbol
+    for (std::uint32_t depth = length; depth-- > 0;) {
+        for (std::uint32_t choice = path_choices[depth] + 1; choice < symbol_order.size(); ++choice) {
+            std::uint32_t next_state = dfa.next(path_states[depth], symbol_order[choice]);
+            if (next_state == DFA::NO_STATE || !reach[length - depth - 1].contains(next_state)) {
+                continue;
+            }
+
+            path_choices.resize(depth);
+            path_states.resize(depth + 1);
+            path_choices.push_back(choice);
+            path_states.push_back(next_state);
+
+            // Complete the suffix with the smallest choices again
+            for (std::uint32_t rest = depth + 1; rest < length; ++rest) {
+                for (std::uint32_t first = 0; first < symbol_order.size(); ++first) {
+                    std::uint32_t state = dfa.next(path_states[rest], symbol_order[first]);
+                    if (state != DFA::NO_STATE && reach[length - rest - 1].contains(state)) {
+                        path_choices.push_back(first);
+                        path_states.push_back(state);
+                        break;
+                    }
+                }
+            }
+            return true;
+        }
+    }
+
+    ++length;
+    return startLength();
+}
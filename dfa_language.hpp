@@ -0,0 +1,47 @@
+#ifndef DFA_LANGUAGE_HPP
+#define DFA_LANGUAGE_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "dfa.hpp"
+#include "big_unsigned.hpp"
+
+// Both work on symbol sequences, so lengths count symbols, not characters. That matches what
+// DFA::accepts reads only when longest match splits every sequence back into itself
+// (SymbolTokenizer::splitsUniquely); for other alphabets they throw std::invalid_argument.
+
+// Number of strings of exactly the given length the DFA accepts. Short lengths
+// use dynamic programming over the transition table; long ones switch to
+// repeated squaring of the transition count matrix.
+BigUnsigned countAccepted(const DFA& dfa, std::uint64_t length);
+
+// Lazily lists the accepted strings in shortlex order (by length, then by symbol
+// name), without materializing the language. Stops once the language is exhausted.
+class ShortlexEnumerator {
+public:
+    explicit ShortlexEnumerator(const DFA& dfa);
+
+    // Writes the next accepted string to word; returns false when there are no more
+    bool next(std::string& word);
+
+private:
+    const DFA& dfa;
+    std::vector<std::uint32_t> symbol_order;
+    // reach[r] holds the states that can reach an accept state in exactly r steps
+    std::vector<StateSet> reach;
+    std::uint32_t length;
+    std::uint32_t empty_lengths;
+    bool started;
+    bool finished;
+
+    // Current path of the depth-first walk for the current length
+    std::vector<std::uint32_t> path_states;
+    std::vector<std::uint32_t> path_choices;
+
+    void extendReach(std::uint32_t steps);
+    bool startLength();
+    bool advance();
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "earley.hpp"
+#include "budget.hpp"
+
+EarleyRecognizer::EarleyRecognizer(const GrammarRules& rules, const FirstFollow& sets)
+    : rules(rules), sets(sets), rules_by_variable(rules.variable_count) {
+    for (std::uint32_t rule = 0; rule < rules.size(); ++rule) {
+        rules_by_variable[rules.lhs[rule]].push_back(rule);
+    }
+}
+
+bool EarleyRecognizer::recognize(const std::vector<std::uint32_t>& tokens) const {
+    if (rules.start_variable >= rules.variable_count) {
+        return false;
+    }
+
+    EarleyChart chart;
+    buildChart(tokens, chart);
+    for (const EarleyItem& item : chart.items[tokens.size()]) {
+        if (item.origin == 0 && rules.lhs[item.rule] == rules.start_variable
+            && item.dot == rules.rhs[item.rule].size()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void EarleyRecognizer::buildChart(const std::vector<std::uint32_t>& tokens, EarleyChart& result) const {
+    result.items.assign(tokens.size() + 1, {});
+    result.seen.assign(tokens.size() + 1, {});
+    if (rules.start_variable >= rules.variable_count) {
+        return;
+    }
+    std::vector<std::vector<EarleyItem>>& chart = result.items;
+
+    auto add = [&](size_t position, const EarleyItem& item) {
+        if (result.seen[position].insert(EarleyChart::key(item.rule, item.dot, item.origin)).second) {
+            chart[position].push_back(item);
+        }
+    };
+
+    for (std::uint32_t rule : rules_by_variable[rules.start_variable]) {
+        add(0, EarleyItem{ rule, 0, 0 });
+    }
+
+    for (size_t position = 0; position <= tokens.size(); ++position) {
+        // chart[position] grows while it is processed
+        for (size_t i = 0; i < chart[position].size(); ++i) {
+            ResourceBudget::checkpoint();
+            EarleyItem item = chart[position][i];
+            const std::vector<std::uint32_t>& symbols = rules.rhs[item.rule];
+
+            if (item.dot == symbols.size()) {
+                // Complete: advance every item that was waiting on this variable
+                std::uint32_t variable = rules.lhs[item.rule];
+                for (size_t j = 0; j < chart[item.origin].size(); ++j) {
+                    EarleyItem waiting = chart[item.origin][j];
+                    const std::vector<std::uint32_t>& waiting_symbols = rules.rhs[waiting.rule];
+                    if (waiting.dot < waiting_symbols.size() && waiting_symbols[waiting.dot] == variable) {
+                        add(position, EarleyItem{ waiting.rule, waiting.dot + 1, waiting.origin });
+                    }
+                }
+            }
+            else if (Grammar::isTerminalSymbol(symbols[item.dot])) {
+                // Scan
+                if (position < tokens.size() && Grammar::terminalId(symbols[item.dot]) == tokens[position]) {
+                    add(position + 1, EarleyItem{ item.rule, item.dot + 1, item.origin });
+                }
+            }
+            else {
+                // Predict, stepping over the variable straight away when it is nullable
+                std::uint32_t variable = symbols[item.dot];
+                for (std::uint32_t rule : rules_by_variable[variable]) {
+                    add(position, EarleyItem{ rule, 0, static_cast<std::uint32_t>(position) });
+                }
+                if (sets.isNullable(variable)) {
+                    add(position, EarleyItem{ item.rule, item.dot + 1, item.origin });
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#ifndef EARLEY_HPP
+#define EARLEY_HPP
+
+#include <vector>
+#include <cstdint>
+#include <unordered_set>
+#include "parse_tables.hpp"
+
+// An Earley item: production, dot position and the input position it started at
+struct EarleyItem {
+    std::uint32_t rule;
+    std::uint32_t dot;
+    std::uint32_t origin;
+};
+
+// Item sets by input position, each with a hash set for membership tests
+struct EarleyChart {
+    std::vector<std::vector<EarleyItem>> items;
+    std::vector<std::unordered_set<std::uint64_t>> seen;
+
+    static std::uint64_t key(std::uint32_t rule, std::uint32_t dot, std::uint32_t origin) {
+        return (std::uint64_t(rule) << 40) ^ (std::uint64_t(dot) << 32) ^ origin;
+    }
+    bool contains(std::size_t position, std::uint32_t rule, std::uint32_t dot, std::uint32_t origin) const {
+        return seen[position].count(key(rule, dot, origin)) != 0;
+    }
+};
+
+// General context-free recognizer for grammars that are neither LL(1) nor LALR(1).
+// Uses the Aycock-Horspool nullable fix so epsilon rules need no special pass.
+class EarleyRecognizer {
+public:
+    EarleyRecognizer(const GrammarRules& rules, const FirstFollow& sets);
+
+    bool recognize(const std::vector<std::uint32_t>& tokens) const;
+    // Fills chart with every item for tokens, for callers that need more than a yes or no
+    void buildChart(const std::vector<std::uint32_t>& tokens, EarleyChart& chart) const;
+
+    const GrammarRules& grammarRules() const { return rules; }
+    const std::vector<std::uint32_t>& rulesOf(std::uint32_t variable) const { return rules_by_variable[variable]; }
+
+private:
+    const GrammarRules& rules;
+    const FirstFollow& sets;
+    std::vector<std::vector<std::uint32_t>> rules_by_variable;
+};
+
+#endif
@@ -0,0 +1,395 @@
+#include "edit_session.hpp"
+#include "budget.hpp"
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <iomanip>
+
+EditSession::EditSession(Kind kind, const std::string& definition)
+    : session_kind(kind), edits(0), has_unknown_names(false), start_state(DFA::NO_STATE),
+    capacity(64), recomputed_rows(0) {
+    auto copyMachine = [this](const auto& machine, auto&& targetsOf) {
+        for (std::uint32_t symbol = 0; symbol < machine.symbolCount(); ++symbol) {
+            alphabet.intern(machine.symbolName(symbol));
+        }
+        for (std::uint32_t state = 0; state < machine.stateCount(); ++state) {
+            addState(machine.stateName(state));
+            accepting[state] = machine.isAccepting(state);
+        }
+        for (std::uint32_t state = 0; state < machine.stateCount(); ++state) {
+            for (std::uint32_t symbol = 0; symbol < width(); ++symbol) {
+                targetsOf(state, symbol, successors(state, symbol));
+            }
+        }
+        start_state = machine.startState();
+        has_unknown_names = machine.hasUnknownNames();
+    };
+
+    if (kind == Kind::DFA) {
+        DFA dfa(definition);
+        copyMachine(dfa, [&dfa](std::uint32_t state, std::uint32_t symbol, std::vector<std::uint32_t>& targets) {
+            if (symbol < dfa.symbolCount() && dfa.next(state, symbol) != DFA::NO_STATE) {
+                targets.push_back(dfa.next(state, symbol));
+            }
+        });
+    }
+    else {
+        NFA nfa(definition);
+        copyMachine(nfa, [&nfa](std::uint32_t state, std::uint32_t symbol, std::vector<std::uint32_t>& targets) {
+            targets.assign(nfa.successors(state, symbol).begin(), nfa.successors(state, symbol).end());
+            std::sort(targets.begin(), targets.end());
+        });
+    }
+}
+
+bool EditSession::apply(const EditOperation& operation, std::string& error) {
+    auto findState = [this](const std::string& name) {
+        std::uint32_t state = states.find(name);
+        return state != SymbolTable::NO_SYMBOL && !removed[state] ? state : DFA::NO_STATE;
+    };
+
+    if (operation.op == "add_state") {
+        if (operation.state.empty() || addState(operation.state) == DFA::NO_STATE) {
+            error = "state already exists or has no name";
+            return false;
+        }
+        ++edits;
+        return true;
+    }
+
+    std::uint32_t state = findState(operation.state);
+    if (state == DFA::NO_STATE) {
+        error = "unknown state";
+        return false;
+    }
+
+    if (operation.op == "remove_state") {
+        removeState(state);
+    }
+    else if (operation.op == "toggle_accept") {
+        // Acceptance is read when compiling, so no cached closure or row depends on it
+        accepting[state] = !accepting[state];
+    }
+    else if (operation.op == "set_start") {
+        start_state = state;
+    }
+    else if (operation.op == "add_transition" || operation.op == "remove_transition") {
+        std::uint32_t target = findState(operation.target);
+        bool is_epsilon = operation.symbol == "e" || operation.symbol.empty();
+        std::uint32_t symbol = is_epsilon ? epsilon() : alphabet.find(operation.symbol);
+        if (target == DFA::NO_STATE || symbol == SymbolTable::NO_SYMBOL) {
+            error = "unknown state or symbol";
+            return false;
+        }
+        if (is_epsilon && session_kind == Kind::DFA) {
+            error = "a DFA cannot have epsilon transitions";
+            return false;
+        }
+
+        bool changed = operation.op == "add_transition" ? addEdge(state, symbol, target) : removeEdge(state, symbol, target);
+        if (!changed && operation.op == "remove_transition") {
+            error = "no such transition";
+            return false;
+        }
+    }
+    else {
+        error = "unknown operation";
+        return false;
+    }
+
+    ++edits;
+    return true;
+}
+
+bool EditSession::validate() const {
+    return start_state != DFA::NO_STATE && !removed[start_state] && !has_unknown_names;
+}
+
+DFA EditSession::compiled() {
+    DFA dfa(alphabet);
+    recomputed_rows = 0;
+
+    if (session_kind == Kind::DFA) {
+        // The table is already deterministic; only removed states have to be skipped
+        std::vector<std::uint32_t> ids(states.size(), DFA::NO_STATE);
+        for (std::uint32_t state = 0; state < states.size(); ++state) {
+            if (!removed[state]) {
+                ids[state] = dfa.addState(states.name(state), accepting[state]);
+            }
+        }
+        if (start_state != DFA::NO_STATE) {
+            dfa.setStartState(ids[start_state]);
+        }
+        for (std::uint32_t state = 0; state < states.size(); ++state) {
+            for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+                if (!removed[state] && !successors(state, symbol).empty()) {
+                    dfa.setTransition(ids[state], symbol, ids[successors(state, symbol).front()]);
+                }
+            }
+        }
+        return dfa;
+    }
+
+    if (start_state == DFA::NO_STATE) {
+        rows.clear();
+        return dfa;
+    }
+
+    StateSet accept_states(capacity);
+    for (std::uint32_t state = 0; state < states.size(); ++state) {
+        if (accepting[state]) accept_states.insert(state);
+    }
+
+    // Subset construction over cached rows; only rows an edit invalidated are recomputed
+    std::unordered_map<StateSet, std::uint32_t, StateSet::Hash> ids;
+    std::vector<StateSet> subsets;
+    auto addSubset = [&](const StateSet& subset) {
+        std::string name = setToString(subset, states);
+        std::uint32_t id = dfa.stateCount();
+        while (dfa.addState(name, subset.intersects(accept_states)) != id) {
+            name += "'";
+        }
+        ResourceBudget::chargeStates();
+        subsets.push_back(subset);
+        ids.emplace(subset, id);
+        return id;
+    };
+
+    dfa.setStartState(addSubset(closure(start_state)));
+    for (std::uint32_t current = 0; current < subsets.size(); ++current) {
+        StateSet subset = subsets[current];
+        const std::vector<StateSet>& next_subsets = row(subset);
+
+        for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+            const StateSet& next_states = next_subsets[symbol];
+            if (next_states.empty()) {
+                continue;
+            }
+            auto it = ids.find(next_states);
+            dfa.setTransition(current, symbol, it != ids.end() ? it->second : addSubset(next_states));
+        }
+    }
+
+    // Keep only the rows of the current machine so the cache does not grow with every edit
+    for (auto it = rows.begin(); it != rows.end();) {
+        it = ids.count(it->first) ? std::next(it) : rows.erase(it);
+    }
+    return dfa;
+}
+
+std::uint32_t EditSession::addState(std::string_view name) {
+    std::uint32_t state = states.find(name);
+    if (state != SymbolTable::NO_SYMBOL) {
+        if (!removed[state]) {
+            return DFA::NO_STATE;
+        }
+        // Names cannot be uninterned, so re-adding a removed state revives its id without edges
+        removed[state] = false;
+        accepting[state] = false;
+        return state;
+    }
+
+    state = states.intern(name);
+    removed.push_back(false);
+    accepting.push_back(false);
+    out.resize(std::size_t(states.size()) * width());
+
+    if (states.size() > capacity) {
+        // Every cached set has the old universe, so they all go
+        capacity *= 2;
+        closures.assign(states.size(), StateSet(capacity));
+        closure_valid.assign(states.size(), false);
+        rows.clear();
+    }
+    else {
+        closures.emplace_back(capacity);
+        closure_valid.push_back(false);
+    }
+    return state;
+}
+
+bool EditSession::addEdge(std::uint32_t state, std::uint32_t symbol, std::uint32_t target) {
+    std::vector<std::uint32_t>& targets = successors(state, symbol);
+    if (session_kind == Kind::DFA) {
+        if (targets.size() == 1 && targets.front() == target) return false;
+        targets.assign(1, target);
+    }
+    else {
+        auto it = std::lower_bound(targets.begin(), targets.end(), target);
+        if (it != targets.end() && *it == target) return false;
+        targets.insert(it, target);
+    }
+    invalidateFrom(state, symbol);
+    return true;
+}
+
+bool EditSession::removeEdge(std::uint32_t state, std::uint32_t symbol, std::uint32_t target) {
+    std::vector<std::uint32_t>& targets = successors(state, symbol);
+    auto it = std::find(targets.begin(), targets.end(), target);
+    if (it == targets.end()) {
+        return false;
+    }
+    targets.erase(it);
+    invalidateFrom(state, symbol);
+    return true;
+}
+
+void EditSession::removeState(std::uint32_t removed_state) {
+    for (std::uint32_t state = 0; state < states.size(); ++state) {
+        for (std::uint32_t symbol = 0; symbol < width(); ++symbol) {
+            std::vector<std::uint32_t>& targets = successors(state, symbol);
+            if (state == removed_state ? !targets.empty()
+                : std::find(targets.begin(), targets.end(), removed_state) != targets.end()) {
+                if (state == removed_state) {
+                    targets.clear();
+                }
+                else {
+                    targets.erase(std::find(targets.begin(), targets.end(), removed_state));
+                }
+                invalidateFrom(state, symbol);
+            }
+        }
+    }
+
+    removed[removed_state] = true;
+    accepting[removed_state] = false;
+    closure_valid[removed_state] = false;
+    if (start_state == removed_state) {
+        start_state = DFA::NO_STATE;
+    }
+}
+
+void EditSession::invalidateFrom(std::uint32_t state, std::uint32_t symbol) {
+    if (session_kind == Kind::DFA) {
+        return;
+    }
+
+    StateSet changed(capacity);
+    if (symbol != epsilon()) {
+        // Only subsets containing the edited state read this edge
+        changed.insert(state);
+        invalidateRows(changed);
+        return;
+    }
+
+    // An epsilon edge out of state changes the closure of every state that reaches it by epsilon
+    StateSet reaching(capacity);
+    std::vector<std::uint32_t> stack{ state };
+    reaching.insert(state);
+    while (!stack.empty()) {
+        std::uint32_t current = stack.back();
+        stack.pop_back();
+        closure_valid[current] = false;
+        for (std::uint32_t source = 0; source < states.size(); ++source) {
+            const std::vector<std::uint32_t>& targets = successors(source, epsilon());
+            if (!reaching.contains(source) && std::binary_search(targets.begin(), targets.end(), current)) {
+                reaching.insert(source);
+                stack.push_back(source);
+            }
+        }
+    }
+
+    // Rows close the targets of symbol edges, so the states with an edge into the changed closures are affected
+    for (std::uint32_t source = 0; source < states.size(); ++source) {
+        for (std::uint32_t edge_symbol = 0; edge_symbol < alphabet.size() && !changed.contains(source); ++edge_symbol) {
+            for (std::uint32_t target : successors(source, edge_symbol)) {
+                if (reaching.contains(target)) {
+                    changed.insert(source);
+                    break;
+                }
+            }
+        }
+    }
+    invalidateRows(changed);
+}
+
+void EditSession::invalidateRows(const StateSet& changed) {
+    for (auto it = rows.begin(); it != rows.end();) {
+        it = it->first.intersects(changed) ? rows.erase(it) : std::next(it);
+    }
+}
+
+const StateSet& EditSession::closure(std::uint32_t state) {
+    if (closure_valid[state]) {
+        return closures[state];
+    }
+
+    StateSet& result = closures[state];
+    result.clear();
+    result.insert(state);
+    std::vector<std::uint32_t> stack{ state };
+    while (!stack.empty()) {
+        ResourceBudget::checkpoint();
+        std::uint32_t current = stack.back();
+        stack.pop_back();
+        for (std::uint32_t target : successors(current, epsilon())) {
+            if (!result.contains(target)) {
+                result.insert(target);
+                stack.push_back(target);
+            }
+        }
+    }
+
+    closure_valid[state] = true;
+    return result;
+}
+
+const std::vector<StateSet>& EditSession::row(const StateSet& subset) {
+    auto it = rows.find(subset);
+    if (it != rows.end()) {
+        return it->second;
+    }
+
+    std::vector<StateSet> next_subsets(alphabet.size(), StateSet(capacity));
+    subset.forEach([&](std::uint32_t state) {
+        for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+            for (std::uint32_t target : successors(state, symbol)) {
+                next_subsets[symbol] |= closure(target);
+            }
+        }
+    });
+
+    ++recomputed_rows;
+    return rows.emplace(subset, std::move(next_subsets)).first->second;
+}
+
+std::string EditSessionStore::add(std::shared_ptr<EditSession> session) {
+    static thread_local std::mt19937_64 random(std::random_device{}());
+
+    std::lock_guard<std::mutex> guard(lock);
+    auto now = std::chrono::steady_clock::now();
+    evict(now);
+
+    std::ostringstream oss;
+    oss << std::hex << std::setw(16) << std::setfill('0') << (random() ^ ++counter);
+    sessions[oss.str()] = Entry{ std::move(session), now };
+    return oss.str();
+}
+
+std::shared_ptr<EditSession> EditSessionStore::find(const std::string& id) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto it = sessions.find(id);
+    if (it == sessions.end()) {
+        return nullptr;
+    }
+    it->second.last_used = std::chrono::steady_clock::now();
+    return it->second.session;
+}
+
+bool EditSessionStore::remove(const std::string& id) {
+    std::lock_guard<std::mutex> guard(lock);
+    return sessions.erase(id) > 0;
+}
+
+void EditSessionStore::evict(std::chrono::steady_clock::time_point now) {
+    for (auto it = sessions.begin(); it != sessions.end();) {
+        it = now - it->second.last_used > IDLE_TIMEOUT ? sessions.erase(it) : std::next(it);
+    }
+
+    while (sessions.size() >= MAX_SESSIONS) {
+        auto oldest = std::min_element(sessions.begin(), sessions.end(), [](const auto& a, const auto& b) {
+            return a.second.last_used < b.second.last_used;
+        });
+        sessions.erase(oldest);
+    }
+}
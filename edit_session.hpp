@@ -0,0 +1,110 @@
+#ifndef EDIT_SESSION_HPP
+#define EDIT_SESSION_HPP
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include "dfa.hpp"
+#include "nfa.hpp"
+
+// One delta from the editor: add_state, remove_state, toggle_accept and set_start use state;
+// add_transition and remove_transition use state, symbol and target ("e" is epsilon)
+struct EditOperation {
+    std::string op;
+    std::string state;
+    std::string symbol;
+    std::string target;
+};
+
+// A machine kept compiled on the server between edits. A DFA session edits its transition
+// table in place. An NFA session also keeps epsilon closures and the rows of its subset
+// construction cached; an edit only drops the closures and subset rows it can affect, so
+// recompiling after a small change mostly replays cached rows instead of recomputing them.
+class EditSession {
+public:
+    enum class Kind { DFA, NFA };
+
+    EditSession(Kind kind, const std::string& definition);
+    EditSession(const EditSession&) = delete;
+    EditSession& operator=(const EditSession&) = delete;
+
+    Kind kind() const { return session_kind; }
+    std::uint64_t version() const { return edits; }
+    std::mutex& mutex() { return lock; }
+
+    // Applies one delta; on failure the session is unchanged and error says why
+    bool apply(const EditOperation& operation, std::string& error);
+
+    // Same conditions as DFA::validate / NFA::validate on the current machine
+    bool validate() const;
+    // The current machine as a DFA: the edited table itself, or the NFA determinized
+    DFA compiled();
+    // Subset rows that compiled() had to compute rather than take from the cache
+    std::uint32_t recomputedRows() const { return recomputed_rows; }
+
+private:
+    Kind session_kind;
+    std::mutex lock;
+    std::uint64_t edits;
+    bool has_unknown_names;
+
+    SymbolTable states;
+    SymbolTable alphabet;
+    std::uint32_t start_state;
+    std::vector<bool> removed;
+    std::vector<bool> accepting;
+    // out[state * (|Σ| + 1) + symbol] lists successors; symbol |Σ| is epsilon
+    std::vector<std::vector<std::uint32_t>> out;
+
+    // Universe of every cached StateSet; growing past it drops the NFA caches
+    std::uint32_t capacity;
+    std::vector<StateSet> closures;
+    std::vector<bool> closure_valid;
+    std::unordered_map<StateSet, std::vector<StateSet>, StateSet::Hash> rows;
+    std::uint32_t recomputed_rows;
+
+    std::uint32_t width() const { return alphabet.size() + 1; }
+    std::uint32_t epsilon() const { return alphabet.size(); }
+    std::vector<std::uint32_t>& successors(std::uint32_t state, std::uint32_t symbol) {
+        return out[state * width() + symbol];
+    }
+
+    std::uint32_t addState(std::string_view name);
+    bool addEdge(std::uint32_t state, std::uint32_t symbol, std::uint32_t target);
+    bool removeEdge(std::uint32_t state, std::uint32_t symbol, std::uint32_t target);
+    void removeState(std::uint32_t state);
+
+    void invalidateFrom(std::uint32_t state, std::uint32_t symbol);
+    void invalidateRows(const StateSet& changed);
+    const StateSet& closure(std::uint32_t state);
+    const std::vector<StateSet>& row(const StateSet& subset);
+};
+
+// Live sessions by id, dropped after IDLE_TIMEOUT without use or, when full, least recently used first
+class EditSessionStore {
+public:
+    static constexpr std::size_t MAX_SESSIONS = 256;
+    static constexpr std::chrono::minutes IDLE_TIMEOUT{ 30 };
+
+    std::string add(std::shared_ptr<EditSession> session);
+    std::shared_ptr<EditSession> find(const std::string& id);
+    bool remove(const std::string& id);
+
+private:
+    struct Entry {
+        std::shared_ptr<EditSession> session;
+        std::chrono::steady_clock::time_point last_used;
+    };
+
+    std::mutex lock;
+    std::unordered_map<std::string, Entry> sessions;
+    std::uint64_t counter = 0;
+
+    void evict(std::chrono::steady_clock::time_point now);
+};
+
+#endif
@@ -1,7 +1,10 @@
 #include "grammar.hpp"
 #include <sstream>
+#include <algorithm>
 
-Grammar::Grammar(const std::string& grammar_str) {
+Grammar::Grammar(const std::string& grammar_str, std::pmr::memory_resource* memory)
+    : memory(memory), variables(memory), terminals(memory), start_variable(SymbolTable::NO_SYMBOL),
+    productions(memory), has_unknown_symbols(false) {
     std::istringstream iss(grammar_str);
     std::string line;
 
@@ -12,6 +15,7 @@ Grammar::Grammar(const std::string& grammar_str) {
     std::getline(iss, line);
     parseStartVariable(line);
 
+    productions.resize(variables.size());
     while (std::getline(iss, line)) {
         parseProductions(line);
     }
@@ -22,7 +26,7 @@ void Grammar::parseVariables(const std::string& variables_str) {
     std::string variable;
 
     while (std::getline(iss, variable, ',')) {
-        variables.insert(variable);
+        if (!variable.empty()) variables.intern(variable);
     }
 }
 
@@ -31,20 +35,77 @@ void Grammar::parseTerminals(const std::string& terminals_str) {
     std::string terminal;
 
     while (std::getline(iss, terminal, ',')) {
-        terminals.insert(terminal);
+        if (!terminal.empty()) terminals.intern(terminal);
     }
 }
 
 void Grammar::parseStartVariable(const std::string& start_variable_str) {
-    start_variable = start_variable_str;
+    start_variable = variables.find(start_variable_str);
 }
 
 void Grammar::parseProductions(const std::string& productions_str) {
     std::istringstream iss(productions_str);
-    std::string variable, production;
+    std::string variable, token;
 
-    std::getline(iss, variable, ' ');
-    std::getline(iss, production);
+    if (!(iss >> variable)) {
+        return;
+    }
+
+    std::uint32_t variable_id = variables.find(variable);
+    if (variable_id == SymbolTable::NO_SYMBOL) {
+        has_unknown_symbols = true;
+        return;
+    }
+
+    // Each whitespace-separated token is split into declared symbols by longest
+    // match, so both "a S b" and "aSb" encode the same right-hand side
+    std::pmr::vector<std::uint32_t> rhs(memory);
+    bool first = true;
+    size_t longest = std::max(variables.maxNameLength(), terminals.maxNameLength());
+
+    while (iss >> token) {
+        if (first && token == "->") {
+            first = false;
+            continue;
+        }
+        first = false;
+
+        bool declared = variables.find(token) != SymbolTable::NO_SYMBOL || terminals.find(token) != SymbolTable::NO_SYMBOL;
+        if (!declared && (token == "e" || token == "ε")) {
+            continue;
+        }
+
+        size_t pos = 0;
+        while (pos < token.size()) {
+            size_t length = std::min(longest, token.size() - pos);
+            std::uint32_t symbol = SymbolTable::NO_SYMBOL;
 
-    productions[variable].push_back(production);
-}
\ No newline at end of file
+            for (; length > 0; --length) {
+                std::string_view candidate(token.data() + pos, length);
+                std::uint32_t id = variables.find(candidate);
+                if (id != SymbolTable::NO_SYMBOL) {
+                    symbol = id;
+                    break;
+                }
+                id = terminals.find(candidate);
+                if (id != SymbolTable::NO_SYMBOL) {
+                    symbol = id | TERMINAL_FLAG;
+                    break;
+                }
+            }
+
+            if (symbol == SymbolTable::NO_SYMBOL) {
+                has_unknown_symbols = true;
+                return;
+            }
+            rhs.push_back(symbol);
+            pos += length;
+        }
+    }
+
+    productions[variable_id].push_back(std::move(rhs));
+}
+
+const std::pmr::string& Grammar::symbolName(std::uint32_t symbol) const {
+    return isTerminalSymbol(symbol) ? terminals.name(terminalId(symbol)) : variables.name(symbol);
+}
@@ -2,23 +2,47 @@
 #define GRAMMAR_HPP
 
 #include <string>
-#include <unordered_set>
-#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <memory_resource>
+#include "symbol_table.hpp"
 
 class Grammar {
 public:
-    Grammar(const std::string& grammar_str);
+    // Right-hand side symbols are variable ids, or terminal ids tagged with this bit
+    static constexpr std::uint32_t TERMINAL_FLAG = 0x80000000u;
+
+    Grammar(const std::string& grammar_str, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
     virtual ~Grammar() = default;
 
     virtual bool validate() const = 0;
     virtual bool generates(const std::string& str) const = 0;
     virtual std::string toString() const = 0;
 
+    static bool isTerminalSymbol(std::uint32_t symbol) { return (symbol & TERMINAL_FLAG) != 0; }
+    static std::uint32_t terminalId(std::uint32_t symbol) { return symbol & ~TERMINAL_FLAG; }
+
+    // Read access to the compiled grammar for the parsers built on top of it
+    std::uint32_t variableCount() const { return variables.size(); }
+    std::uint32_t terminalCount() const { return terminals.size(); }
+    std::uint32_t startVariable() const { return start_variable; }
+    const std::pmr::vector<std::pmr::vector<std::uint32_t>>& rules(std::uint32_t variable) const {
+        return productions[variable];
+    }
+    const SymbolTable& terminalSymbols() const { return terminals; }
+    const std::pmr::string& symbolName(std::uint32_t symbol) const;
+
 protected:
-    std::unordered_set<std::string> variables;
-    std::unordered_set<std::string> terminals;
-    std::string start_variable;
-    std::unordered_map<std::string, std::vector<std::string>> productions;
+    // All containers allocate from this resource, typically a per-request arena
+    std::pmr::memory_resource* memory;
+    SymbolTable variables;
+    SymbolTable terminals;
+    std::uint32_t start_variable;
+    // productions[v] holds the right-hand sides of variable v; an empty one is epsilon
+    std::pmr::vector<std::pmr::vector<std::pmr::vector<std::uint32_t>>> productions;
+
+    // Set when a production mentions a symbol that was never declared
+    bool has_unknown_symbols;
 
     void parseVariables(const std::string& variables_str);
     void parseTerminals(const std::string& terminals_str);
@@ -26,4 +50,4 @@ protected:
     void parseProductions(const std::string& productions_str);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,429 @@
+#include "grammar_analysis.hpp"
+#include "budget.hpp"
+#include <algorithm>
+#include <set>
+#include <unordered_set>
+
+GrammarAnalysis::GrammarAnalysis(const GrammarRules& rules)
+    : nullable(rules.variable_count, false), productive(rules.variable_count, false),
+    reachable(rules.variable_count, false), useful_rules(rules.size(), false), empty(true) {
+    constexpr std::uint32_t NEVER = 0xffffffffu;
+
+    // occurrences[v] lists the rules with v on the right, once per occurrence
+    std::vector<std::vector<std::uint32_t>> occurrences(rules.variable_count);
+    std::vector<std::vector<std::uint32_t>> rules_by_variable(rules.variable_count);
+    std::vector<std::uint32_t> missing_productive(rules.size());
+    std::vector<std::uint32_t> missing_nullable(rules.size());
+    std::vector<std::uint32_t> productive_work;
+    std::vector<std::uint32_t> nullable_work;
+
+    auto mark = [](std::vector<bool>& property, std::vector<std::uint32_t>& work, std::uint32_t variable) {
+        if (!property[variable]) {
+            property[variable] = true;
+            work.push_back(variable);
+        }
+    };
+
+    for (std::uint32_t rule = 0; rule < rules.size(); ++rule) {
+        rules_by_variable[rules.lhs[rule]].push_back(rule);
+        std::uint32_t variables = 0;
+        bool has_terminal = false;
+        for (std::uint32_t symbol : rules.rhs[rule]) {
+            if (Grammar::isTerminalSymbol(symbol)) {
+                has_terminal = true;
+            }
+            else {
+                occurrences[symbol].push_back(rule);
+                ++variables;
+            }
+        }
+
+        // A terminal rules out nullability for good, but not productivity
+        missing_productive[rule] = variables;
+        missing_nullable[rule] = has_terminal ? NEVER : variables;
+        if (variables == 0) {
+            mark(productive, productive_work, rules.lhs[rule]);
+            if (!has_terminal) {
+                mark(nullable, nullable_work, rules.lhs[rule]);
+            }
+        }
+    }
+
+    while (!productive_work.empty()) {
+        std::uint32_t variable = productive_work.back();
+        productive_work.pop_back();
+        for (std::uint32_t rule : occurrences[variable]) {
+            if (--missing_productive[rule] == 0) {
+                mark(productive, productive_work, rules.lhs[rule]);
+            }
+        }
+    }
+    while (!nullable_work.empty()) {
+        std::uint32_t variable = nullable_work.back();
+        nullable_work.pop_back();
+        for (std::uint32_t rule : occurrences[variable]) {
+            if (missing_nullable[rule] != NEVER && --missing_nullable[rule] == 0) {
+                mark(nullable, nullable_work, rules.lhs[rule]);
+            }
+        }
+    }
+
+    if (rules.start_variable >= rules.variable_count || !productive[rules.start_variable]) {
+        return;
+    }
+    empty = false;
+
+    // Reachability only follows rules whose variables are all productive, so every reachable
+    // productive variable really occurs in some derivation of a string
+    std::vector<std::uint32_t> reachable_work;
+    mark(reachable, reachable_work, rules.start_variable);
+    while (!reachable_work.empty()) {
+        std::uint32_t variable = reachable_work.back();
+        reachable_work.pop_back();
+        for (std::uint32_t rule : rules_by_variable[variable]) {
+            if (missing_productive[rule] != 0) {
+                continue;
+            }
+            useful_rules[rule] = true;
+            for (std::uint32_t symbol : rules.rhs[rule]) {
+                if (!Grammar::isTerminalSymbol(symbol)) {
+                    mark(reachable, reachable_work, symbol);
+                }
+            }
+        }
+    }
+}
+
+namespace {
+
+// Hands out variable names that clash with no declared symbol: base, then base1, base2, ...
+class NameSource {
+public:
+    explicit NameSource(const GrammarRules& rules) {
+        taken.insert(rules.variable_names.begin(), rules.variable_names.end());
+        taken.insert(rules.terminal_names.begin(), rules.terminal_names.end());
+    }
+
+    std::string fresh(const std::string& base) {
+        std::string name = base;
+        for (unsigned suffix = 1; !taken.insert(name).second; ++suffix) {
+            name = base + std::to_string(suffix);
+        }
+        return name;
+    }
+
+private:
+    std::unordered_set<std::string> taken;
+};
+
+std::uint32_t addVariable(GrammarRules& rules, const std::string& name) {
+    rules.variable_names.push_back(name);
+    return rules.variable_count++;
+}
+
+void addRule(GrammarRules& rules, std::uint32_t lhs, std::vector<std::uint32_t> rhs) {
+    ResourceBudget::chargeStates();
+    rules.lhs.push_back(lhs);
+    rules.rhs.push_back(std::move(rhs));
+}
+
+// Same symbols, no rules
+GrammarRules withoutRules(const GrammarRules& rules) {
+    GrammarRules result = rules;
+    result.lhs.clear();
+    result.rhs.clear();
+    return result;
+}
+
+bool isUnitRule(const std::vector<std::uint32_t>& rhs) {
+    return rhs.size() == 1 && !Grammar::isTerminalSymbol(rhs[0]);
+}
+
+}
+
+GrammarRules trimmedGrammar(const GrammarRules& rules) {
+    GrammarAnalysis analysis(rules);
+    GrammarRules result;
+    result.terminal_count = rules.terminal_count;
+    result.terminal_names = rules.terminal_names;
+
+    std::vector<std::uint32_t> renamed(rules.variable_count, SymbolTable::NO_SYMBOL);
+    for (std::uint32_t variable = 0; variable < rules.variable_count; ++variable) {
+        if (variable == rules.start_variable || analysis.isUseful(variable)) {
+            renamed[variable] = addVariable(result, rules.variable_names[variable]);
+        }
+    }
+    if (rules.start_variable < rules.variable_count) {
+        result.start_variable = renamed[rules.start_variable];
+    }
+
+    // Rules stay grouped by variable in their original order, minus repeats
+    std::vector<std::vector<std::uint32_t>> rules_by_variable(result.variable_count);
+    for (std::uint32_t rule = 0; rule < rules.size(); ++rule) {
+        if (analysis.isUsefulRule(rule)) {
+            rules_by_variable[renamed[rules.lhs[rule]]].push_back(rule);
+        }
+    }
+    for (std::uint32_t variable = 0; variable < result.variable_count; ++variable) {
+        std::set<std::vector<std::uint32_t>> seen;
+        for (std::uint32_t rule : rules_by_variable[variable]) {
+            std::vector<std::uint32_t> rhs = rules.rhs[rule];
+            for (std::uint32_t& symbol : rhs) {
+                if (!Grammar::isTerminalSymbol(symbol)) {
+                    symbol = renamed[symbol];
+                }
+            }
+            if (seen.insert(rhs).second) {
+                addRule(result, variable, std::move(rhs));
+            }
+        }
+    }
+    return result;
+}
+
+GrammarRules toChomskyNormalForm(const GrammarRules& grammar) {
+    GrammarRules rules = trimmedGrammar(grammar);
+    if (rules.start_variable >= rules.variable_count) {
+        return rules;
+    }
+    NameSource names(rules);
+
+    // A fresh start variable, so S -> e can never be used inside another rule
+    bool start_on_right = false;
+    for (const std::vector<std::uint32_t>& rhs : rules.rhs) {
+        start_on_right |= std::find(rhs.begin(), rhs.end(), rules.start_variable) != rhs.end();
+    }
+    if (start_on_right) {
+        std::uint32_t start = addVariable(rules, names.fresh(rules.variable_names[rules.start_variable] + "0"));
+        addRule(rules, start, { rules.start_variable });
+        rules.start_variable = start;
+    }
+
+    // Terminals in rules of two or more symbols are replaced by a variable deriving just them
+    std::vector<std::uint32_t> terminal_variables(rules.terminal_count, SymbolTable::NO_SYMBOL);
+    std::uint32_t rule_count = rules.size();
+    for (std::uint32_t rule = 0; rule < rule_count; ++rule) {
+        for (std::size_t i = 0; rules.rhs[rule].size() >= 2 && i < rules.rhs[rule].size(); ++i) {
+            std::uint32_t symbol = rules.rhs[rule][i];
+            if (!Grammar::isTerminalSymbol(symbol)) {
+                continue;
+            }
+            std::uint32_t terminal = Grammar::terminalId(symbol);
+            if (terminal_variables[terminal] == SymbolTable::NO_SYMBOL) {
+                terminal_variables[terminal] = addVariable(rules, names.fresh("T_" + rules.terminal_names[terminal]));
+                addRule(rules, terminal_variables[terminal], { symbol });
+            }
+            rules.rhs[rule][i] = terminal_variables[terminal];
+        }
+    }
+
+    // Long rules become chains of binary ones: A -> X1 C1, C1 -> X2 C2, ..., Ck -> Xk-1 Xk
+    rule_count = rules.size();
+    for (std::uint32_t rule = 0; rule < rule_count; ++rule) {
+        if (rules.rhs[rule].size() <= 2) {
+            continue;
+        }
+        std::vector<std::uint32_t> symbols = std::move(rules.rhs[rule]);
+        std::uint32_t chain = addVariable(rules, names.fresh("X"));
+        rules.rhs[rule] = { symbols[0], chain };
+        for (std::size_t i = 1; i + 2 < symbols.size(); ++i) {
+            std::uint32_t next = addVariable(rules, names.fresh("X"));
+            addRule(rules, chain, { symbols[i], next });
+            chain = next;
+        }
+        addRule(rules, chain, { symbols[symbols.size() - 2], symbols.back() });
+    }
+
+    // Epsilon rules go; each binary rule gets the variants that leave out a nullable variable.
+    // Doing this after binarization keeps it linear instead of one variant per nullable subset.
+    GrammarAnalysis analysis(rules);
+    GrammarRules epsilon_free = withoutRules(rules);
+    for (std::uint32_t rule = 0; rule < rules.size(); ++rule) {
+        const std::vector<std::uint32_t>& rhs = rules.rhs[rule];
+        if (rhs.empty()) {
+            continue;
+        }
+        addRule(epsilon_free, rules.lhs[rule], rhs);
+        if (rhs.size() == 2) {
+            if (!Grammar::isTerminalSymbol(rhs[0]) && analysis.isNullable(rhs[0])) {
+                addRule(epsilon_free, rules.lhs[rule], { rhs[1] });
+            }
+            if (!Grammar::isTerminalSymbol(rhs[1]) && analysis.isNullable(rhs[1])) {
+                addRule(epsilon_free, rules.lhs[rule], { rhs[0] });
+            }
+        }
+    }
+    if (analysis.isNullable(rules.start_variable)) {
+        addRule(epsilon_free, rules.start_variable, {});
+    }
+
+    // Unit rules go: A gets every other rule of each variable it reaches by unit rules alone
+    std::vector<std::vector<std::uint32_t>> rules_by_variable(epsilon_free.variable_count);
+    for (std::uint32_t rule = 0; rule < epsilon_free.size(); ++rule) {
+        rules_by_variable[epsilon_free.lhs[rule]].push_back(rule);
+    }
+    GrammarRules result = withoutRules(epsilon_free);
+    std::vector<bool> visited(epsilon_free.variable_count);
+    std::vector<std::uint32_t> work;
+    for (std::uint32_t variable = 0; variable < epsilon_free.variable_count; ++variable) {
+        std::fill(visited.begin(), visited.end(), false);
+        visited[variable] = true;
+        work.assign(1, variable);
+        while (!work.empty()) {
+            ResourceBudget::checkpoint();
+            std::uint32_t current = work.back();
+            work.pop_back();
+            for (std::uint32_t rule : rules_by_variable[current]) {
+                const std::vector<std::uint32_t>& rhs = epsilon_free.rhs[rule];
+                if (!isUnitRule(rhs)) {
+                    // Only the start variable keeps an epsilon rule, and it is never reached here
+                    if (!rhs.empty() || current == variable) {
+                        addRule(result, variable, rhs);
+                    }
+                }
+                else if (!visited[rhs[0]]) {
+                    visited[rhs[0]] = true;
+                    work.push_back(rhs[0]);
+                }
+            }
+        }
+    }
+
+    return trimmedGrammar(result);
+}
+
+GrammarRules toGreibachNormalForm(const GrammarRules& cnf) {
+    using Rule = std::vector<std::uint32_t>;
+    GrammarRules result = withoutRules(cnf);
+    NameSource names(cnf);
+    const std::uint32_t original_count = cnf.variable_count;
+
+    std::vector<std::vector<Rule>> rules_by_variable(original_count);
+    for (std::uint32_t rule = 0; rule < cnf.size(); ++rule) {
+        rules_by_variable[cnf.lhs[rule]].push_back(cnf.rhs[rule]);
+    }
+
+    auto leadsWith = [](const Rule& rule, std::uint32_t variable) {
+        return !rule.empty() && rule[0] == variable;
+    };
+    // Replaces the leading variable of each rule of target for which should_expand holds by
+    // each of that variable's rules
+    auto expand = [&](std::uint32_t target, auto should_expand) {
+        std::vector<Rule> updated;
+        for (Rule& rule : rules_by_variable[target]) {
+            if (rule.empty() || Grammar::isTerminalSymbol(rule[0]) || !should_expand(rule[0])) {
+                updated.push_back(std::move(rule));
+                continue;
+            }
+            for (const Rule& leading : rules_by_variable[rule[0]]) {
+                ResourceBudget::chargeStates();
+                Rule expanded = leading;
+                expanded.insert(expanded.end(), rule.begin() + 1, rule.end());
+                updated.push_back(std::move(expanded));
+            }
+        }
+        std::sort(updated.begin(), updated.end());
+        updated.erase(std::unique(updated.begin(), updated.end()), updated.end());
+        rules_by_variable[target] = std::move(updated);
+    };
+
+    // Forward pass: afterwards every rule of Ai starts with a terminal or with Aj for j > i.
+    // Left recursion on Ai is traded for right recursion on a new variable Ai'.
+    for (std::uint32_t i = 0; i < original_count; ++i) {
+        for (std::uint32_t j = 0; j < i; ++j) {
+            expand(i, [j](std::uint32_t variable) { return variable == j; });
+        }
+
+        std::vector<Rule> recursive_tails;
+        std::vector<Rule> others;
+        for (Rule& rule : rules_by_variable[i]) {
+            if (leadsWith(rule, i)) {
+                recursive_tails.emplace_back(rule.begin() + 1, rule.end());
+            }
+            else {
+                others.push_back(std::move(rule));
+            }
+        }
+        if (recursive_tails.empty()) {
+            rules_by_variable[i] = std::move(others);
+            continue;
+        }
+
+        std::uint32_t tail = addVariable(result, names.fresh(cnf.variable_names[i] + "'"));
+        rules_by_variable.resize(result.variable_count);
+        rules_by_variable[i].clear();
+        for (Rule& rule : others) {
+            rules_by_variable[i].push_back(rule);
+            if (!rule.empty()) {
+                rule.push_back(tail);
+                rules_by_variable[i].push_back(std::move(rule));
+            }
+        }
+        for (Rule& rule : recursive_tails) {
+            rules_by_variable[tail].push_back(rule);
+            rule.push_back(tail);
+            rules_by_variable[tail].push_back(std::move(rule));
+        }
+        ResourceBudget::chargeStates(rules_by_variable[i].size() + rules_by_variable[tail].size());
+    }
+
+    // Backward pass: the last variable already starts with terminals only, and each earlier
+    // one only leads with later ones. The new tail variables lead with original variables or
+    // earlier tails, so taking them in creation order finishes the job.
+    auto anyVariable = [](std::uint32_t) { return true; };
+    for (std::uint32_t i = original_count; i-- > 0;) {
+        expand(i, anyVariable);
+    }
+    for (std::uint32_t tail = original_count; tail < result.variable_count; ++tail) {
+        expand(tail, anyVariable);
+    }
+
+    for (std::uint32_t variable = 0; variable < result.variable_count; ++variable) {
+        for (Rule& rule : rules_by_variable[variable]) {
+            addRule(result, variable, std::move(rule));
+        }
+    }
+    return trimmedGrammar(result);
+}
+
+bool hasFiniteLanguage(const GrammarRules& cnf) {
+    // Every rule of a trimmed CNF grammar except S -> e makes the sentential form longer, so
+    // the language is infinite exactly when some variable can derive itself
+    std::vector<std::vector<std::uint32_t>> successors(cnf.variable_count);
+    for (std::uint32_t rule = 0; rule < cnf.size(); ++rule) {
+        for (std::uint32_t symbol : cnf.rhs[rule]) {
+            if (!Grammar::isTerminalSymbol(symbol)) {
+                successors[cnf.lhs[rule]].push_back(symbol);
+            }
+        }
+    }
+
+    // Iterative depth-first search for a back edge
+    enum : std::uint8_t { UNSEEN, ACTIVE, DONE };
+    std::vector<std::uint8_t> color(cnf.variable_count, UNSEEN);
+    std::vector<std::pair<std::uint32_t, std::size_t>> stack;
+    for (std::uint32_t root = 0; root < cnf.variable_count; ++root) {
+        if (color[root] != UNSEEN) {
+            continue;
+        }
+        color[root] = ACTIVE;
+        stack.emplace_back(root, 0);
+        while (!stack.empty()) {
+            auto& [variable, next] = stack.back();
+            if (next == successors[variable].size()) {
+                color[variable] = DONE;
+                stack.pop_back();
+                continue;
+            }
+            std::uint32_t successor = successors[variable][next++];
+            if (color[successor] == ACTIVE) {
+                return false;
+            }
+            if (color[successor] == UNSEEN) {
+                color[successor] = ACTIVE;
+                stack.emplace_back(successor, 0);
+            }
+        }
+    }
+    return true;
+}
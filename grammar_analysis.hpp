@@ -0,0 +1,51 @@
+#ifndef GRAMMAR_ANALYSIS_HPP
+#define GRAMMAR_ANALYSIS_HPP
+
+#include <vector>
+#include <cstdint>
+#include "parse_tables.hpp"
+
+// Nullable, productive and reachable variables of a grammar, each found by one worklist pass:
+// every rule counts the right-hand side variables not yet known to have the property, and a
+// variable that gains it decrements the rules it occurs in. A variable is useful when it is
+// productive and reachable from the start variable through rules whose symbols are all
+// productive.
+class GrammarAnalysis {
+public:
+    explicit GrammarAnalysis(const GrammarRules& rules);
+
+    bool isNullable(std::uint32_t variable) const { return nullable[variable]; }
+    bool isProductive(std::uint32_t variable) const { return productive[variable]; }
+    bool isReachable(std::uint32_t variable) const { return reachable[variable]; }
+    bool isUseful(std::uint32_t variable) const { return productive[variable] && reachable[variable]; }
+    // True when the rule can take part in deriving a string from the start variable
+    bool isUsefulRule(std::uint32_t rule) const { return useful_rules[rule]; }
+    // True when the grammar derives no string at all
+    bool isEmpty() const { return empty; }
+
+private:
+    std::vector<bool> nullable;
+    std::vector<bool> productive;
+    std::vector<bool> reachable;
+    std::vector<bool> useful_rules;
+    bool empty;
+};
+
+// Drops useless variables and rules and duplicate rules. The start variable is always kept, with
+// no rules when the language is empty.
+GrammarRules trimmedGrammar(const GrammarRules& rules);
+
+// Chomsky normal form: every rule is A -> B C or A -> a, plus S -> e for the start variable when
+// the language contains the empty string, and the start variable never occurs on a right-hand
+// side. Variables invented along the way get names that clash with no declared symbol.
+GrammarRules toChomskyNormalForm(const GrammarRules& rules);
+
+// Greibach normal form built from a grammar in Chomsky normal form: every rule is a terminal
+// followed by variables, plus S -> e as above. The result can be exponentially larger, so each
+// rule produced is charged to the active ResourceBudget.
+GrammarRules toGreibachNormalForm(const GrammarRules& cnf);
+
+// True when a grammar in Chomsky normal form generates finitely many strings
+bool hasFiniteLanguage(const GrammarRules& cnf);
+
+#endif
@@ -0,0 +1,201 @@
+#include "json.hpp"
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <cctype>
+
+namespace {
+
+constexpr std::uint64_t ONES = 0x0101010101010101ull;
+constexpr std::uint64_t HIGH_BITS = 0x8080808080808080ull;
+
+// Nonzero when some byte of word is below 0x20, a quote or a backslash. The byte tests are the
+// usual SWAR zero-byte checks; they can flag a byte after a true match, never miss one.
+inline std::uint64_t needsEscape(std::uint64_t word) {
+    std::uint64_t quote = word ^ (ONES * '"');
+    std::uint64_t backslash = word ^ (ONES * '\\');
+    std::uint64_t control = (word - ONES * 0x20) & ~word;
+    std::uint64_t quote_zero = (quote - ONES) & ~quote;
+    std::uint64_t backslash_zero = (backslash - ONES) & ~backslash;
+    return (control | quote_zero | backslash_zero) & HIGH_BITS;
+}
+
+inline bool isPlain(unsigned char c) {
+    return c >= 0x20 && c != '"' && c != '\\';
+}
+
+void appendEscape(std::string& out, unsigned char c) {
+    static const char hex[] = "0123456789abcdef";
+    switch (c) {
+    case '\\': out += "\\\\"; break;
+    case '"': out += "\\\""; break;
+    case '\b': out += "\\b"; break;
+    case '\f': out += "\\f"; break;
+    case '\n': out += "\\n"; break;
+    case '\r': out += "\\r"; break;
+    case '\t': out += "\\t"; break;
+    default:
+        out += "\\u00";
+        out += hex[c >> 4];
+        out += hex[c & 15];
+        break;
+    }
+}
+
+}
+
+void appendJsonEscaped(std::string& out, std::string_view text) {
+    const char* data = text.data();
+    std::size_t size = text.size();
+    std::size_t run_start = 0, i = 0;
+
+    while (i < size) {
+        if (i + 8 <= size) {
+            std::uint64_t word;
+            std::memcpy(&word, data + i, 8);
+            if (!needsEscape(word)) {
+                i += 8;
+                continue;
+            }
+        }
+
+        // Something in the next eight bytes (or the tail) needs escaping; find it byte by byte
+        std::size_t end = std::min(size, i + 8);
+        for (; i < end; ++i) {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            if (!isPlain(c)) {
+                out.append(data + run_start, i - run_start);
+                appendEscape(out, c);
+                run_start = i + 1;
+            }
+        }
+    }
+    out.append(data + run_start, size - run_start);
+}
+
+void appendJsonField(std::string& out, std::string_view key, std::string_view text) {
+    out.reserve(out.size() + key.size() + text.size() + 6);
+    out += '"';
+    out.append(key.data(), key.size());
+    out += "\": \"";
+    appendJsonEscaped(out, text);
+    out += '"';
+}
+
+std::string escapeJson(std::string_view text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    appendJsonEscaped(escaped, text);
+    return escaped;
+}
+
+std::string unescapeJson(std::string_view text) {
+    std::string plain;
+    plain.reserve(text.size());
+
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '\\' || i + 1 == text.size()) {
+            plain += text[i];
+            continue;
+        }
+        char c = text[++i];
+        switch (c) {
+        case 'b': plain += '\b'; break;
+        case 'f': plain += '\f'; break;
+        case 'n': plain += '\n'; break;
+        case 'r': plain += '\r'; break;
+        case 't': plain += '\t'; break;
+        case 'u': {
+            unsigned code = 0;
+            std::size_t digits = 0;
+            for (; digits < 4 && i + 1 + digits < text.size() && std::isxdigit(static_cast<unsigned char>(text[i + 1 + digits])); ++digits) {
+                char digit = text[i + 1 + digits];
+                code = code * 16 + (std::isdigit(static_cast<unsigned char>(digit)) ? digit - '0' : (digit | 0x20) - 'a' + 10);
+            }
+            if (digits < 4) {
+                plain += c;
+                break;
+            }
+            i += 4;
+            // Code points past the BMP arrive as surrogate pairs, which are kept as two 3-byte sequences
+            if (code < 0x80) {
+                plain += static_cast<char>(code);
+            }
+            else if (code < 0x800) {
+                plain += static_cast<char>(0xc0 | (code >> 6));
+                plain += static_cast<char>(0x80 | (code & 0x3f));
+            }
+            else {
+                plain += static_cast<char>(0xe0 | (code >> 12));
+                plain += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+                plain += static_cast<char>(0x80 | (code & 0x3f));
+            }
+            break;
+        }
+        default: plain += c; break;
+        }
+    }
+    return plain;
+}
+
+std::string extractJsonField(const std::string& body, const std::string& key) {
+    std::size_t pos = body.find("\"" + key + "\"");
+    if (pos == std::string::npos) {
+        return "";
+    }
+    pos = body.find(':', pos + key.size() + 2);
+    if (pos == std::string::npos) {
+        return "";
+    }
+    pos = body.find_first_not_of(" \t\r\n", pos + 1);
+    if (pos == std::string::npos) {
+        return "";
+    }
+
+    if (body[pos] == '"') {
+        std::size_t end = pos + 1;
+        while (end < body.size() && body[end] != '"') {
+            end += body[end] == '\\' ? 2 : 1;
+        }
+        return body.substr(pos + 1, std::min(end, body.size()) - pos - 1);
+    }
+
+    std::size_t end = body.find_first_of(",}\r\n", pos);
+    return body.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+}
+
+std::vector<std::string> extractJsonStrings(const std::string& body, const std::string& key) {
+    std::vector<std::string> values;
+    std::size_t pos = body.find("\"" + key + "\"");
+    if (pos == std::string::npos) {
+        return values;
+    }
+    pos = body.find(':', pos + key.size() + 2);
+    if (pos == std::string::npos) {
+        return values;
+    }
+    pos = body.find_first_not_of(" \t\r\n", pos + 1);
+    if (pos == std::string::npos || body[pos] != '[') {
+        return values;
+    }
+
+    for (++pos; pos < body.size() && body[pos] != ']'; ++pos) {
+        if (body[pos] != '"') {
+            continue;
+        }
+        std::size_t end = pos + 1;
+        while (end < body.size() && body[end] != '"') {
+            end += body[end] == '\\' ? 2 : 1;
+        }
+        values.push_back(body.substr(pos + 1, std::min(end, body.size()) - pos - 1));
+        pos = end;
+    }
+    return values;
+}
+
+std::string nfaDefinition(std::string nfa_str) {
+    if (nfa_str.size() >= 2 && nfa_str.compare(nfa_str.size() - 2, 2, "\\n") == 0) {
+        nfa_str.erase(nfa_str.size() - 2);
+    }
+    return nfa_str + "-";
+}
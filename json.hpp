@@ -0,0 +1,32 @@
+#ifndef JSON_HPP
+#define JSON_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Appends text to out as the contents of a JSON string literal (without the quotes). Runs that
+// need no escaping are found eight bytes at a time and copied with a single append, so large
+// conversion results cost about one memcpy.
+void appendJsonEscaped(std::string& out, std::string_view text);
+
+// Appends "key": "text" to out, growing the buffer once for the common no-escape case
+void appendJsonField(std::string& out, std::string_view key, std::string_view text);
+
+std::string escapeJson(std::string_view text);
+
+// Decodes the contents of a JSON string literal; \uXXXX escapes become UTF-8
+std::string unescapeJson(std::string_view text);
+
+// Raw value of a top-level field in a single JSON object: string contents are returned without
+// unescaping (definitions use a literal \\n as their section separator), numbers as written
+std::string extractJsonField(const std::string& body, const std::string& key);
+// Raw contents of every string in a top-level array field, left escaped as extractJsonField
+// leaves them; empty when the field is missing or not an array
+std::vector<std::string> extractJsonStrings(const std::string& body, const std::string& key);
+
+// JSON requests carry the NFA definition with literal \\n separators; the parser also wants
+// the '-' marker after the last transition that the plain-text /nfa handler appends
+std::string nfaDefinition(std::string nfa_str);
+
+#endif
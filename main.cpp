@@ -3,68 +3,505 @@
 #include <fstream>
 #include <sstream>
 #include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <deque>
+#include <cstdlib>
+#include <cctype>
+#include <stdexcept>
 #include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
 #include <boost/filesystem.hpp>
 #include "dfa.hpp"
+#include "dfa_language.hpp"
+#include "product.hpp"
+#include "dfa_ensemble.hpp"
 #include "nfa.hpp"
+#include "antichain.hpp"
+#include "search.hpp"
 #include "cfg.hpp"
+#include "grammar_analysis.hpp"
+#include "parse_forest.hpp"
 #include "pda.hpp"
+#include "edit_session.hpp"
+#include "trace.hpp"
+#include "json.hpp"
+#include "compression.hpp"
+#include "metrics.hpp"
+#include "phase_timer.hpp"
+#include "arena.hpp"
+#include "budget.hpp"
+#include "admission.hpp"
+#include "result_cache.hpp"
 
 using boost::asio::ip::tcp;
 namespace fs = boost::filesystem;
 
+// JSON array of names, for the trace socket's "loaded" message
+std::string jsonNames(const std::vector<std::string>& names) {
+    std::string json = "[";
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        json += (i > 0 ? ", \"" : "\"") + escapeJson(names[i]) + "\"";
+    }
+    return json + "]";
+}
+
+std::string jsonIds(const std::vector<std::uint32_t>& ids) {
+    std::string json = "[";
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        json += (i > 0 ? "," : "") + std::to_string(ids[i]);
+    }
+    return json + "]";
+}
+
+// One upgraded /trace socket. It keeps the machine the client loaded for as long as the socket
+// is open, so a run on a long input is stepped without re-parsing, and streams the steps as
+// configuration deltas, up to batch per text frame. Messages from the client:
+//
+//     {"type": "load", "kind": "dfa" | "nfa" | "pda", "definition": "..."}
+//     {"type": "run", "input": "...", "batch": 64}
+//
+// A load is answered with the state, symbol and stack symbol names and the start configurations
+// (see TraceMachine for how configurations are numbered). A run is answered with frames of
+// {"type": "steps", "from": i, "steps": [[symbol, length, [added], [removed]], ...]}, where i is
+// the character offset of the first step, symbol is an id or -1 for an undeclared character and
+// length is how many characters the step read, and a final
+// {"type": "done", "steps": n, "consumed": c, "accepted": b}.
+// The next message is read only once a run is done, so a slow client holds the run back.
+class TraceConnection : public std::enable_shared_from_this<TraceConnection> {
+public:
+    static constexpr std::size_t DEFAULT_BATCH = 64;
+    static constexpr std::size_t MAX_BATCH = 4096;
+    static constexpr std::size_t MAX_MESSAGE_SIZE = 1 << 20;
+
+    TraceConnection(tcp::socket socket, std::shared_ptr<void> slot) : ws_(std::move(socket)), slot_(std::move(slot)) {
+        ws_.read_message_max(MAX_MESSAGE_SIZE);
+    }
+
+    // Completes the handshake for the upgrade request the HTTP server already read
+    void start(std::shared_ptr<std::string> request_head) {
+        auto self = shared_from_this();
+        ws_.async_accept(boost::asio::buffer(*request_head),
+            [self, request_head](boost::system::error_code ec) {
+                if (!ec) {
+                    self->read();
+                }
+            });
+    }
+
+private:
+    void read() {
+        auto self = shared_from_this();
+        ws_.async_read(buffer_, [self](boost::system::error_code ec, std::size_t) {
+            if (ec) {
+                return;
+            }
+            std::string message = boost::beast::buffers_to_string(self->buffer_.data());
+            self->buffer_.consume(self->buffer_.size());
+            self->handleMessage(message);
+        });
+    }
+
+    void handleMessage(const std::string& message) {
+        std::string type = extractJsonField(message, "type");
+        if (type == "load") {
+            handleLoad(message);
+        }
+        else if (type == "run") {
+            handleRun(message);
+        }
+        else {
+            sendError("unknown message type");
+        }
+    }
+
+    void handleLoad(const std::string& message) {
+        std::string kind_name = extractJsonField(message, "kind");
+        TraceMachine::Kind kind;
+        if (kind_name == "dfa") kind = TraceMachine::Kind::DFA;
+        else if (kind_name == "nfa") kind = TraceMachine::Kind::NFA;
+        else if (kind_name == "pda") kind = TraceMachine::Kind::PDA;
+        else {
+            sendError("kind must be dfa, nfa or pda");
+            return;
+        }
+
+        std::string error;
+        ResourceBudget budget;
+        try {
+            machine_ = TraceMachine::load(kind, extractJsonField(message, "definition"), error);
+        }
+        catch (const BudgetExceeded& e) {
+            machine_.reset();
+            error = e.what();
+        }
+        if (!machine_) {
+            sendError(error);
+            return;
+        }
+
+        std::string frame = "{\"type\": \"loaded\", \"states\": " + jsonNames(machine_->stateNames());
+        frame += ", \"symbols\": " + jsonNames(machine_->symbolNames());
+        frame += ", \"stack\": " + jsonNames(machine_->stackSymbolNames());
+        frame += ", \"start\": " + jsonIds(machine_->configurations());
+        frame += ", \"accepting\": " + std::string(machine_->accepting() ? "true" : "false") + "}";
+        send(std::move(frame), false);
+    }
+
+    void handleRun(const std::string& message) {
+        if (!machine_) {
+            sendError("load a machine first");
+            return;
+        }
+
+        input_ = extractJsonField(message, "input");
+        std::string batch_str = extractJsonField(message, "batch");
+        batch_ = batch_str.empty() ? DEFAULT_BATCH
+            : std::min<std::size_t>(std::max(std::atoi(batch_str.c_str()), 1), MAX_BATCH);
+        position_ = 0;
+        steps_ = 0;
+        machine_->reset();
+        sendNextBatch();
+    }
+
+    // Steps up to batch_ symbols into one frame; the write completion sends the next one
+    void sendNextBatch() {
+        if (position_ == input_.size() || machine_->configurations().empty()) {
+            std::string frame = "{\"type\": \"done\", \"steps\": " + std::to_string(steps_);
+            frame += ", \"consumed\": " + std::to_string(position_);
+            frame += ", \"accepted\": " + std::string(position_ == input_.size() && machine_->accepting() ? "true" : "false") + "}";
+            send(std::move(frame), false);
+            return;
+        }
+
+        std::string frame = "{\"type\": \"steps\", \"from\": " + std::to_string(position_) + ", \"steps\": [";
+        ResourceBudget budget;
+        try {
+            TraceDelta delta;
+            for (std::size_t count = 0; count < batch_ && position_ < input_.size() &&
+                !machine_->configurations().empty(); ++count) {
+                std::size_t length;
+                std::uint32_t symbol = machine_->nextSymbol(input_, position_, length);
+                machine_->step(symbol, delta);
+                frame += count > 0 ? ",[" : "[";
+                frame += symbol == SymbolTable::NO_SYMBOL ? "-1" : std::to_string(symbol);
+                frame += "," + std::to_string(length) + "," + jsonIds(delta.added) + "," + jsonIds(delta.removed) + "]";
+                position_ += length;
+                ++steps_;
+            }
+        }
+        catch (const BudgetExceeded& e) {
+            Metrics::count(EngineCounter::BudgetAborts);
+            machine_.reset();
+            sendError(e.what());
+            return;
+        }
+        send(frame + "]}", true);
+    }
+
+    void sendError(const std::string& error) {
+        send("{\"type\": \"error\", \"error\": \"" + escapeJson(error) + "\"}", false);
+    }
+
+    // Writes one text frame, then either continues the current run or waits for the next message
+    void send(std::string frame, bool continue_run) {
+        auto self = shared_from_this();
+        auto payload = std::make_shared<std::string>(std::move(frame));
+        ws_.text(true);
+        ws_.async_write(boost::asio::buffer(*payload),
+            [self, payload, continue_run](boost::system::error_code ec, std::size_t) {
+                if (ec) {
+                    return;
+                }
+                if (continue_run) {
+                    self->sendNextBatch();
+                }
+                else {
+                    self->read();
+                }
+            });
+    }
+
+    boost::beast::websocket::stream<tcp::socket> ws_;
+    boost::beast::flat_buffer buffer_;
+    std::unique_ptr<TraceMachine> machine_;
+    std::string input_;
+    // Characters consumed and symbols stepped in the current run
+    std::size_t position_ = 0;
+    std::size_t steps_ = 0;
+    std::size_t batch_ = DEFAULT_BATCH;
+    // Counts against the server's connection limit until the socket closes
+    std::shared_ptr<void> slot_;
+};
+
 class HttpServer {
 public:
-    HttpServer(boost::asio::io_context& io_context, short port)
+    HttpServer(boost::asio::io_context& io_context, short port, const AdmissionLimits& limits = AdmissionLimits(),
+        const ResultCacheOptions& cache_options = ResultCacheOptions())
         : acceptor_(io_context, tcp::endpoint(tcp::v4(), port)),
-        socket_(io_context) {
+        admission_(limits),
+        results_(cache_options) {
         startAccept();
     }
 
 private:
+    // One accepted socket, from accept until its response is written or it moves to a
+    // TraceConnection. It holds a connection slot for as long as it lives, and a pending
+    // request slot from admission until the request is answered.
+    struct Connection {
+        Connection(tcp::socket accepted, AdmissionControl& control)
+            : socket(std::move(accepted)), timer(socket.get_executor()), buffer(MAX_REQUEST_SIZE), admission(control) {}
+        ~Connection() {
+            releaseRequest();
+            admission.closeConnection();
+        }
+
+        void releaseRequest() {
+            if (admitted) {
+                admission.release(client, request_class);
+                admitted = false;
+            }
+        }
+
+        tcp::socket socket;
+        boost::asio::steady_timer timer;
+        boost::asio::streambuf buffer;
+        AdmissionControl& admission;
+        std::string client;
+        // Everything up to and including the blank line
+        std::string head;
+        std::string method;
+        std::string path;
+        RequestClass request_class = RequestClass::Cheap;
+        bool admitted = false;
+        std::chrono::steady_clock::time_point arrived;
+    };
+
     void startAccept() {
-        acceptor_.async_accept(socket_, [this](boost::system::error_code ec) {
+        acceptor_.async_accept([this](boost::system::error_code ec, tcp::socket socket) {
             if (!ec) {
-                handleRequest();
+                acceptConnection(std::move(socket));
             }
             startAccept();
             });
     }
 
-    void handleRequest() {
-        auto read_buffer = std::make_shared<boost::asio::streambuf>();
-        boost::asio::async_read_until(socket_, *read_buffer, "\r\n\r\n",
-            [this, read_buffer](boost::system::error_code ec, std::size_t length) {
-                if (!ec) {
-                    std::istream stream(read_buffer.get());
-                    std::string request;
-                    std::getline(stream, request);
+    // Over the connection limit the socket is answered without reading anything from it
+    void acceptConnection(tcp::socket socket) {
+        if (!admission_.openConnection()) {
+            auto rejected = std::make_shared<tcp::socket>(std::move(socket));
+            sendRejection(*rejected, rejected, "other", "503 Service Unavailable", "too_many_connections", 1, 0,
+                std::chrono::steady_clock::now());
+            return;
+        }
+        readHead(std::make_shared<Connection>(std::move(socket), admission_));
+    }
 
-                    // Parse the request method and URL path
-                    std::istringstream request_stream(request);
-                    std::string method, path;
-                    request_stream >> method >> path;
+    // Admission is decided from the head alone, so a rejected request never has its body read.
+    // An admitted one is read in full and queued by class.
+    void readHead(std::shared_ptr<Connection> connection) {
+        armTimeout(connection);
+        boost::asio::async_read_until(connection->socket, connection->buffer, "\r\n\r\n",
+            [this, connection](boost::system::error_code ec, std::size_t length) {
+                if (ec) {
+                    return;
+                }
+                connection->arrived = std::chrono::steady_clock::now();
+                auto data = connection->buffer.data();
+                connection->head.assign(boost::asio::buffers_begin(data), boost::asio::buffers_begin(data) + length);
+                std::istringstream request_line(connection->head.substr(0, connection->head.find("\r\n")));
+                request_line >> connection->method >> connection->path;
 
-                    if (method == "GET") {
-                        handleGetRequest(path);
-                    }
-                    else if (method == "POST") {
-                        handlePostRequest(path, stream);
-                    }
-                    else {
-                        handleNotFound();
-                    }
+                std::string route = routeLabel(connection->method, connection->path);
+                std::size_t content_length = std::strtoull(headerValue(connection->head, "content-length").c_str(), nullptr, 10);
+                if (content_length > MAX_REQUEST_SIZE - length) {
+                    sendRejection(connection->socket, connection, route, "413 Payload Too Large", "payload_too_large", 0,
+                        length, connection->arrived);
+                    return;
+                }
+
+                boost::system::error_code endpoint_ec;
+                tcp::endpoint remote = connection->socket.remote_endpoint(endpoint_ec);
+                connection->client = endpoint_ec ? "unknown" : remote.address().to_string();
+                connection->request_class = admission_.classify(connection->method, connection->path, content_length);
+
+                AdmissionDecision decision = admission_.admit(connection->client, connection->request_class, connection->arrived);
+                if (decision.result == AdmissionResult::RateLimited) {
+                    sendRejection(connection->socket, connection, route, "429 Too Many Requests", "rate_limited",
+                        decision.retry_after, length, connection->arrived);
+                    return;
+                }
+                if (decision.result == AdmissionResult::Overloaded) {
+                    sendRejection(connection->socket, connection, route, "503 Service Unavailable", "overloaded",
+                        decision.retry_after, length, connection->arrived);
+                    return;
+                }
+                connection->admitted = true;
+
+                std::size_t buffered = connection->buffer.size() - length;
+                if (buffered >= content_length) {
+                    enqueue(connection);
+                    return;
                 }
+                boost::asio::async_read(connection->socket, connection->buffer,
+                    boost::asio::transfer_exactly(content_length - buffered),
+                    [this, connection](boost::system::error_code ec, std::size_t) {
+                        if (!ec) {
+                            enqueue(connection);
+                        }
+                    });
+            });
+    }
+
+    // Closes the socket if the current read or write is still going after REQUEST_TIMEOUT, so a
+    // slow client cannot hold its connection slot forever
+    void armTimeout(const std::shared_ptr<Connection>& connection) {
+        std::weak_ptr<Connection> weak = connection;
+        connection->timer.expires_after(REQUEST_TIMEOUT);
+        connection->timer.async_wait([weak](boost::system::error_code ec) {
+            auto connection = weak.lock();
+            if (!ec && connection) {
+                boost::system::error_code ignored;
+                connection->socket.close(ignored);
+            }
+            });
+    }
+
+    void enqueue(std::shared_ptr<Connection> connection) {
+        connection->timer.cancel();
+        if (connection->request_class == RequestClass::Cheap) {
+            cheap_queue_.push_back(std::move(connection));
+        }
+        else {
+            expensive_queue_.push_back(std::move(connection));
+        }
+        serveNext();
+    }
+
+    // Requests are served one at a time; the next one starts once the current response is
+    // written. One that waited too long is turned away, since its client has likely given up.
+    void serveNext() {
+        while (!current_ && (!cheap_queue_.empty() || !expensive_queue_.empty())) {
+            auto& queue = admission_.next(!cheap_queue_.empty(), !expensive_queue_.empty()) == RequestClass::Cheap
+                ? cheap_queue_ : expensive_queue_;
+            std::shared_ptr<Connection> connection = std::move(queue.front());
+            queue.pop_front();
+
+            if (std::chrono::steady_clock::now() - connection->arrived > admission_.limits().max_queue_wait) {
+                sendRejection(connection->socket, connection, routeLabel(connection->method, connection->path),
+                    "503 Service Unavailable", "queue_timeout", 1, connection->buffer.size(), connection->arrived);
+                continue;
+            }
+            handleRequest(std::move(connection));
+        }
+    }
+
+    void handleRequest(std::shared_ptr<Connection> connection) {
+        current_ = std::move(connection);
+        // Latency is measured from arrival, so time spent queued shows up in the metrics
+        request_start_ = current_->arrived;
+        bytes_in_ = current_->buffer.size();
+        route_ = routeLabel(current_->method, current_->path);
+        accept_encoding_ = negotiateEncoding(headerValue(current_->head, "accept-encoding"));
+
+        std::istream stream(&current_->buffer);
+        std::string request;
+        std::getline(stream, request);
+
+        const std::string& method = current_->method;
+        const std::string& path = current_->path;
+        if (method == "GET" && path == "/trace" && isWebSocketUpgrade(current_->head)) {
+            upgradeToTrace();
+        }
+        else if (method == "GET") {
+            handleGetRequest(path);
+        }
+        else if (method == "POST") {
+            handlePostRequest(path, stream);
+        }
+        else {
+            handleNotFound();
+        }
+    }
+
+    // Answers a request that is turned away rather than served, then closes the socket.
+    // owner keeps the socket alive until the write completes.
+    void sendRejection(tcp::socket& socket, std::shared_ptr<void> owner, const std::string& route,
+        const std::string& status, const std::string& error, std::uint32_t retry_after, std::size_t bytes_in,
+        std::chrono::steady_clock::time_point start) {
+        std::string body = "{\"error\": \"" + error + "\"}";
+        std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: application/json\r\nConnection: close\r\n";
+        if (retry_after > 0) {
+            response += "Retry-After: " + std::to_string(retry_after) + "\r\n";
+        }
+        response += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+
+        int code = std::atoi(status.c_str());
+        auto payload = std::make_shared<std::string>(std::move(response));
+        boost::asio::async_write(socket, boost::asio::buffer(*payload),
+            [&socket, owner, payload, route, code, bytes_in, start](boost::system::error_code, std::size_t length) {
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                Metrics::instance().recordRequest(route, code,
+                    std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), bytes_in, length);
+
+                boost::system::error_code ignored;
+                socket.shutdown(tcp::socket::shutdown_both, ignored);
+                socket.close(ignored);
             });
     }
 
+    // Value of a request header, matched case-insensitively; empty when the header is absent
+    static std::string headerValue(const std::string& head, const std::string& name) {
+        std::size_t line = head.find("\r\n");
+        while (line != std::string::npos && line + 2 < head.size()) {
+            std::size_t start = line + 2;
+            std::size_t end = head.find("\r\n", start);
+            std::size_t colon = head.find(':', start);
+            if (end == start || end == std::string::npos) {
+                break;
+            }
+            if (colon < end && colon - start == name.size() &&
+                std::equal(name.begin(), name.end(), head.begin() + start,
+                    [](char a, char b) { return a == std::tolower(static_cast<unsigned char>(b)); })) {
+                std::size_t value = head.find_first_not_of(" \t", colon + 1);
+                return value < end ? head.substr(value, end - value) : "";
+            }
+            line = end;
+        }
+        return "";
+    }
+
+    static bool isWebSocketUpgrade(std::string head) {
+        std::transform(head.begin(), head.end(), head.begin(), [](unsigned char c) { return std::tolower(c); });
+        return head.find("\r\nupgrade: websocket") != std::string::npos;
+    }
+
+    // The socket moves to its own connection object, which keeps the connection slot for as long
+    // as it is open but gives back the pending request slot
+    void upgradeToTrace() {
+        auto elapsed = std::chrono::steady_clock::now() - request_start_;
+        Metrics::instance().recordRequest(route_, 101,
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), bytes_in_, 0);
+        current_->timer.cancel();
+        current_->releaseRequest();
+        auto head = std::make_shared<std::string>(current_->head);
+        std::make_shared<TraceConnection>(std::move(current_->socket), current_)->start(head);
+        current_.reset();
+    }
+
     void handleGetRequest(const std::string& path) {
         if (path == "/") {
             serveFile("index.html");
         }
+        else if (path == "/metrics") {
+            serveMetrics();
+        }
         else {
             std::string file_path = "." + path;
-            if (fs::exists(file_path) && fs::is_regular_file(file_path)) {
+            if (fs::exists(file_path) && fs::is_regular_file(file_path) && !isCacheFile(file_path)) {
                 serveFile(file_path);
             }
             else {
@@ -73,16 +510,71 @@ private:
         }
     }
 
+    // The result cache log and its compaction file are never served, wherever they are configured
+    bool isCacheFile(const fs::path& file_path) const {
+        std::string extension = file_path.extension().string();
+        if (extension == ".cache" || extension == ".compact") {
+            return true;
+        }
+        if (results_.path().empty()) {
+            return false;
+        }
+        boost::system::error_code ec;
+        return fs::equivalent(file_path, results_.path(), ec) || fs::equivalent(file_path, results_.path() + ".compact", ec);
+    }
+
     void handlePostRequest(const std::string& path, std::istream& request_stream) {
         if (path == "/dfa") {
             handleDFAValidation(request_stream);
         }
+        else if (path == "/dfa/count") {
+            handleDFACount(request_stream);
+        }
+        else if (path == "/dfa/enumerate") {
+            handleDFAEnumeration(request_stream);
+        }
+        else if (path == "/dfa/codegen") {
+            handleDFACodegen(request_stream);
+        }
+        else if (path == "/dfa/product") {
+            handleDFAProduct(request_stream);
+        }
+        else if (path == "/dfa/inclusion") {
+            handleDFAInclusion(request_stream);
+        }
+        else if (path == "/dfa/grade") {
+            handleDFAGrade(request_stream);
+        }
         else if (path == "/nfa") {
             handleNFAConversion(request_stream);
         }
+        else if (path == "/nfa/inclusion") {
+            handleNFAInclusion(request_stream);
+        }
+        else if (path == "/nfa/universality") {
+            handleNFAUniversality(request_stream);
+        }
+        else if (path == "/search") {
+            handleSearch(request_stream);
+        }
+        else if (path == "/session/create") {
+            handleSessionCreate(request_stream);
+        }
+        else if (path == "/session/edit") {
+            handleSessionEdit(request_stream);
+        }
+        else if (path == "/session/close") {
+            handleSessionClose(request_stream);
+        }
         else if (path == "/cfg") {
             handleCFGValidation(request_stream);
         }
+        else if (path == "/cfg/parse") {
+            handleCFGParse(request_stream);
+        }
+        else if (path == "/cfg/normalize") {
+            handleCFGNormalization(request_stream);
+        }
         else if (path == "/pda") {
             handlePDAConversion(request_stream);
         }
@@ -92,98 +584,811 @@ private:
     }
 
     void handleDFAValidation(std::istream& request_stream) {
-        std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
-        std::istringstream iss(request_body);
-        std::string line;
+        PhaseTimer timer;
         std::string dfa_str;
         std::string input_str;
 
-        while (std::getline(iss, line)) {
-            if (line.find("dfaDefinition") != std::string::npos) {
-                dfa_str = extractJsonValue(line);
-                dfa_str.erase(dfa_str.find("\""));
-            }
-            if (line.find("inputString") != std::string::npos) {
-                input_str = extractJsonValue(line);
-                for (int i = 0; i < 4; i++)
-                    input_str.erase(0, input_str.find("\"") + 1);
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            std::istringstream iss(request_body);
+            std::string line;
+
+            while (std::getline(iss, line)) {
+                if (line.find("dfaDefinition") != std::string::npos) {
+                    dfa_str = extractJsonValue(line);
+                    dfa_str.erase(dfa_str.find("\""));
+                }
+                if (line.find("inputString") != std::string::npos) {
+                    input_str = extractJsonValue(line);
+                    for (int i = 0; i < 4; i++)
+                        input_str.erase(0, input_str.find("\"") + 1);
+                }
             }
         }
 
         bool is_valid_dfa = false;
         bool accepts_input = false;
+        ResourceBudget budget;
+        RequestArena arena;
         try {
-            DFA dfa(dfa_str);
-            is_valid_dfa = dfa.validate();
-            accepts_input = is_valid_dfa && dfa.accepts(input_str);
+            std::unique_ptr<DFA> dfa;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                dfa.reset(new DFA(dfa_str, arena.resource()));
+            }
+            PhaseTimer::Scope phase(timer, "compute");
+            is_valid_dfa = dfa->validate();
+            accepts_input = is_valid_dfa && dfa->accepts(input_str);
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
         }
         catch (const std::exception& e) {
             std::cerr << "DFA validation error: " << e.what() << "\n";
         }
 
-        std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n";
-        response += "{\"is_valid_dfa\": " + std::string(is_valid_dfa ? "true" : "false") + ", ";
-        response += "\"accepts_input\": " + std::string(accepts_input ? "true" : "false") + "}";
-        sendResponse(response);
+        std::string body;
+        {
+            PhaseTimer::Scope phase(timer, "serialize");
+            body = "{\"is_valid_dfa\": " + std::string(is_valid_dfa ? "true" : "false") + ", ";
+            body += "\"accepts_input\": " + std::string(accepts_input ? "true" : "false");
+        }
+        sendJsonResponse(body, timer);
+    }
+
+    void handleDFACount(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::string dfa_str;
+        std::uint64_t length = 0;
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            dfa_str = extractJsonField(request_body, "dfaDefinition");
+            length = std::min<std::uint64_t>(std::strtoull(extractJsonField(request_body, "length").c_str(), nullptr, 10),
+                MAX_COUNT_LENGTH);
+        }
+
+        bool is_valid_dfa = false;
+        std::string count = "0";
+        ResourceBudget budget;
+        RequestArena arena;
+        try {
+            std::unique_ptr<DFA> dfa;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                dfa.reset(new DFA(dfa_str, arena.resource()));
+            }
+            PhaseTimer::Scope phase(timer, "compute");
+            is_valid_dfa = dfa->validate();
+            if (is_valid_dfa) {
+                count = countAccepted(*dfa, length).toString();
+            }
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
+        }
+        catch (const std::invalid_argument& e) {
+            // An alphabet whose symbol sequences do not match the strings accepts reads
+            sendJsonResponse("{\"error\": \"" + escapeJson(e.what()) + "\"", timer, "400 Bad Request");
+            return;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "DFA count error: " << e.what() << "\n";
+        }
+
+        // The count can exceed every JSON number type, so it is sent as a decimal string
+        std::string body = "{\"is_valid_dfa\": " + std::string(is_valid_dfa ? "true" : "false") + ", ";
+        body += "\"length\": " + std::to_string(length) + ", ";
+        body += "\"count\": \"" + count + "\"";
+        sendJsonResponse(body, timer);
+    }
+
+    void handleDFAEnumeration(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::string dfa_str;
+        std::size_t limit = 10;
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            dfa_str = extractJsonField(request_body, "dfaDefinition");
+            std::string limit_str = extractJsonField(request_body, "limit");
+            if (!limit_str.empty()) {
+                limit = std::min<std::size_t>(std::strtoull(limit_str.c_str(), nullptr, 10), MAX_ENUMERATION_LIMIT);
+            }
+        }
+
+        bool is_valid_dfa = false;
+        bool exhausted = false;
+        std::vector<std::string> strings;
+        ResourceBudget budget;
+        RequestArena arena;
+        try {
+            std::unique_ptr<DFA> dfa;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                dfa.reset(new DFA(dfa_str, arena.resource()));
+            }
+            PhaseTimer::Scope phase(timer, "compute");
+            is_valid_dfa = dfa->validate();
+            if (is_valid_dfa) {
+                ShortlexEnumerator enumerator(*dfa);
+                std::string word;
+                while (strings.size() < limit && enumerator.next(word)) {
+                    strings.push_back(word);
+                }
+                exhausted = strings.size() < limit;
+            }
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
+        }
+        catch (const std::invalid_argument& e) {
+            // An alphabet whose symbol sequences do not match the strings accepts reads
+            sendJsonResponse("{\"error\": \"" + escapeJson(e.what()) + "\"", timer, "400 Bad Request");
+            return;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "DFA enumeration error: " << e.what() << "\n";
+        }
+
+        std::string body;
+        {
+            PhaseTimer::Scope phase(timer, "serialize");
+            body = "{\"is_valid_dfa\": " + std::string(is_valid_dfa ? "true" : "false") + ", ";
+            body += "\"strings\": [";
+            for (std::size_t i = 0; i < strings.size(); ++i) {
+                body += (i > 0 ? ", \"" : "\"") + escapeJson(strings[i]) + "\"";
+            }
+            body += "], \"exhausted\": " + std::string(exhausted ? "true" : "false");
+        }
+        sendJsonResponse(body, timer);
+    }
+
+    void handleDFACodegen(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::string dfa_str;
+        std::string function_name = "matches";
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            dfa_str = extractJsonField(request_body, "dfaDefinition");
+            std::string name = extractJsonField(request_body, "functionName");
+            // Anything that is not a plain identifier would make the generated source invalid
+            bool is_identifier = !name.empty() && !std::isdigit(static_cast<unsigned char>(name[0])) &&
+                std::all_of(name.begin(), name.end(), [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; });
+            if (is_identifier) {
+                function_name = name;
+            }
+        }
+
+        bool is_valid_dfa = false;
+        std::string code;
+        ResourceBudget budget;
+        RequestArena arena;
+        try {
+            std::unique_ptr<DFA> dfa;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                dfa.reset(new DFA(dfa_str, arena.resource()));
+            }
+            PhaseTimer::Scope phase(timer, "compute");
+            is_valid_dfa = dfa->validate();
+            if (is_valid_dfa) {
+                code = dfa->toCpp(function_name);
+            }
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "DFA code generation error: " << e.what() << "\n";
+        }
+
+        std::string body;
+        {
+            PhaseTimer::Scope phase(timer, "escape");
+            body = "{\"is_valid_dfa\": " + std::string(is_valid_dfa ? "true" : "false") + ", ";
+            body += "\"code\": \"" + escapeJson(code) + "\"";
+        }
+        sendJsonResponse(body, timer);
+    }
+
+    void handleDFAProduct(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::string left_str, right_str, operation;
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            left_str = extractJsonField(request_body, "leftDefinition");
+            right_str = extractJsonField(request_body, "rightDefinition");
+            operation = extractJsonField(request_body, "operation");
+        }
+
+        bool is_valid = false;
+        bool is_empty = true;
+        std::string dfa_str, witness;
+        ResourceBudget budget;
+        RequestArena arena;
+        try {
+            std::unique_ptr<DFA> left, right, result;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                left.reset(new DFA(left_str, arena.resource()));
+                if (operation != "complement") {
+                    right.reset(new DFA(right_str, arena.resource()));
+                }
+            }
+            {
+                PhaseTimer::Scope phase(timer, "compute");
+                is_valid = left->validate() && (!right || right->validate());
+                if (is_valid && operation == "complement") {
+                    result.reset(new DFA(complementDFA(*left, arena.resource())));
+                }
+                else if (is_valid) {
+                    static const std::unordered_map<std::string, ProductOperation> operations = {
+                        {"union", ProductOperation::Union},
+                        {"intersection", ProductOperation::Intersection},
+                        {"difference", ProductOperation::Difference},
+                        {"symmetric_difference", ProductOperation::SymmetricDifference}
+                    };
+                    auto it = operations.find(operation);
+                    is_valid = it != operations.end();
+                    if (is_valid) {
+                        result.reset(new DFA(DFAProduct(*left, *right, arena.resource()).build(it->second)));
+                    }
+                }
+                if (result) {
+                    is_empty = !findAccepted(*result, witness);
+                }
+            }
+            if (result) {
+                PhaseTimer::Scope phase(timer, "serialize");
+                dfa_str = result->toString();
+            }
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "DFA product error: " << e.what() << "\n";
+        }
+
+        std::string body;
+        {
+            PhaseTimer::Scope phase(timer, "escape");
+            body = "{\"is_valid\": " + std::string(is_valid ? "true" : "false") + ", ";
+            appendJsonField(body, "dfa", dfa_str);
+            body += ", \"is_empty\": " + std::string(is_empty ? "true" : "false");
+            if (!is_empty) {
+                body += ", \"witness\": \"" + escapeJson(witness) + "\"";
+            }
+        }
+        sendJsonResponse(body, timer);
+    }
+
+    void handleDFAInclusion(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::string left_str, right_str;
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            left_str = extractJsonField(request_body, "leftDefinition");
+            right_str = extractJsonField(request_body, "rightDefinition");
+        }
+
+        bool is_valid = false;
+        bool included = false;
+        std::string counterexample;
+        ResourceBudget budget;
+        RequestArena arena;
+        try {
+            std::unique_ptr<DFA> left, right;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                left.reset(new DFA(left_str, arena.resource()));
+                right.reset(new DFA(right_str, arena.resource()));
+            }
+            PhaseTimer::Scope phase(timer, "compute");
+            is_valid = left->validate() && right->validate();
+            included = is_valid && isSubset(*left, *right, counterexample);
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "DFA inclusion error: " << e.what() << "\n";
+        }
+
+        std::string body = "{\"is_valid\": " + std::string(is_valid ? "true" : "false") + ", ";
+        body += "\"included\": " + std::string(included ? "true" : "false");
+        if (is_valid && !included) {
+            body += ", \"counterexample\": \"" + escapeJson(counterexample) + "\"";
+        }
+        sendJsonResponse(body, timer);
+    }
+
+    // One input against every submitted DFA of an exercise, run together in a DFAEnsemble.
+    // Body: {"definitions": ["...", ...], "input": "..."}; the answer lists, per definition,
+    // whether it is a valid DFA and whether it accepts the input.
+    void handleDFAGrade(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::vector<std::string> definitions;
+        std::string input_str;
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            definitions = extractJsonStrings(request_body, "definitions");
+            input_str = unescapeJson(extractJsonField(request_body, "input"));
+        }
+        if (definitions.size() > MAX_GRADE_DEFINITIONS) {
+            definitions.resize(MAX_GRADE_DEFINITIONS);
+        }
+
+        std::vector<bool> valid(definitions.size(), false);
+        std::vector<bool> accepted(definitions.size(), false);
+        ResourceBudget budget;
+        RequestArena arena;
+        try {
+            std::vector<std::unique_ptr<DFA>> dfas;
+            std::vector<const DFA*> machines;
+            // Definition index of each machine in the ensemble; invalid ones are left out
+            std::vector<std::size_t> definition_of;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                for (std::size_t i = 0; i < definitions.size(); ++i) {
+                    try {
+                        std::unique_ptr<DFA> dfa(new DFA(definitions[i], arena.resource()));
+                        if (dfa->validate()) {
+                            valid[i] = true;
+                            definition_of.push_back(i);
+                            machines.push_back(dfa.get());
+                            dfas.push_back(std::move(dfa));
+                        }
+                    }
+                    catch (const BudgetExceeded&) {
+                        throw;
+                    }
+                    catch (const std::exception& e) {
+                        std::cerr << "DFA grading error in definition " << i << ": " << e.what() << "\n";
+                    }
+                }
+            }
+            PhaseTimer::Scope phase(timer, "compute");
+            DFAEnsemble ensemble(machines, arena.resource());
+            std::vector<std::uint64_t> bitmap = ensemble.accepts(input_str);
+            for (std::size_t j = 0; j < definition_of.size(); ++j) {
+                accepted[definition_of[j]] = DFAEnsemble::test(bitmap, j);
+            }
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "DFA grading error: " << e.what() << "\n";
+        }
+
+        std::string body;
+        {
+            PhaseTimer::Scope phase(timer, "serialize");
+            body = "{\"count\": " + std::to_string(definitions.size()) + ", \"valid\": [";
+            for (std::size_t i = 0; i < valid.size(); ++i) {
+                body += (i > 0 ? ", " : "") + std::string(valid[i] ? "true" : "false");
+            }
+            body += "], \"accepts\": [";
+            for (std::size_t i = 0; i < accepted.size(); ++i) {
+                body += (i > 0 ? ", " : "") + std::string(accepted[i] ? "true" : "false");
+            }
+            body += "]";
+        }
+        sendJsonResponse(body, timer);
     }
 
     void handleNFAConversion(std::istream& request_stream) {
-        std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
-        std::istringstream iss(request_body);
-        std::string line;
+        PhaseTimer timer;
         std::string nfa_str = "";
-        int flag = 0;
 
-        while (std::getline(iss, line)) {
-            if (line[0] == 'q') flag = 1;
-            if (flag) {
-                nfa_str = nfa_str + line + "\\n";
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            std::istringstream iss(request_body);
+            std::string line;
+            int flag = 0;
+
+            while (std::getline(iss, line)) {
+                if (line[0] == 'q') flag = 1;
+                if (flag) {
+                    nfa_str = nfa_str + line + "\\n";
+                }
             }
-        }
 
-        nfa_str.erase(nfa_str.length() - 2);
-        nfa_str += "-";
+            nfa_str.erase(nfa_str.length() - 2);
+            nfa_str += "-";
+        }
 
         std::string dfa_str;
+        if (!cachedResult(ResultKind::NfaToDfa, nfa_str, dfa_str, timer)) {
+            ResourceBudget budget;
+            RequestArena arena;
+            try {
+                std::unique_ptr<NFA> nfa;
+                std::unique_ptr<DFA> dfa;
+                bool valid;
+                {
+                    PhaseTimer::Scope phase(timer, "build");
+                    nfa.reset(new NFA(nfa_str, arena.resource()));
+                    valid = nfa->validate();
+                }
+                {
+                    PhaseTimer::Scope phase(timer, "reduce");
+                    nfa.reset(new NFA(nfa->reduced()));
+                }
+                {
+                    PhaseTimer::Scope phase(timer, "compute");
+                    dfa.reset(new DFA(nfa->toDFA()));
+                }
+                PhaseTimer::Scope phase(timer, "serialize");
+                dfa_str = dfa->toString();
+                if (valid) {
+                    results_.store(ResultKind::NfaToDfa, nfa_str, dfa_str);
+                }
+            }
+            catch (const BudgetExceeded& e) {
+                sendLimitExceeded(e, timer);
+                return;
+            }
+            catch (const std::exception& e) {
+                std::cerr << "NFA to DFA conversion error: " << e.what() << "\n";
+            }
+        }
+
+        std::string body;
+        {
+            PhaseTimer::Scope phase(timer, "escape");
+            body = "{";
+            appendJsonField(body, "dfa", dfa_str);
+        }
+        sendJsonResponse(body, timer);
+    }
+
+    void handleNFAInclusion(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::string left_str, right_str;
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            left_str = nfaDefinition(extractJsonField(request_body, "leftDefinition"));
+            right_str = nfaDefinition(extractJsonField(request_body, "rightDefinition"));
+        }
+
+        bool is_valid = false;
+        bool included = false;
+        std::string counterexample;
+        ResourceBudget budget;
+        RequestArena arena;
+        try {
+            std::unique_ptr<NFA> left, right;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                left.reset(new NFA(left_str, arena.resource()));
+                right.reset(new NFA(right_str, arena.resource()));
+            }
+            PhaseTimer::Scope phase(timer, "compute");
+            is_valid = left->validate() && right->validate();
+            included = is_valid && isSubset(*left, *right, counterexample);
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "NFA inclusion error: " << e.what() << "\n";
+        }
+
+        std::string body = "{\"is_valid\": " + std::string(is_valid ? "true" : "false") + ", ";
+        body += "\"included\": " + std::string(included ? "true" : "false");
+        if (is_valid && !included) {
+            body += ", \"counterexample\": \"" + escapeJson(counterexample) + "\"";
+        }
+        sendJsonResponse(body, timer);
+    }
+
+    void handleNFAUniversality(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::string nfa_str;
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            nfa_str = nfaDefinition(extractJsonField(request_body, "nfaDefinition"));
+        }
+
+        bool is_valid = false;
+        bool universal = false;
+        std::string counterexample;
+        ResourceBudget budget;
+        RequestArena arena;
+        try {
+            std::unique_ptr<NFA> nfa;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                nfa.reset(new NFA(nfa_str, arena.resource()));
+            }
+            PhaseTimer::Scope phase(timer, "compute");
+            is_valid = nfa->validate();
+            universal = is_valid && isUniversal(*nfa, counterexample);
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "NFA universality error: " << e.what() << "\n";
+        }
+
+        std::string body = "{\"is_valid\": " + std::string(is_valid ? "true" : "false") + ", ";
+        body += "\"universal\": " + std::string(universal ? "true" : "false");
+        if (is_valid && !universal) {
+            body += ", \"counterexample\": \"" + escapeJson(counterexample) + "\"";
+        }
+        sendJsonResponse(body, timer);
+    }
+
+    void handleSearch(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::string kind, definition, text;
+        std::size_t limit = MAX_SEARCH_MATCHES;
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            kind = extractJsonField(request_body, "kind");
+            definition = extractJsonField(request_body, "definition");
+            text = unescapeJson(extractJsonField(request_body, "text"));
+            std::string limit_str = extractJsonField(request_body, "limit");
+            if (!limit_str.empty()) {
+                limit = std::min<std::size_t>(std::strtoull(limit_str.c_str(), nullptr, 10), MAX_SEARCH_MATCHES);
+            }
+        }
+
+        if (kind != "dfa" && kind != "nfa") {
+            sendJsonResponse("{\"error\": \"kind must be dfa or nfa\"", timer, "400 Bad Request");
+            return;
+        }
+
+        bool is_valid = false;
+        bool truncated = false;
+        std::string prefix;
+        std::vector<SearchMatch> matches;
+        ResourceBudget budget;
+        RequestArena arena;
         try {
-            NFA nfa(nfa_str);
-            DFA dfa(nfa.toDFA());
-            dfa_str = dfa.toString();
-            for (int i = 0; i < dfa_str.length(); i++) {
-                if (dfa_str[i] == 'n') dfa_str[i] = '\n';
+            std::unique_ptr<DFA> dfa;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                if (kind == "dfa") {
+                    dfa.reset(new DFA(definition, arena.resource()));
+                    is_valid = dfa->validate();
+                }
+                else {
+                    NFA nfa(nfaDefinition(definition), arena.resource());
+                    is_valid = nfa.validate();
+                    if (is_valid) {
+                        dfa.reset(new DFA(nfa.reduced().toDFA()));
+                    }
+                }
             }
-            size_t index = 0;
-            while (true) {
-                index = dfa_str.find("\\", index);
-                if (index == std::string::npos) break;
-                dfa_str.replace(index, 1, "");
+            if (is_valid) {
+                PhaseTimer::Scope phase(timer, "compute");
+                DFASearcher searcher(*dfa);
+                prefix = searcher.prefix();
+                matches = searcher.feed(text);
+                const std::vector<SearchMatch>& rest = searcher.finish();
+                matches.insert(matches.end(), rest.begin(), rest.end());
+                if (matches.size() > limit) {
+                    matches.resize(limit);
+                    truncated = true;
+                }
             }
-            dfa_str.erase(dfa_str.find_last_of("0"));
-            dfa_str.erase(dfa_str.find_last_of("0"));
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
         }
         catch (const std::exception& e) {
-            std::cerr << "NFA to DFA conversion error: " << e.what() << "\n";
+            std::cerr << "Search error: " << e.what() << "\n";
         }
 
-        std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n";
-        response += "{\"dfa\": \"" + escapeJson(dfa_str) + "\"}";
-        sendResponse(response);
+        std::string body;
+        {
+            PhaseTimer::Scope phase(timer, "serialize");
+            body = "{\"is_valid\": " + std::string(is_valid ? "true" : "false") + ", ";
+            appendJsonField(body, "prefix", prefix);
+            body += ", \"matches\": [";
+            for (std::size_t i = 0; i < matches.size(); ++i) {
+                body += (i > 0 ? ", [" : "[") + std::to_string(matches[i].start) + ", " + std::to_string(matches[i].end) + "]";
+            }
+            body += "], \"truncated\": " + std::string(truncated ? "true" : "false");
+        }
+        sendJsonResponse(body, timer);
+    }
+
+    void handleSessionCreate(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::string kind, definition;
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            kind = extractJsonField(request_body, "kind");
+            definition = extractJsonField(request_body, "definition");
+        }
+
+        if (kind != "dfa" && kind != "nfa") {
+            sendJsonResponse("{\"error\": \"kind must be dfa or nfa\"", timer, "400 Bad Request");
+            return;
+        }
+
+        std::shared_ptr<EditSession> session;
+        std::string session_id;
+        ResourceBudget budget;
+        try {
+            PhaseTimer::Scope phase(timer, "build");
+            session = kind == "dfa"
+                ? std::make_shared<EditSession>(EditSession::Kind::DFA, definition)
+                : std::make_shared<EditSession>(EditSession::Kind::NFA, nfaDefinition(definition));
+            session_id = sessions_.add(session);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Session creation error: " << e.what() << "\n";
+            sendJsonResponse("{\"error\": \"could not build the machine\"", timer, "400 Bad Request");
+            return;
+        }
+
+        sendSessionState(session_id, *session, timer);
+    }
+
+    void handleSessionEdit(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::string session_id;
+        EditOperation operation;
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            session_id = extractJsonField(request_body, "session");
+            operation.op = extractJsonField(request_body, "op");
+            operation.state = extractJsonField(request_body, "state");
+            operation.symbol = extractJsonField(request_body, "symbol");
+            operation.target = extractJsonField(request_body, "target");
+        }
+
+        std::shared_ptr<EditSession> session = sessions_.find(session_id);
+        if (!session) {
+            sendJsonResponse("{\"error\": \"unknown session\"", timer, "404 Not Found");
+            return;
+        }
+
+        std::lock_guard<std::mutex> guard(session->mutex());
+        std::string error;
+        bool applied;
+        {
+            PhaseTimer::Scope phase(timer, "edit");
+            applied = session->apply(operation, error);
+        }
+        if (!applied) {
+            sendJsonResponse("{\"error\": \"" + escapeJson(error) + "\"", timer, "400 Bad Request");
+            return;
+        }
+
+        sendSessionState(session_id, *session, timer);
+    }
+
+    void handleSessionClose(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::string session_id;
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            session_id = extractJsonField(request_body, "session");
+        }
+
+        bool closed = sessions_.remove(session_id);
+        sendJsonResponse("{\"closed\": " + std::string(closed ? "true" : "false"), timer);
+    }
+
+    // Recompiles the session's machine and replies with it; the caller holds the session lock
+    void sendSessionState(const std::string& session_id, EditSession& session, PhaseTimer& timer) {
+        std::string dfa_str;
+        ResourceBudget budget;
+        try {
+            std::unique_ptr<DFA> dfa;
+            {
+                PhaseTimer::Scope phase(timer, "compute");
+                dfa.reset(new DFA(session.compiled()));
+            }
+            PhaseTimer::Scope phase(timer, "serialize");
+            dfa_str = dfa->toString();
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
+        }
+
+        std::string body;
+        {
+            PhaseTimer::Scope phase(timer, "escape");
+            body = "{\"session\": \"" + session_id + "\", ";
+            body += "\"version\": " + std::to_string(session.version()) + ", ";
+            body += "\"is_valid\": " + std::string(session.validate() ? "true" : "false") + ", ";
+            body += "\"recomputed_rows\": " + std::to_string(session.recomputedRows()) + ", ";
+            appendJsonField(body, "dfa", dfa_str);
+        }
+        sendJsonResponse(body, timer);
     }
 
     void handleCFGValidation(std::istream& request_stream) {
-        std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
-        std::istringstream iss(request_body);
+        PhaseTimer timer;
         std::string cfg_str;
-        std::string line;
 
-        while (std::getline(iss, line)) {
-            cfg_str = extractJsonValue(line);
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            cfg_str = cfgDefinition(request_stream);
         }
 
         bool is_valid_cfg = false;
+        bool analyzed = false;
+        std::string parser_kind;
+        bool is_empty = false;
+        bool is_finite = false;
+        std::vector<std::string> useless;
+        ResourceBudget budget;
+        RequestArena arena;
         try {
-            CFG cfg(cfg_str);
-            is_valid_cfg = cfg.validate();
+            std::unique_ptr<CFG> cfg;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                cfg.reset(new CFG(cfg_str, arena.resource()));
+            }
+            PhaseTimer::Scope phase(timer, "compute");
+            is_valid_cfg = cfg->validate();
+            // The parse tables and analyses are extras; running out of budget on them leaves
+            // their fields out instead of losing the validity answer
+            if (is_valid_cfg) {
+                try {
+                    parser_kind = cfg->parserKind();
+                    is_empty = cfg->languageIsEmpty();
+                    is_finite = cfg->languageIsFinite();
+                    for (std::uint32_t variable = 0; variable < cfg->variableCount(); ++variable) {
+                        if (!cfg->analysis().isUseful(variable)) {
+                            useless.push_back(std::string(cfg->symbolName(variable)));
+                        }
+                    }
+                    analyzed = true;
+                }
+                catch (const BudgetExceeded&) {
+                    analyzed = false;
+                }
+            }
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
         }
         catch (const std::exception& e) {
             std::cerr << "CFG validation error: " << e.what() << "\n";
@@ -192,34 +1397,252 @@ private:
         if (cfg_str.find(">") == std::string::npos){
             is_valid_cfg = 0;
         }
-        std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n";
-        response += "{\"is_valid_cfg\": " + std::to_string(is_valid_cfg) + "}";
-        sendResponse(response);
+        std::string body = "{\"is_valid_cfg\": " + std::to_string(is_valid_cfg);
+        if (is_valid_cfg && analyzed) {
+            body += ", \"parser\": \"" + parser_kind + "\"";
+            body += ", \"empty\": " + std::string(is_empty ? "true" : "false");
+            body += ", \"finite\": " + std::string(is_finite ? "true" : "false");
+            body += ", \"useless\": " + jsonNames(useless);
+        }
+        sendJsonResponse(body, timer);
+    }
+
+    // Chomsky and Greibach normal forms, on request only since they can dwarf the grammar
+    void handleCFGNormalization(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::string cfg_str;
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            cfg_str = cfgDefinition(request_stream);
+        }
+
+        bool is_valid_cfg = false;
+        std::string cnf_str;
+        std::string gnf_str;
+        ResourceBudget budget;
+        RequestArena arena;
+        try {
+            std::unique_ptr<CFG> cfg;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                cfg.reset(new CFG(cfg_str, arena.resource()));
+            }
+            PhaseTimer::Scope phase(timer, "compute");
+            is_valid_cfg = cfg->validate() && cfg_str.find(">") != std::string::npos;
+            if (is_valid_cfg) {
+                cnf_str = cfg->chomskyNormalForm().toString();
+
+                // Greibach form can be exponentially larger; it gets its own smaller budget, cut
+                // from what is left of the request's, and is left out rather than failing the
+                // whole request
+                BudgetLimits gnf_limits = ResourceBudget::remaining();
+                gnf_limits.max_states = std::min(gnf_limits.max_states, MAX_GNF_RULES);
+                try {
+                    ResourceBudget gnf_budget(gnf_limits);
+                    gnf_str = cfg->greibachNormalForm().toString();
+                }
+                catch (const BudgetExceeded&) {
+                    gnf_str.clear();
+                }
+            }
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "CFG normalization error: " << e.what() << "\n";
+            is_valid_cfg = false;
+        }
+
+        std::string body = "{\"is_valid_cfg\": " + std::to_string(is_valid_cfg);
+        if (is_valid_cfg) {
+            body += ", ";
+            appendJsonField(body, "cnf", cnf_str);
+            if (!gnf_str.empty()) {
+                body += ", ";
+                appendJsonField(body, "gnf", gnf_str);
+            }
+        }
+        sendJsonResponse(body, timer);
+    }
+
+    void handleCFGParse(std::istream& request_stream) {
+        PhaseTimer timer;
+        std::string definition, input;
+        std::uint64_t tree_limit = 1;
+
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            definition = unescapeJson(extractJsonField(request_body, "definition"));
+            input = unescapeJson(extractJsonField(request_body, "input"));
+            std::string trees_str = extractJsonField(request_body, "trees");
+            if (!trees_str.empty()) {
+                tree_limit = std::min<std::uint64_t>(std::strtoull(trees_str.c_str(), nullptr, 10), MAX_PARSE_TREES);
+            }
+        }
+
+        bool is_valid = false;
+        std::string body;
+        ResourceBudget budget;
+        RequestArena arena;
+        try {
+            std::unique_ptr<CFG> cfg;
+            std::unique_ptr<ParseForest> forest;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                cfg.reset(new CFG(definition, arena.resource()));
+                is_valid = cfg->validate();
+            }
+            if (is_valid) {
+                PhaseTimer::Scope phase(timer, "compute");
+                forest = cfg->parseForest(input, arena.resource());
+            }
+
+            PhaseTimer::Scope phase(timer, "serialize");
+            body = "{\"is_valid\": " + std::string(is_valid ? "true" : "false");
+            bool accepted = forest && forest->accepted();
+            body += ", \"accepted\": " + std::string(accepted ? "true" : "false");
+            if (accepted) {
+                // The count is a string since it easily outgrows a JSON number
+                body += ", \"cyclic\": " + std::string(forest->isCyclic() ? "true" : "false");
+                body += ", \"count\": \"" + forest->treeCount().toString() + "\"";
+                body += ", \"trees\": [";
+                for (std::uint64_t index = 0; index < tree_limit; ++index) {
+                    std::string tree = forest->treeJson(index);
+                    if (tree == "null") {
+                        break;
+                    }
+                    body += (index > 0 ? ", " : "") + tree;
+                }
+                body += "], \"forest\": " + forest->forestJson();
+            }
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "CFG parse error: " << e.what() << "\n";
+            body = "{\"is_valid\": false, \"accepted\": false";
+        }
+        sendJsonResponse(body, timer);
     }
 
     void handlePDAConversion(std::istream& request_stream) {
-        std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
-        std::istringstream iss(request_body);
-        std::string line;
+        PhaseTimer timer;
         std::string pda_str;
 
-        while (std::getline(iss, line)) {
-            pda_str += line + "\n";
+        {
+            PhaseTimer::Scope phase(timer, "parse");
+            std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+            std::istringstream iss(request_body);
+            std::string line;
+
+            while (std::getline(iss, line)) {
+                pda_str += line + "\n";
+            }
         }
 
         std::string cfg_str;
+        bool deterministic = false;
+        // Not cached: PDA::toCFG is still a stub, and its empty grammar is not a result to keep
+        ResourceBudget budget;
+        RequestArena arena;
         try {
-            PDA pda(pda_str);
-            CFG cfg = pda.toCFG();
-            cfg_str = cfg.toString();
+            std::unique_ptr<PDA> pda;
+            {
+                PhaseTimer::Scope phase(timer, "build");
+                pda.reset(new PDA(pda_str, arena.resource()));
+                deterministic = pda->isDeterministic();
+            }
+            std::unique_ptr<CFG> cfg;
+            {
+                PhaseTimer::Scope phase(timer, "compute");
+                cfg.reset(new CFG(pda->toCFG()));
+            }
+            PhaseTimer::Scope phase(timer, "serialize");
+            cfg_str = cfg->toString();
+        }
+        catch (const BudgetExceeded& e) {
+            sendLimitExceeded(e, timer);
+            return;
         }
         catch (const std::exception& e) {
             std::cerr << "PDA to CFG conversion error: " << e.what() << "\n";
         }
 
-        std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n\r\n";
-        response += "{\"cfg\": \"" + escapeJson(cfg_str) + "\"}";
-        sendResponse(response);
+        std::string body;
+        {
+            PhaseTimer::Scope phase(timer, "escape");
+            body = "{";
+            appendJsonField(body, "cfg", cfg_str);
+            body += ", \"deterministic\": " + std::string(deterministic ? "true" : "false");
+        }
+        sendJsonResponse(body, timer);
+    }
+
+    // Looks up a conversion result from an earlier request or an earlier run of the server;
+    // only successful conversions of valid definitions are stored, so a hit is always a
+    // complete result
+    bool cachedResult(ResultKind kind, const std::string& definition, std::string& value, PhaseTimer& timer) {
+        PhaseTimer::Scope phase(timer, "cache");
+        bool hit = results_.lookup(kind, definition, value);
+        Metrics::count(hit ? EngineCounter::ResultCacheHits : EngineCounter::ResultCacheMisses);
+        return hit;
+    }
+
+    // The /cfg routes take the definition as the value on the last line of the body
+    std::string cfgDefinition(std::istream& request_stream) {
+        std::string request_body((std::istreambuf_iterator<char>(request_stream)), std::istreambuf_iterator<char>());
+        std::istringstream iss(request_body);
+        std::string line;
+        std::string cfg_str;
+
+        while (std::getline(iss, line)) {
+            cfg_str = extractJsonValue(line);
+        }
+        return cfg_str;
+    }
+
+    // Closes the JSON object in body, adding the phase breakdown as a header and a "timings" field
+    void sendJsonResponse(std::string body, const PhaseTimer& timer, const std::string& status = "200 OK") {
+        std::string headers = "HTTP/1.1 " + status + "\r\nContent-Type: application/json\r\n";
+        if (!timer.empty()) {
+            headers += "Server-Timing: " + timer.header() + "\r\n";
+            body += ", \"timings\": " + timer.json();
+        }
+        body += '}';
+        sendBody(std::move(headers), std::move(body));
+    }
+
+    // Sends headers (status line included, blank line not) and body as one buffer, compressing the
+    // body first when the client accepts it and it is large enough to be worth it
+    void sendBody(std::string headers, std::string body) {
+        std::string compressed;
+        if (body.size() >= MIN_COMPRESSED_SIZE && compressBody(body, accept_encoding_, compressed)) {
+            headers += "Content-Encoding: " + std::string(encodingName(accept_encoding_)) + "\r\n";
+            body.swap(compressed);
+        }
+        headers += "Vary: Accept-Encoding\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+
+        std::string response;
+        response.reserve(headers.size() + body.size());
+        response += headers;
+        response += body;
+        sendResponse(std::move(response));
+    }
+
+    // The request hit one of its resource limits; report which one and how far it got
+    void sendLimitExceeded(const BudgetExceeded& e, const PhaseTimer& timer) {
+        Metrics::count(EngineCounter::BudgetAborts);
+        std::string body = "{\"error\": \"limit_exceeded\", \"limit\": \"" + e.limit() + "\", ";
+        body += "\"states\": " + std::to_string(e.states()) + ", ";
+        body += "\"memory_bytes\": " + std::to_string(e.memory()) + ", ";
+        body += "\"elapsed_ms\": " + std::to_string(e.elapsedMicros() / 1000.0);
+        sendJsonResponse(body, timer, "422 Unprocessable Entity");
     }
 
     void handleNotFound() {
@@ -228,15 +1651,16 @@ private:
         sendResponse(response);
     }
 
+    void serveMetrics() {
+        sendBody("HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n", Metrics::instance().renderPrometheus());
+    }
+
     void serveFile(const std::string& file_path) {
         std::ifstream file(file_path, std::ios::binary);
         if (file.is_open()) {
             std::string content_type = getContentType(file_path);
-            std::ostringstream response_stream;
-            response_stream << "HTTP/1.1 200 OK\r\n";
-            response_stream << "Content-Type: " << content_type << "\r\n\r\n";
-            response_stream << file.rdbuf();
-            sendResponse(response_stream.str());
+            std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            sendBody("HTTP/1.1 200 OK\r\nContent-Type: " + content_type + "\r\n", std::move(content));
             file.close();
         }
         else {
@@ -260,47 +1684,85 @@ private:
         return "application/octet-stream";
     }
 
+    // Collapse static file paths into one label so the metric cardinality stays bounded
+    std::string routeLabel(const std::string& method, const std::string& path) {
+        if (method == "GET") {
+            return path == "/" || path == "/metrics" || path == "/trace" ? path : "static";
+        }
+        static const std::unordered_set<std::string> post_routes = {
+            "/dfa", "/dfa/count", "/dfa/enumerate", "/dfa/codegen", "/dfa/product", "/dfa/inclusion",
+            "/dfa/grade", "/nfa", "/nfa/inclusion", "/nfa/universality", "/search", "/session/create", "/session/edit",
+            "/session/close", "/cfg", "/cfg/parse", "/cfg/normalize", "/pda"
+        };
+        if (method == "POST" && post_routes.count(path)) {
+            return path;
+        }
+        return "other";
+    }
+
     std::string extractJsonValue(const std::string& line) {
         std::size_t start_pos = line.find(":") + 1;
         std::size_t end_pos = line.find_last_of("\"");
         return line.substr(start_pos + 1, end_pos - start_pos - 1);
     }
 
-    std::string escapeJson(const std::string& str) {
-        std::ostringstream escaped;
-        for (char c : str) {
-            switch (c) {
-            case '\\': escaped << "\\\\"; break;
-            case '"': escaped << "\\\""; break;
-            case '\b': escaped << "\\b"; break;
-            case '\f': escaped << "\\f"; break;
-            case '\n': escaped << "\\n"; break;
-            case '\r': escaped << "\\r"; break;
-            case '\t': escaped << "\\t"; break;
-            default: escaped << c; break;
-            }
-        }
-        return escaped.str();
-    }
+    void sendResponse(std::string response) {
+        // The status code sits between the first two spaces of the status line
+        int status = std::atoi(response.c_str() + response.find(' ') + 1);
 
-    void sendResponse(const std::string& response) {
-        boost::asio::async_write(socket_, boost::asio::buffer(response),
-            [this](boost::system::error_code ec, std::size_t length) {
-                if (!ec) {
-                    socket_.shutdown(tcp::socket::shutdown_both);
-                    socket_.close();
-                }
+        // Keep the payload and connection alive until the asynchronous write has completed
+        auto payload = std::make_shared<std::string>(std::move(response));
+        auto connection = current_;
+        armTimeout(connection);
+        boost::asio::async_write(connection->socket, boost::asio::buffer(*payload),
+            [this, connection, status, payload](boost::system::error_code, std::size_t length) {
+                auto elapsed = std::chrono::steady_clock::now() - request_start_;
+                Metrics::instance().recordRequest(route_, status,
+                    std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), bytes_in_, length);
+
+                boost::system::error_code ignored;
+                connection->timer.cancel();
+                connection->socket.shutdown(tcp::socket::shutdown_both, ignored);
+                connection->socket.close(ignored);
+                current_.reset();
+                serveNext();
             });
     }
 
+    // Counts grow by up to log10(|alphabet|) digits per symbol, so very long lengths are clamped
+    static constexpr std::uint64_t MAX_COUNT_LENGTH = 10000;
+    static constexpr std::size_t MAX_ENUMERATION_LIMIT = 1000;
+    static constexpr std::size_t MAX_SEARCH_MATCHES = 10000;
+    // Rules a Greibach normal form may grow to before /cfg leaves it out
+    static constexpr std::uint64_t MAX_GNF_RULES = 20000;
+    static constexpr std::uint64_t MAX_PARSE_TREES = 100;
+    static constexpr std::size_t MAX_GRADE_DEFINITIONS = 10000;
+    // Below this a compressed body saves less than the extra header costs
+    static constexpr std::size_t MIN_COMPRESSED_SIZE = 1024;
+
+    // Largest request head and body read into a connection's buffer
+    static constexpr std::size_t MAX_REQUEST_SIZE = std::size_t(4) << 20;
+    static constexpr std::chrono::seconds REQUEST_TIMEOUT{ 10 };
+
     tcp::acceptor acceptor_;
-    tcp::socket socket_;
+    AdmissionControl admission_;
+    std::deque<std::shared_ptr<Connection>> cheap_queue_;
+    std::deque<std::shared_ptr<Connection>> expensive_queue_;
+    // The request being served, if any
+    std::shared_ptr<Connection> current_;
+    EditSessionStore sessions_;
+    // Conversion results kept across restarts
+    ResultCache results_;
+    std::chrono::steady_clock::time_point request_start_;
+    std::string route_;
+    std::size_t bytes_in_ = 0;
+    ContentEncoding accept_encoding_ = ContentEncoding::Identity;
 };
 
 int main() {
     try {
         boost::asio::io_context io_context;
-        HttpServer server(io_context, 8080);
+        HttpServer server(io_context, 8080, AdmissionLimits::fromEnvironment(), ResultCacheOptions::fromEnvironment());
         io_context.run();
     }
     catch (std::exception& e) {
@@ -0,0 +1,155 @@
+#include "metrics.hpp"
+#include <sstream>
+#include <map>
+
+int LatencyHistogram::bucketIndex(std::uint64_t value_us) {
+    if (value_us < static_cast<std::uint64_t>(SUB_BUCKETS)) {
+        return static_cast<int>(value_us);
+    }
+
+    int msb = 63 - __builtin_clzll(value_us);
+    int magnitude = msb - SUB_BUCKET_BITS + 1;
+    int sub_bucket = static_cast<int>((value_us >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    int index = magnitude * SUB_BUCKETS + sub_bucket;
+    return index < BUCKET_COUNT ? index : BUCKET_COUNT - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t value_us) {
+    buckets[bucketIndex(value_us)]++;
+    total++;
+    total_us += value_us;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < BUCKET_COUNT; i++) {
+        buckets[i] += other.buckets[i];
+    }
+    total += other.total;
+    total_us += other.total_us;
+}
+
+std::uint64_t LatencyHistogram::countAtOrBelow(std::uint64_t value_us) const {
+    std::uint64_t result = 0;
+    int last = bucketIndex(value_us);
+    for (int i = 0; i <= last; i++) {
+        result += buckets[i];
+    }
+    return result;
+}
+
+Metrics& Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::Shard& Metrics::localShard() {
+    thread_local std::shared_ptr<Shard> shard;
+    if (!shard) {
+        shard = std::make_shared<Shard>();
+        std::lock_guard<std::mutex> lock(shards_mutex);
+        shards.push_back(shard);
+    }
+    return *shard;
+}
+
+void Metrics::recordRequest(const std::string& route, int status, std::uint64_t latency_us,
+    std::uint64_t bytes_in, std::uint64_t bytes_out) {
+    Shard& shard = localShard();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    RouteStats& stats = shard.routes[route];
+    stats.requests++;
+    stats.bytes_in += bytes_in;
+    stats.bytes_out += bytes_out;
+    stats.status_codes[status]++;
+    stats.latency.record(latency_us);
+}
+
+void Metrics::count(EngineCounter counter, std::uint64_t n) {
+    // Only the owning thread writes its shard, so a relaxed load/store pair is enough
+    std::atomic<std::uint64_t>& value = instance().localShard().engine[static_cast<size_t>(counter)];
+    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+std::string Metrics::renderPrometheus() const {
+    std::map<std::string, RouteStats> routes;
+    std::array<std::uint64_t, static_cast<size_t>(EngineCounter::Count)> engine{};
+
+    // Aggregate every thread's shard
+    {
+        std::lock_guard<std::mutex> lock(shards_mutex);
+        for (const auto& shard : shards) {
+            std::lock_guard<std::mutex> shard_lock(shard->mutex);
+            for (const auto& route_entry : shard->routes) {
+                RouteStats& total = routes[route_entry.first];
+                const RouteStats& stats = route_entry.second;
+                total.requests += stats.requests;
+                total.bytes_in += stats.bytes_in;
+                total.bytes_out += stats.bytes_out;
+                for (const auto& status_entry : stats.status_codes) {
+                    total.status_codes[status_entry.first] += status_entry.second;
+                }
+                total.latency.merge(stats.latency);
+            }
+            for (size_t i = 0; i < engine.size(); i++) {
+                engine[i] += shard->engine[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::ostringstream oss;
+
+    oss << "# HELP toc_http_requests_total HTTP requests by route and status code.\n";
+    oss << "# TYPE toc_http_requests_total counter\n";
+    for (const auto& route_entry : routes) {
+        std::map<int, std::uint64_t> status_codes(route_entry.second.status_codes.begin(), route_entry.second.status_codes.end());
+        for (const auto& status_entry : status_codes) {
+            oss << "toc_http_requests_total{route=\"" << route_entry.first << "\",code=\"" << status_entry.first << "\"} "
+                << status_entry.second << "\n";
+        }
+    }
+
+    oss << "# HELP toc_http_request_bytes_total Bytes received per route.\n";
+    oss << "# TYPE toc_http_request_bytes_total counter\n";
+    for (const auto& route_entry : routes) {
+        oss << "toc_http_request_bytes_total{route=\"" << route_entry.first << "\"} " << route_entry.second.bytes_in << "\n";
+    }
+
+    oss << "# HELP toc_http_response_bytes_total Bytes sent per route.\n";
+    oss << "# TYPE toc_http_response_bytes_total counter\n";
+    for (const auto& route_entry : routes) {
+        oss << "toc_http_response_bytes_total{route=\"" << route_entry.first << "\"} " << route_entry.second.bytes_out << "\n";
+    }
+
+    // Export the fine-grained histogram at power-of-two boundaries from 64us to ~67s
+    oss << "# HELP toc_http_request_duration_seconds Request latency per route.\n";
+    oss << "# TYPE toc_http_request_duration_seconds histogram\n";
+    for (const auto& route_entry : routes) {
+        const std::string& route = route_entry.first;
+        const LatencyHistogram& latency = route_entry.second.latency;
+
+        for (int shift = 6; shift <= 26; shift += 2) {
+            std::uint64_t bound_us = std::uint64_t(1) << shift;
+            oss << "toc_http_request_duration_seconds_bucket{route=\"" << route << "\",le=\"" << bound_us / 1e6 << "\"} "
+                << latency.countAtOrBelow(bound_us - 1) << "\n";
+        }
+        oss << "toc_http_request_duration_seconds_bucket{route=\"" << route << "\",le=\"+Inf\"} " << latency.count() << "\n";
+        oss << "toc_http_request_duration_seconds_sum{route=\"" << route << "\"} " << latency.sum() / 1e6 << "\n";
+        oss << "toc_http_request_duration_seconds_count{route=\"" << route << "\"} " << latency.count() << "\n";
+    }
+
+    const char* engine_names[] = {
+        "toc_dfa_states_built_total",
+        "toc_closure_computations_total",
+        "toc_closure_cache_hits_total",
+        "toc_budget_exceeded_total",
+        "toc_result_cache_hits_total",
+        "toc_result_cache_misses_total"
+    };
+    for (size_t i = 0; i < engine.size(); i++) {
+        oss << "# TYPE " << engine_names[i] << " counter\n";
+        oss << engine_names[i] << " " << engine[i] << "\n";
+    }
+
+    return oss.str();
+}
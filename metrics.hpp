@@ -0,0 +1,80 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <string>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// Engine-level counters incremented from inside the automaton code
+enum class EngineCounter {
+    DfaStatesBuilt,
+    ClosureComputations,
+    ClosureCacheHits,
+    BudgetAborts,
+    ResultCacheHits,
+    ResultCacheMisses,
+    Count
+};
+
+// Log-linear latency histogram (HDR style): every power of two is split into
+// a fixed number of linear sub-buckets, so relative error stays bounded.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAGNITUDES = 40;
+    static constexpr int BUCKET_COUNT = MAGNITUDES * SUB_BUCKETS;
+
+    void record(std::uint64_t value_us);
+    void merge(const LatencyHistogram& other);
+    std::uint64_t countAtOrBelow(std::uint64_t value_us) const;
+    std::uint64_t count() const { return total; }
+    std::uint64_t sum() const { return total_us; }
+
+    static int bucketIndex(std::uint64_t value_us);
+
+private:
+    std::array<std::uint64_t, BUCKET_COUNT> buckets{};
+    std::uint64_t total = 0;
+    std::uint64_t total_us = 0;
+};
+
+struct RouteStats {
+    std::uint64_t requests = 0;
+    std::uint64_t bytes_in = 0;
+    std::uint64_t bytes_out = 0;
+    std::unordered_map<int, std::uint64_t> status_codes;
+    LatencyHistogram latency;
+};
+
+class Metrics {
+public:
+    static Metrics& instance();
+
+    // Both calls only touch the calling thread's shard; shards are summed on scrape
+    void recordRequest(const std::string& route, int status, std::uint64_t latency_us,
+        std::uint64_t bytes_in, std::uint64_t bytes_out);
+    static void count(EngineCounter counter, std::uint64_t n = 1);
+
+    std::string renderPrometheus() const;
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, RouteStats> routes;
+        std::array<std::atomic<std::uint64_t>, static_cast<size_t>(EngineCounter::Count)> engine{};
+    };
+
+    Metrics() {}
+    Shard& localShard();
+
+    mutable std::mutex shards_mutex;
+    std::vector<std::shared_ptr<Shard>> shards;
+};
+
+#endif
@@ -2,9 +2,13 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
-#include <queue>
+#include <unordered_map>
+#include <map>
+#include "metrics.hpp"
+#include "budget.hpp"
 
-NFA::NFA(const std::string& nfa_str) {
+NFA::NFA(const std::string& nfa_str, std::pmr::memory_resource* memory)
+    : Automaton(memory), transitions(memory) {
     std::istringstream iss(nfa_str);
     std::string line;
 
@@ -18,82 +22,43 @@ NFA::NFA(const std::string& nfa_str) {
     parseAcceptStates(line);
     std::getline(iss, line);
     parseTransitions(line);
+    tokenizer.build(alphabet);
 }
 
 bool NFA::validate() const {
-    // Check if the start state is a valid state
-    if (std::find(states.begin(), states.end(), start_state) == states.end()) {
-        return false;
-    }
-
-    // Check if all accept states are valid states
-    for (const std::string& accept_state : accept_states) {
-        if (std::find(states.begin(), states.end(), accept_state) == states.end()) {
-            return false;
-        }
-    }
-
-    // Check if all transitions are valid
-    for (const auto& state_transitions : transitions) {
-        const std::string& state = state_transitions.first;
-        const auto& symbol_next_states = state_transitions.second;
-
-        // Check if the state is a valid state
-        if (std::find(states.begin(), states.end(), state) == states.end()) {
-            return false;
-        }
-
-        // Check if all transition symbols are valid alphabet symbols or epsilon
-        for (const auto& symbol_states : symbol_next_states) {
-            const std::string& symbol = symbol_states.first;
-
-            if (symbol != "" && alphabet.find(symbol) == alphabet.end()) {
-                return false;
-            }
-
-            // Check if all next states are valid states
-            for (const std::string& next_state : symbol_states.second) {
-                if (std::find(states.begin(), states.end(), next_state) == states.end()) {
-                    return false;
-                }
-            }
-        }
-    }
-
-    return true;
+    // Start state, accept states and every transition were resolved to ids
+    // while parsing, so all that is left is to check nothing failed to resolve
+    return validateNames();
 }
 
 bool NFA::accepts(const std::string& input_str) const {
-    std::unordered_set<std::string> current_states = epsilonClosure(start_state);
-
-    for (char symbol : input_str) {
-        std::string symbol_str(1, symbol);
+    if (start_state == NO_STATE) {
+        return false;
+    }
 
-        // Check if the symbol is a valid alphabet symbol
-        if (alphabet.find(symbol_str) == alphabet.end()) {
-            return false;
-        }
+    StateSet current_states = epsilonClosure(start_state);
 
+    // The tokenizer stops on text that does not spell an alphabet symbol
+    bool consumed = tokenizer.forEach(input_str, [&](std::uint32_t symbol_id) {
         // Get the next states based on the current states and symbol
-        current_states = epsilonClosure(getNextStates(current_states, symbol_str));
+        current_states = getNextStates(current_states, symbol_id);
+        epsilonClosure(current_states);
+        return true;
+    });
+    if (!consumed) {
+        return false;
     }
 
     // Check if any of the final states are accept states
-    for (const std::string& state : current_states) {
-        if (accept_states.find(state) != accept_states.end()) {
-            return true;
-        }
-    }
-
-    return false;
+    return current_states.intersects(accept_states);
 }
 
 std::string NFA::toString() const {
     std::ostringstream oss;
 
     // Convert states to string
-    for (size_t i = 0; i < states.size(); ++i) {
-        oss << states[i];
+    for (std::uint32_t i = 0; i < states.size(); ++i) {
+        oss << states.name(i);
         if (i < states.size() - 1) {
             oss << ",";
         }
@@ -101,33 +66,34 @@ std::string NFA::toString() const {
     oss << "\n";
 
     // Convert alphabet to string
-    for (const std::string& symbol : alphabet) {
-        oss << symbol << ",";
+    for (std::uint32_t i = 0; i < alphabet.size(); ++i) {
+        oss << alphabet.name(i);
+        if (i < alphabet.size() - 1) {
+            oss << ",";
+        }
     }
-    oss.seekp(-1, std::ios_base::end);
     oss << "\n";
 
     // Convert start state to string
-    oss << start_state << "\n";
+    if (start_state != NO_STATE) {
+        oss << states.name(start_state);
+    }
+    oss << "\n";
 
     // Convert accept states to string
-    for (const std::string& accept_state : accept_states) {
-        oss << accept_state << ",";
-    }
-    oss.seekp(-1, std::ios_base::end);
+    bool first = true;
+    accept_states.forEach([&](std::uint32_t accept_state) {
+        oss << (first ? "" : ",") << states.name(accept_state);
+        first = false;
+    });
     oss << "\n";
 
     // Convert transitions to string
-    for (const auto& state_transitions : transitions) {
-        const std::string& state = state_transitions.first;
-        const auto& symbol_next_states = state_transitions.second;
-
-        for (const auto& symbol_states : symbol_next_states) {
-            const std::string& symbol = symbol_states.first;
-            const auto& next_states = symbol_states.second;
-
-            for (const std::string& next_state : next_states) {
-                oss << state << "," << (symbol.empty() ? "e" : symbol) << "," << next_state << "\n";
+    for (std::uint32_t state = 0; state < states.size(); ++state) {
+        for (std::uint32_t symbol = 0; symbol <= alphabet.size(); ++symbol) {
+            for (std::uint32_t next_state : successors(state, symbol)) {
+                oss << states.name(state) << "," << (symbol == epsilon() ? "e" : alphabet.name(symbol)) << ","
+                    << states.name(next_state) << "\n";
             }
         }
     }
@@ -135,97 +101,274 @@ std::string NFA::toString() const {
     return oss.str();
 }
 
-std::string NFA::toDFA() const {
-    std::unordered_map<std::string, std::unordered_map<std::string, std::string>> dfa_transitions;
-    std::unordered_set<std::string> dfa_states;
-    std::unordered_set<std::string> dfa_accept_states;
-
-    std::queue<std::unordered_set<std::string>> state_queue;
-    std::unordered_map<std::string, std::unordered_set<std::string>> state_map;
-
-    std::unordered_set<std::string> initial_states = epsilonClosure(start_state);
-    std::string initial_state = setToString(initial_states);
-    state_queue.push(initial_states);
-    state_map[initial_state] = initial_states;
-    dfa_states.insert(initial_state);
-
-    while (!state_queue.empty()) {
-        std::unordered_set<std::string> current_states = state_queue.front();
-        state_queue.pop();
-        std::string current_state = setToString(current_states);
-
-        // Check if the current state is an accept state
-        for (const std::string& state : current_states) {
-            if (accept_states.find(state) != accept_states.end()) {
-                dfa_accept_states.insert(current_state);
-                break;
+namespace {
+
+// Epsilon-free working copy used by the reduction passes; origin maps back to the
+// original state whose name the reduced state keeps
+struct ReductionGraph {
+    std::uint32_t symbol_count = 0;
+    std::uint32_t start = 0;
+    std::vector<std::uint32_t> origin;
+    std::vector<bool> accepting;
+    // next[state * symbol_count + symbol] lists successor states, sorted and unique
+    std::vector<std::vector<std::uint32_t>> next;
+
+    std::uint32_t size() const { return static_cast<std::uint32_t>(origin.size()); }
+};
+
+// Coarsest partition refining blocks in which members agree, per symbol, on the set of
+// blocks their edges lead to. Run on the reversed graph this gives backward bisimulation.
+std::vector<std::uint32_t> refinePartition(std::vector<std::uint32_t> blocks,
+    const std::vector<std::vector<std::uint32_t>>& edges, std::uint32_t symbol_count) {
+    std::uint32_t block_count = 0;
+    while (true) {
+        std::map<std::vector<std::uint32_t>, std::uint32_t> signatures;
+        std::vector<std::uint32_t> refined(blocks.size());
+
+        for (std::uint32_t state = 0; state < blocks.size(); ++state) {
+            ResourceBudget::checkpoint();
+            std::vector<std::uint32_t> signature{ blocks[state] };
+            for (std::uint32_t symbol = 0; symbol < symbol_count; ++symbol) {
+                std::size_t begin = signature.size();
+                for (std::uint32_t target : edges[state * symbol_count + symbol]) {
+                    signature.push_back(blocks[target]);
+                }
+                std::sort(signature.begin() + begin, signature.end());
+                signature.erase(std::unique(signature.begin() + begin, signature.end()), signature.end());
+                signature.push_back(NFA::NO_STATE);
             }
+            refined[state] = signatures.emplace(std::move(signature), signatures.size()).first->second;
         }
 
-        // Process transitions for each alphabet symbol
-        for (const std::string& symbol : alphabet) {
-            std::unordered_set<std::string> next_states = epsilonClosure(getNextStates(current_states, symbol));
-            std::string next_state = setToString(next_states);
+        blocks.swap(refined);
+        if (signatures.size() == block_count) {
+            return blocks;
+        }
+        block_count = static_cast<std::uint32_t>(signatures.size());
+    }
+}
 
-            if (!next_states.empty()) {
-                dfa_transitions[current_state][symbol] = next_state;
+// Collapses each block into its lowest-numbered member; a block accepts if any member does
+ReductionGraph quotient(const ReductionGraph& graph, const std::vector<std::uint32_t>& blocks) {
+    std::uint32_t block_count = 0;
+    for (std::uint32_t block : blocks) block_count = std::max(block_count, block + 1);
+
+    ReductionGraph result;
+    result.symbol_count = graph.symbol_count;
+    result.origin.assign(block_count, NFA::NO_STATE);
+    result.accepting.assign(block_count, false);
+    result.next.assign(std::size_t(block_count) * graph.symbol_count, {});
+    result.start = blocks[graph.start];
+
+    for (std::uint32_t state = 0; state < graph.size(); ++state) {
+        std::uint32_t block = blocks[state];
+        if (result.origin[block] == NFA::NO_STATE) result.origin[block] = graph.origin[state];
+        if (graph.accepting[state]) result.accepting[block] = true;
+
+        for (std::uint32_t symbol = 0; symbol < graph.symbol_count; ++symbol) {
+            std::vector<std::uint32_t>& targets = result.next[block * graph.symbol_count + symbol];
+            for (std::uint32_t target : graph.next[state * graph.symbol_count + symbol]) {
+                targets.push_back(blocks[target]);
+            }
+        }
+    }
+
+    for (std::vector<std::uint32_t>& targets : result.next) {
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+    }
+    return result;
+}
+
+}
+
+NFA NFA::reduced() const {
+    NFA result(memory);
+    for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+        result.alphabet.intern(alphabet.name(symbol));
+    }
+    result.tokenizer.build(result.alphabet);
+    if (start_state == NO_STATE || has_unknown_names) {
+        result.has_unknown_names = has_unknown_names;
+        return result;
+    }
+
+    const std::uint32_t symbol_count = alphabet.size();
+    const std::uint32_t state_count = states.size();
+
+    // Epsilon removal: q moves on a wherever its closure does, and accepts if its closure does
+    ReductionGraph graph;
+    graph.symbol_count = symbol_count;
+    graph.start = start_state;
+    graph.next.assign(std::size_t(state_count) * symbol_count, {});
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        StateSet closure = epsilonClosure(state);
+        graph.origin.push_back(state);
+        graph.accepting.push_back(closure.intersects(accept_states));
+
+        for (std::uint32_t symbol = 0; symbol < symbol_count; ++symbol) {
+            StateSet targets = getNextStates(closure, symbol);
+            targets.forEach([&](std::uint32_t target) { graph.next[state * symbol_count + symbol].push_back(target); });
+        }
+    }
+
+    // Trim to states that are reachable from the start and can still reach acceptance
+    std::vector<std::vector<std::uint32_t>> predecessors(state_count);
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        for (std::uint32_t symbol = 0; symbol < symbol_count; ++symbol) {
+            for (std::uint32_t target : graph.next[state * symbol_count + symbol]) {
+                predecessors[target].push_back(state);
+            }
+        }
+    }
 
-                if (state_map.find(next_state) == state_map.end()) {
-                    state_queue.push(next_states);
-                    state_map[next_state] = next_states;
-                    dfa_states.insert(next_state);
+    std::vector<bool> reachable(state_count, false), productive(state_count, false);
+    std::vector<std::uint32_t> stack{ start_state };
+    reachable[start_state] = true;
+    while (!stack.empty()) {
+        std::uint32_t state = stack.back();
+        stack.pop_back();
+        for (std::uint32_t symbol = 0; symbol < symbol_count; ++symbol) {
+            for (std::uint32_t target : graph.next[state * symbol_count + symbol]) {
+                if (!reachable[target]) {
+                    reachable[target] = true;
+                    stack.push_back(target);
                 }
             }
         }
     }
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        if (graph.accepting[state]) {
+            productive[state] = true;
+            stack.push_back(state);
+        }
+    }
+    while (!stack.empty()) {
+        std::uint32_t state = stack.back();
+        stack.pop_back();
+        for (std::uint32_t source : predecessors[state]) {
+            if (!productive[source]) {
+                productive[source] = true;
+                stack.push_back(source);
+            }
+        }
+    }
 
-    std::ostringstream oss;
+    // The start state always survives, even when the language is empty
+    std::vector<std::uint32_t> renumber(state_count, NO_STATE);
+    ReductionGraph trimmed;
+    trimmed.symbol_count = symbol_count;
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        if (state == start_state || (reachable[state] && productive[state])) {
+            renumber[state] = trimmed.size();
+            trimmed.origin.push_back(state);
+            trimmed.accepting.push_back(graph.accepting[state]);
+        }
+    }
+    trimmed.start = renumber[start_state];
+    trimmed.next.assign(std::size_t(trimmed.size()) * symbol_count, {});
+    for (std::uint32_t state = 0; state < trimmed.size(); ++state) {
+        for (std::uint32_t symbol = 0; symbol < symbol_count; ++symbol) {
+            for (std::uint32_t target : graph.next[trimmed.origin[state] * symbol_count + symbol]) {
+                if (renumber[target] != NO_STATE) {
+                    trimmed.next[state * symbol_count + symbol].push_back(renumber[target]);
+                }
+            }
+        }
+    }
 
-    // Convert DFA states to string
-    for (const std::string& state : dfa_states) {
-        oss << state << ",";
+    // Forward bisimulation: same acceptance, same blocks reachable on every symbol
+    std::vector<std::uint32_t> blocks(trimmed.size());
+    for (std::uint32_t state = 0; state < trimmed.size(); ++state) {
+        blocks[state] = trimmed.accepting[state] ? 1 : 0;
+    }
+    ReductionGraph forward = quotient(trimmed, refinePartition(blocks, trimmed.next, symbol_count));
+
+    // Backward bisimulation: same initial status, same blocks reaching it on every symbol
+    std::vector<std::vector<std::uint32_t>> reversed(std::size_t(forward.size()) * symbol_count);
+    for (std::uint32_t state = 0; state < forward.size(); ++state) {
+        for (std::uint32_t symbol = 0; symbol < symbol_count; ++symbol) {
+            for (std::uint32_t target : forward.next[state * symbol_count + symbol]) {
+                reversed[target * symbol_count + symbol].push_back(state);
+            }
+        }
     }
-    oss.seekp(-1, std::ios_base::end);
-    oss << "\\n";
+    blocks.assign(forward.size(), 0);
+    blocks[forward.start] = 1;
+    ReductionGraph backward = quotient(forward, refinePartition(blocks, reversed, symbol_count));
 
-    // Convert DFA alphabet to string
-    for (const std::string& symbol : alphabet) {
-        oss << symbol << ",";
+    for (std::uint32_t state = 0; state < backward.size(); ++state) {
+        result.states.intern(states.name(backward.origin[state]));
+    }
+    result.start_state = backward.start;
+    result.accept_states.resize(backward.size());
+    result.transitions.assign(std::size_t(backward.size()) * (symbol_count + 1), std::pmr::vector<std::uint32_t>(memory));
+    for (std::uint32_t state = 0; state < backward.size(); ++state) {
+        if (backward.accepting[state]) {
+            result.accept_states.insert(state);
+        }
+        for (std::uint32_t symbol = 0; symbol < symbol_count; ++symbol) {
+            const std::vector<std::uint32_t>& targets = backward.next[state * symbol_count + symbol];
+            result.transitions[state * (symbol_count + 1) + symbol].assign(targets.begin(), targets.end());
+        }
     }
-    oss.seekp(-1, std::ios_base::end);
-    oss << "\\n";
 
-    // Convert DFA start state to string
-    oss << initial_state << "\\n";
+    return result;
+}
 
-    // Convert DFA accept states to string
-    for (const std::string& accept_state : dfa_accept_states) {
-        oss << accept_state << ",";
+DFA NFA::toDFA() const {
+    DFA dfa(alphabet, memory);
+    if (start_state == NO_STATE) {
+        return dfa;
     }
-    oss.seekp(-1, std::ios_base::end);
-    oss << "\\n";
 
-    // Convert DFA transitions to string
-    for (const auto& state_transitions : dfa_transitions) {
-        const std::string& state = state_transitions.first;
-        const auto& symbol_next_state = state_transitions.second;
+    // Subsets are bitsets over NFA state ids; each one maps to the DFA state built for it
+    std::pmr::unordered_map<StateSet, std::uint32_t, StateSet::Hash> state_map(memory);
+    std::pmr::vector<StateSet> subsets(memory);
+    std::pmr::vector<StateSet> closure_cache(states.size(), StateSet(memory), memory);
+
+    auto addSubset = [&](const StateSet& subset) {
+        std::string name = setToString(subset, states);
+        std::uint32_t id = dfa.stateCount();
+        // Concatenated names can collide (e.g. "a"+"bc" and "ab"+"c"), so keep them distinct
+        while (dfa.addState(name, subset.intersects(accept_states)) != id) {
+            name += "'";
+        }
+        subsets.push_back(subset);
+        state_map.emplace(subset, id);
+        Metrics::count(EngineCounter::DfaStatesBuilt);
+        ResourceBudget::chargeStates();
+        return id;
+    };
+
+    StateSet initial_states = epsilonClosure(start_state);
+    dfa.setStartState(addSubset(initial_states));
+
+    for (std::uint32_t current = 0; current < subsets.size(); ++current) {
+        StateSet current_states = subsets[current];
 
-        for (const auto& symbol_state : symbol_next_state) {
-            const std::string& symbol = symbol_state.first;
-            const std::string& next_state = symbol_state.second;
+        // Process transitions for each alphabet symbol
+        for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+            StateSet next_states = getNextStates(current_states, symbol);
+            epsilonClosure(next_states, closure_cache);
 
-            oss << state << "," << symbol << "," << next_state << "\\n";
+            if (!next_states.empty()) {
+                auto it = state_map.find(next_states);
+                std::uint32_t next_state = it != state_map.end() ? it->second : addSubset(next_states);
+                dfa.setTransition(current, symbol, next_state);
+            }
         }
     }
 
-    return oss.str();
+    return dfa;
 }
 
 void NFA::parseTransitions(const std::string& transitions_str) {
     std::istringstream iss(transitions_str);
     std::string state, symbol, next_state, blank;
     std::string prev_state, prev_symbol, prev_next_state;
-    int flag = 0;
+
+    transitions.assign(states.size() * (alphabet.size() + 1), std::pmr::vector<std::uint32_t>(memory));
 
     for (int i = 0; i < 4; i++)
         while (std::getline(iss, blank, ',')) {
@@ -248,85 +391,99 @@ void NFA::parseTransitions(const std::string& transitions_str) {
         prev_symbol = symbol;
         prev_next_state = next_state;
 
-        if (next_state[next_state.length() - 1] == '-') {
+        bool last = !next_state.empty() && next_state[next_state.length() - 1] == '-';
+        if (last) {
             next_state.erase(next_state.length() - 1);
-            transitions[state][symbol].insert(next_state);
-            break;
         }
 
-        transitions[state][symbol].insert(next_state);
-    }
+        std::uint32_t state_id = states.find(state);
+        std::uint32_t symbol_id = symbol.empty() ? epsilon() : alphabet.find(symbol);
+        std::uint32_t next_state_id = states.find(next_state);
+        if (state_id == NO_STATE || symbol_id == SymbolTable::NO_SYMBOL || next_state_id == NO_STATE) {
+            has_unknown_names = true;
+        }
+        else {
+            std::pmr::vector<std::uint32_t>& targets = transitions[state_id * (alphabet.size() + 1) + symbol_id];
+            if (std::find(targets.begin(), targets.end(), next_state_id) == targets.end()) {
+                targets.push_back(next_state_id);
+            }
+        }
 
+        if (last) break;
+    }
+}
 
+StateSet NFA::initialStates() const {
+    return start_state == NO_STATE ? StateSet(states.size(), memory) : epsilonClosure(start_state);
 }
 
-std::unordered_set<std::string> NFA::epsilonClosure(const std::string& state) const {
-    std::unordered_set<std::string> closure;
-    std::queue<std::string> state_queue;
+StateSet NFA::step(const StateSet& current_states, std::uint32_t symbol) const {
+    StateSet next_states = getNextStates(current_states, symbol);
+    epsilonClosure(next_states);
+    return next_states;
+}
 
+StateSet NFA::epsilonClosure(std::uint32_t state) const {
+    StateSet closure(states.size(), memory);
     closure.insert(state);
-    state_queue.push(state);
-
-    while (!state_queue.empty()) {
-        std::string current_state = state_queue.front();
-        state_queue.pop();
-
-        // Find epsilon transitions from the current state
-        auto it = transitions.find(current_state);
-        if (it != transitions.end()) {
-            auto epsilon_it = it->second.find("");
-            if (epsilon_it != it->second.end()) {
-                for (const std::string& next_state : epsilon_it->second) {
-                    if (closure.find(next_state) == closure.end()) {
-                        closure.insert(next_state);
-                        state_queue.push(next_state);
-                    }
-                }
-            }
-        }
-    }
-
+    epsilonClosure(closure);
     return closure;
 }
 
-std::unordered_set<std::string> NFA::epsilonClosure(const std::unordered_set<std::string>& states) const {
-    std::unordered_set<std::string> closure;
+void NFA::epsilonClosure(StateSet& closure) const {
+    std::pmr::vector<std::uint32_t> state_stack(memory);
+
+    Metrics::count(EngineCounter::ClosureComputations);
+    closure.forEach([&](std::uint32_t state) { state_stack.push_back(state); });
 
-    for (const std::string& state : states) {
-        std::unordered_set<std::string> state_closure = epsilonClosure(state);
-        closure.insert(state_closure.begin(), state_closure.end());
+    while (!state_stack.empty()) {
+        ResourceBudget::checkpoint();
+        std::uint32_t current_state = state_stack.back();
+        state_stack.pop_back();
+
+        // Follow epsilon transitions from the current state
+        for (std::uint32_t next_state : successors(current_state, epsilon())) {
+            if (!closure.contains(next_state)) {
+                closure.insert(next_state);
+                state_stack.push_back(next_state);
+            }
+        }
     }
+}
 
-    return closure;
+void NFA::epsilonClosure(StateSet& closure, std::pmr::vector<StateSet>& closure_cache) const {
+    StateSet seeds(closure, memory);
+
+    seeds.forEach([&](std::uint32_t state) {
+        StateSet& cached = closure_cache[state];
+        if (!cached.empty()) {
+            Metrics::count(EngineCounter::ClosureCacheHits);
+        }
+        else {
+            cached = epsilonClosure(state);
+        }
+        closure |= cached;
+    });
 }
 
-std::unordered_set<std::string> NFA::getNextStates(const std::unordered_set<std::string>& states, const std::string& symbol) const {
-    std::unordered_set<std::string> next_states;
+StateSet NFA::getNextStates(const StateSet& current_states, std::uint32_t symbol) const {
+    StateSet next_states(states.size(), memory);
 
-    for (const std::string& state : states) {
-        auto it = transitions.find(state);
-        if (it != transitions.end()) {
-            auto symbol_it = it->second.find(symbol);
-            if (symbol_it != it->second.end()) {
-                next_states.insert(symbol_it->second.begin(), symbol_it->second.end());
-            }
+    current_states.forEach([&](std::uint32_t state) {
+        for (std::uint32_t next_state : successors(state, symbol)) {
+            next_states.insert(next_state);
         }
-    }
+    });
 
     return next_states;
 }
 
-std::string setToString(const std::unordered_set<std::string>& set) {
-    std::ostringstream oss;
-    bool first = true;
+std::string setToString(const StateSet& set, const SymbolTable& names) {
+    std::string result;
 
-    for (const std::string& item : set) {
-        if (!first) {
-            oss << "";
-        }
-        oss << item;
-        first = false;
-    }
+    set.forEach([&](std::uint32_t id) {
+        result += names.name(id);
+    });
 
-    return oss.str();
-}
\ No newline at end of file
+    return result;
+}
@@ -3,28 +3,53 @@
 
 #include "automaton.hpp"
 #include "dfa.hpp"
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
+#include <memory_resource>
 
-// Forward declaration of the setToString function
-std::string setToString(const std::unordered_set<std::string>& set);
+// Concatenates the names of the states in set, in id order
+std::string setToString(const StateSet& set, const SymbolTable& names);
 
 class NFA : public Automaton {
 public:
-    NFA(const std::string& nfa_str);
+    NFA(const std::string& nfa_str, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
     bool validate() const override;
     bool accepts(const std::string& input_str) const override;
     std::string toString() const override;
-    std::string toDFA() const;
+    DFA toDFA() const;
+    // Equivalent epsilon-free NFA with useless states trimmed and forward/backward bisimilar
+    // states merged, so subset construction has fewer and smaller subsets to build
+    NFA reduced() const;
+
+    // Read access to the transition structure for the engines built on top of it
+    std::uint32_t stateCount() const { return states.size(); }
+    std::uint32_t symbolCount() const { return alphabet.size(); }
+    std::uint32_t startState() const { return start_state; }
+    bool isAccepting(std::uint32_t state) const { return accept_states.contains(state); }
+    const std::pmr::string& stateName(std::uint32_t state) const { return states.name(state); }
+    const StateSet& acceptStates() const { return accept_states; }
+    const std::pmr::string& symbolName(std::uint32_t symbol) const { return alphabet.name(symbol); }
+    std::uint32_t symbolId(std::string_view symbol) const { return alphabet.find(symbol); }
+    // Symbol id |Σ| stands for epsilon in successors()
+    std::uint32_t epsilon() const { return alphabet.size(); }
+    const std::pmr::vector<std::uint32_t>& successors(std::uint32_t state, std::uint32_t symbol) const {
+        return transitions[state * (alphabet.size() + 1) + symbol];
+    }
+    // Epsilon closure of the start state; empty if there is no start state
+    StateSet initialStates() const;
+    // Epsilon-closed set of states reachable from states on symbol
+    StateSet step(const StateSet& states, std::uint32_t symbol) const;
 
 private:
-    std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_set<std::string>>> transitions;
+    explicit NFA(std::pmr::memory_resource* memory) : Automaton(memory), transitions(memory) {}
+
+    // transitions[state * (|Σ| + 1) + symbol] lists the successor ids; symbol |Σ| is epsilon
+    std::pmr::vector<std::pmr::vector<std::uint32_t>> transitions;
 
     void parseTransitions(const std::string& transitions_str);
-    std::unordered_set<std::string> epsilonClosure(const std::string& state) const;
-    std::unordered_set<std::string> epsilonClosure(const std::unordered_set<std::string>& states) const;
-    std::unordered_set<std::string> getNextStates(const std::unordered_set<std::string>& states, const std::string& symbol) const;
+    StateSet epsilonClosure(std::uint32_t state) const;
+    void epsilonClosure(StateSet& states) const;
+    void epsilonClosure(StateSet& states, std::pmr::vector<StateSet>& closure_cache) const;
+    StateSet getNextStates(const StateSet& states, std::uint32_t symbol) const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,397 @@
+#include "parse_forest.hpp"
+#include "budget.hpp"
+#include "json.hpp"
+#include <algorithm>
+#include <queue>
+
+namespace {
+
+std::uint64_t saturatingMultiply(std::uint64_t a, std::uint64_t b) {
+    std::uint64_t product;
+    return __builtin_mul_overflow(a, b, &product) ? UINT64_MAX : product;
+}
+
+std::uint64_t saturatingAdd(std::uint64_t a, std::uint64_t b) {
+    std::uint64_t sum;
+    return __builtin_add_overflow(a, b, &sum) ? UINT64_MAX : sum;
+}
+
+// Key for the set of variables completed at a position
+std::uint64_t spanKey(std::uint32_t variable, std::uint32_t start) {
+    return (std::uint64_t(variable) << 32) | start;
+}
+
+}
+
+ParseForest::ParseForest(const EarleyRecognizer& earley, const std::vector<std::uint32_t>& tokens,
+    std::pmr::memory_resource* memory)
+    : rules(earley.grammarRules()), nodes(memory), packed(memory), node_ids(memory), root(NONE), cyclic(false) {
+    EarleyChart chart;
+    earley.buildChart(tokens, chart);
+
+    // completed[j] holds (A, i) for every A that derives tokens i..j
+    std::vector<std::unordered_set<std::uint64_t>> completed(tokens.size() + 1);
+    for (std::size_t position = 0; position <= tokens.size(); ++position) {
+        for (const EarleyItem& item : chart.items[position]) {
+            if (item.dot == rules.rhs[item.rule].size()) {
+                completed[position].insert(spanKey(rules.lhs[item.rule], item.origin));
+            }
+        }
+    }
+
+    const std::uint32_t length = static_cast<std::uint32_t>(tokens.size());
+    if (rules.start_variable >= rules.variable_count || !completed[length].count(spanKey(rules.start_variable, 0))) {
+        return;
+    }
+    root = node(SYMBOL, rules.start_variable, 0, 0, length);
+
+    // Nodes are expanded in creation order; expanding one only creates others, so the packed
+    // nodes of each node end up contiguous
+    for (std::uint32_t id = 0; id < nodes.size(); ++id) {
+        Node current = nodes[id];
+        nodes[id].first_packed = static_cast<std::uint32_t>(packed.size());
+        if (current.kind == SYMBOL) {
+            for (std::uint32_t rule : earley.rulesOf(current.label)) {
+                std::uint32_t size = static_cast<std::uint32_t>(rules.rhs[rule].size());
+                if (!chart.contains(current.end, rule, size, current.start)) {
+                    continue;
+                }
+                if (size == 0) {
+                    packed.push_back(Packed{ id, NONE, NONE });
+                }
+                else {
+                    addSplits(id, rule, size, current.start, current.end, chart, completed, tokens);
+                }
+            }
+        }
+        else if (current.kind == INTERMEDIATE) {
+            addSplits(id, current.label, current.dot, current.start, current.end, chart, completed, tokens);
+        }
+        nodes[id].packed_count = static_cast<std::uint32_t>(packed.size()) - nodes[id].first_packed;
+    }
+
+    count();
+}
+
+std::uint32_t ParseForest::node(Kind kind, std::uint32_t label, std::uint32_t dot, std::uint32_t start, std::uint32_t end) {
+    std::pair<std::uint64_t, std::uint64_t> key((std::uint64_t(kind) << 62) | (std::uint64_t(label) << 30) | dot,
+        (std::uint64_t(start) << 32) | end);
+    auto [it, inserted] = node_ids.emplace(key, static_cast<std::uint32_t>(nodes.size()));
+    if (inserted) {
+        ResourceBudget::chargeStates();
+        nodes.push_back(Node{ kind, label, dot, start, end, 0, 0 });
+    }
+    return it->second;
+}
+
+void ParseForest::addSplits(std::uint32_t owner, std::uint32_t rule, std::uint32_t dot, std::uint32_t start,
+    std::uint32_t end, const EarleyChart& chart, const std::vector<std::unordered_set<std::uint64_t>>& completed,
+    const std::vector<std::uint32_t>& tokens) {
+    // The last of the first dot symbols covers tokens split..end, the ones before it start..split
+    std::uint32_t last = rules.rhs[rule][dot - 1];
+    std::uint32_t first_split = start;
+    std::uint32_t last_split = end;
+    if (dot == 1) {
+        last_split = start;
+    }
+    if (Grammar::isTerminalSymbol(last)) {
+        if (end == start || tokens[end - 1] != Grammar::terminalId(last)) {
+            return;
+        }
+        first_split = std::max(first_split, end - 1);
+        last_split = std::min(last_split, end - 1);
+    }
+
+    for (std::uint32_t split = first_split; split <= last_split; ++split) {
+        ResourceBudget::checkpoint();
+        if (dot > 1 && !chart.contains(split, rule, dot - 1, start)) {
+            continue;
+        }
+
+        std::uint32_t right;
+        if (Grammar::isTerminalSymbol(last)) {
+            right = node(TERMINAL, Grammar::terminalId(last), 0, split, end);
+        }
+        else if (completed[end].count(spanKey(last, split))) {
+            right = node(SYMBOL, last, 0, split, end);
+        }
+        else {
+            continue;
+        }
+        std::uint32_t left = dot > 1 ? node(INTERMEDIATE, rule, dot - 1, start, split) : NONE;
+        ResourceBudget::chargeStates();
+        packed.push_back(Packed{ owner, left, right });
+    }
+}
+
+std::vector<std::uint32_t> ParseForest::heights() const {
+    // Knuth's generalisation of Dijkstra: a node is settled at the height of its first
+    // alternative whose children are all settled, taken in order of height
+    std::vector<std::uint32_t> height(nodes.size(), NONE);
+    std::vector<std::uint8_t> unsettled(packed.size(), 0);
+    std::vector<std::vector<std::uint32_t>> users(nodes.size());
+    using Entry = std::pair<std::uint32_t, std::uint32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+
+    for (std::uint32_t id = 0; id < nodes.size(); ++id) {
+        if (nodes[id].kind == TERMINAL) {
+            queue.emplace(0, id);
+        }
+    }
+    for (std::uint32_t p = 0; p < packed.size(); ++p) {
+        for (std::uint32_t child : { packed[p].left, packed[p].right }) {
+            if (child != NONE) {
+                users[child].push_back(p);
+                ++unsettled[p];
+            }
+        }
+        if (unsettled[p] == 0) {
+            queue.emplace(1, packed[p].owner);
+        }
+    }
+
+    while (!queue.empty()) {
+        auto [node_height, id] = queue.top();
+        queue.pop();
+        if (height[id] != NONE) {
+            continue;
+        }
+        height[id] = node_height;
+        for (std::uint32_t p : users[id]) {
+            if (--unsettled[p] == 0) {
+                std::uint32_t tallest = 0;
+                for (std::uint32_t child : { packed[p].left, packed[p].right }) {
+                    if (child != NONE) {
+                        tallest = std::max(tallest, height[child]);
+                    }
+                }
+                queue.emplace(tallest + 1, packed[p].owner);
+            }
+        }
+    }
+    return height;
+}
+
+void ParseForest::count() {
+    std::vector<std::uint32_t> height = heights();
+
+    // Tarjan's strongly connected components, iteratively. Components are finished children
+    // first, so counting them in that order only ever reads finished counts.
+    const std::uint32_t node_count = static_cast<std::uint32_t>(nodes.size());
+    std::vector<std::uint32_t> index(node_count, NONE);
+    std::vector<std::uint32_t> low(node_count, 0);
+    std::vector<std::uint32_t> component(node_count, NONE);
+    std::vector<bool> on_stack(node_count, false);
+    std::vector<std::uint32_t> stack;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> frames;
+    std::vector<std::vector<std::uint32_t>> components;
+    std::uint32_t next_index = 0;
+
+    // Edge e of a node is side e % 2 of its packed node e / 2
+    auto child = [this](std::uint32_t id, std::uint32_t edge) {
+        const Packed& alternative = packed[nodes[id].first_packed + edge / 2];
+        return edge % 2 == 0 ? alternative.left : alternative.right;
+    };
+
+    for (std::uint32_t start = 0; start < node_count; ++start) {
+        if (index[start] != NONE) {
+            continue;
+        }
+        frames.emplace_back(start, 0);
+        index[start] = low[start] = next_index++;
+        stack.push_back(start);
+        on_stack[start] = true;
+
+        while (!frames.empty()) {
+            auto& [id, edge] = frames.back();
+            if (edge < 2 * nodes[id].packed_count) {
+                std::uint32_t next = child(id, edge++);
+                if (next == NONE) {
+                    continue;
+                }
+                if (index[next] == NONE) {
+                    index[next] = low[next] = next_index++;
+                    stack.push_back(next);
+                    on_stack[next] = true;
+                    frames.emplace_back(next, 0);
+                }
+                else if (on_stack[next]) {
+                    low[id] = std::min(low[id], index[next]);
+                }
+                continue;
+            }
+
+            std::uint32_t finished = id;
+            frames.pop_back();
+            if (!frames.empty()) {
+                low[frames.back().first] = std::min(low[frames.back().first], low[finished]);
+            }
+            if (low[finished] == index[finished]) {
+                components.emplace_back();
+                std::uint32_t member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    on_stack[member] = false;
+                    component[member] = static_cast<std::uint32_t>(components.size() - 1);
+                    components.back().push_back(member);
+                } while (member != finished);
+            }
+        }
+    }
+
+    // Inside a component an alternative is only followed when all its children are lower,
+    // which leaves an acyclic forest where every node keeps its lowest alternative
+    kept.assign(packed.size(), true);
+    for (std::uint32_t p = 0; p < packed.size(); ++p) {
+        std::uint32_t owner = packed[p].owner;
+        for (std::uint32_t next : { packed[p].left, packed[p].right }) {
+            if (next != NONE && component[next] == component[owner]) {
+                cyclic = true;
+                if (height[next] >= height[owner]) {
+                    kept[p] = false;
+                }
+            }
+        }
+    }
+
+    exact_counts.assign(node_count, BigUnsigned());
+    counts.assign(node_count, 0);
+    BigUnsigned one(1);
+    for (std::vector<std::uint32_t>& members : components) {
+        std::sort(members.begin(), members.end(),
+            [&height](std::uint32_t a, std::uint32_t b) { return height[a] < height[b]; });
+        for (std::uint32_t id : members) {
+            ResourceBudget::checkpoint();
+            if (nodes[id].kind == TERMINAL) {
+                exact_counts[id] = one;
+                counts[id] = 1;
+                continue;
+            }
+            for (std::uint32_t p = nodes[id].first_packed; p < nodes[id].first_packed + nodes[id].packed_count; ++p) {
+                if (!kept[p]) {
+                    continue;
+                }
+                const BigUnsigned& left = packed[p].left == NONE ? one : exact_counts[packed[p].left];
+                const BigUnsigned& right = packed[p].right == NONE ? one : exact_counts[packed[p].right];
+                exact_counts[id] += left * right;
+                counts[id] = saturatingAdd(counts[id], saturatingMultiply(countOf(packed[p].left), countOf(packed[p].right)));
+            }
+        }
+    }
+}
+
+std::uint32_t ParseForest::select(std::uint32_t id, std::uint64_t index, std::uint64_t& left_index,
+    std::uint64_t& right_index) const {
+    for (std::uint32_t p = nodes[id].first_packed; p < nodes[id].first_packed + nodes[id].packed_count; ++p) {
+        if (!kept[p]) {
+            continue;
+        }
+        std::uint64_t right_count = countOf(packed[p].right);
+        std::uint64_t trees = saturatingMultiply(countOf(packed[p].left), right_count);
+        if (index < trees) {
+            left_index = index / right_count;
+            right_index = index % right_count;
+            return p;
+        }
+        index -= trees;
+    }
+    return NONE;
+}
+
+std::string ParseForest::treeJson(std::uint64_t index) const {
+    if (root == NONE || index >= counts[root]) {
+        return "null";
+    }
+
+    // Depth-first with an explicit stack, since trees can be as deep as the input is long;
+    // an entry is either a node to write with its tree number or punctuation
+    struct Entry {
+        std::uint32_t node;
+        std::uint64_t index;
+        const char* text;
+    };
+    std::string json;
+    std::vector<Entry> stack{ Entry{ root, index, nullptr } };
+    std::vector<std::pair<std::uint32_t, std::uint64_t>> children;
+
+    while (!stack.empty()) {
+        Entry entry = stack.back();
+        stack.pop_back();
+        if (entry.text) {
+            json += entry.text;
+            continue;
+        }
+
+        const Node& current = nodes[entry.node];
+        if (current.kind == TERMINAL) {
+            json += '"';
+            appendJsonEscaped(json, rules.terminal_names[current.label]);
+            json += '"';
+            continue;
+        }
+
+        json += "[\"";
+        appendJsonEscaped(json, rules.variable_names[current.label]);
+        json += '"';
+
+        // Walk the chain of intermediate nodes, which yields the children last to first
+        children.clear();
+        std::uint64_t left_index = 0;
+        std::uint64_t right_index = 0;
+        std::uint32_t p = select(entry.node, entry.index, left_index, right_index);
+        while (p != NONE) {
+            if (packed[p].right != NONE) {
+                children.emplace_back(packed[p].right, right_index);
+            }
+            if (packed[p].left == NONE) {
+                break;
+            }
+            p = select(packed[p].left, left_index, left_index, right_index);
+        }
+
+        stack.push_back(Entry{ NONE, 0, "]" });
+        for (const auto& [child, child_index] : children) {
+            stack.push_back(Entry{ child, child_index, nullptr });
+            stack.push_back(Entry{ NONE, 0, ", " });
+        }
+    }
+    return json;
+}
+
+std::string ParseForest::label(std::uint32_t id) const {
+    const Node& current = nodes[id];
+    if (current.kind == TERMINAL) {
+        return rules.terminal_names[current.label];
+    }
+    if (current.kind == SYMBOL) {
+        return rules.variable_names[current.label];
+    }
+
+    // An intermediate node shows its rule with a dot after the symbols it covers
+    const std::vector<std::uint32_t>& symbols = rules.rhs[current.label];
+    std::string result = rules.variable_names[rules.lhs[current.label]] + " ->";
+    for (std::uint32_t i = 0; i < symbols.size(); ++i) {
+        result += (i == current.dot ? " . " : " ") + rules.symbolName(symbols[i]);
+    }
+    return result;
+}
+
+std::string ParseForest::forestJson() const {
+    std::string json = "[";
+    for (std::uint32_t id = 0; id < nodes.size(); ++id) {
+        const Node& current = nodes[id];
+        json += id > 0 ? ", [\"" : "[\"";
+        json += current.kind == SYMBOL ? 'v' : current.kind == INTERMEDIATE ? 'i' : 't';
+        json += "\", \"";
+        appendJsonEscaped(json, label(id));
+        json += "\", " + std::to_string(current.start) + ", " + std::to_string(current.end) + ", [";
+        for (std::uint32_t p = current.first_packed; p < current.first_packed + current.packed_count; ++p) {
+            json += p > current.first_packed ? ", [" : "[";
+            json += (packed[p].left == NONE ? "-1" : std::to_string(packed[p].left)) + ", ";
+            json += (packed[p].right == NONE ? "-1" : std::to_string(packed[p].right)) + "]";
+        }
+        json += "]]";
+    }
+    return json + "]";
+}
@@ -0,0 +1,98 @@
+#ifndef PARSE_FOREST_HPP
+#define PARSE_FOREST_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory_resource>
+#include "earley.hpp"
+#include "big_unsigned.hpp"
+
+// Every derivation of a token sequence at once, as a binarised shared packed parse forest.
+// A symbol node (A, i, j) says A derives tokens i..j; an intermediate node (rule, d, i, j)
+// says the first d symbols of rule do. Each node lists its alternatives as packed nodes with
+// at most two children: an intermediate node for all but the last symbol and a symbol or
+// terminal node for the last one. Nodes are shared, so the forest stays cubic in the input
+// even when the number of trees is exponential.
+//
+// Unit cycles and nullable recursion give some strings infinitely many derivations, which
+// shows up as cycles in the forest. Inside a cycle only the alternatives that move strictly
+// closer to the leaves are counted and extracted, so both always see a finite set of trees.
+//
+// The forest refers to the rules of the recognizer it was built from and must not outlive it.
+class ParseForest {
+public:
+    ParseForest(const EarleyRecognizer& earley, const std::vector<std::uint32_t>& tokens,
+        std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    bool accepted() const { return root != NONE; }
+    std::size_t nodeCount() const { return nodes.size(); }
+    std::size_t packedCount() const { return packed.size(); }
+    // True when the string has infinitely many derivations
+    bool isCyclic() const { return cyclic; }
+    // Number of trees extraction can reach; every derivation when the forest is acyclic
+    const BigUnsigned& treeCount() const { return exact_counts.empty() ? zero : exact_counts[root]; }
+
+    // Tree number index, below treeCount(), built without looking at any other tree:
+    // ["A", child, ...] for a variable and "a" for a terminal
+    std::string treeJson(std::uint64_t index) const;
+    // The forest itself: nodes as [kind, label, start, end, [[left, right], ...]] with kind
+    // "v", "i" or "t" and -1 for a missing child; the root is node 0
+    std::string forestJson() const;
+
+private:
+    static constexpr std::uint32_t NONE = 0xffffffffu;
+    enum Kind : std::uint8_t { SYMBOL, INTERMEDIATE, TERMINAL };
+
+    struct Node {
+        Kind kind;
+        // Variable, rule or terminal id
+        std::uint32_t label;
+        std::uint32_t dot;
+        std::uint32_t start;
+        std::uint32_t end;
+        std::uint32_t first_packed;
+        std::uint32_t packed_count;
+    };
+    struct Packed {
+        std::uint32_t owner;
+        std::uint32_t left;
+        std::uint32_t right;
+    };
+    struct NodeKeyHash {
+        std::size_t operator()(const std::pair<std::uint64_t, std::uint64_t>& key) const {
+            return std::hash<std::uint64_t>()(key.first * 0x9e3779b97f4a7c15ull ^ key.second);
+        }
+    };
+
+    const GrammarRules& rules;
+    std::pmr::vector<Node> nodes;
+    std::pmr::vector<Packed> packed;
+    std::pmr::unordered_map<std::pair<std::uint64_t, std::uint64_t>, std::uint32_t, NodeKeyHash> node_ids;
+    std::uint32_t root;
+    bool cyclic;
+
+    // Alternatives that counting and extraction follow, and the trees below each node
+    std::vector<bool> kept;
+    std::vector<BigUnsigned> exact_counts;
+    std::vector<std::uint64_t> counts;
+    BigUnsigned zero;
+
+    std::uint32_t node(Kind kind, std::uint32_t label, std::uint32_t dot, std::uint32_t start, std::uint32_t end);
+    void addSplits(std::uint32_t owner, std::uint32_t rule, std::uint32_t dot, std::uint32_t start, std::uint32_t end,
+        const EarleyChart& chart, const std::vector<std::unordered_set<std::uint64_t>>& completed,
+        const std::vector<std::uint32_t>& tokens);
+    std::vector<std::uint32_t> heights() const;
+    void count();
+
+    std::uint64_t countOf(std::uint32_t id) const { return id == NONE ? 1 : counts[id]; }
+    // Picks the kept alternative of node id holding tree number index, and the tree numbers
+    // of its children
+    std::uint32_t select(std::uint32_t id, std::uint64_t index, std::uint64_t& left_index, std::uint64_t& right_index) const;
+    std::string label(std::uint32_t id) const;
+};
+
+#endif
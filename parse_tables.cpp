@@ -0,0 +1,438 @@
+#include "parse_tables.hpp"
+#include "budget.hpp"
+#include <map>
+#include <algorithm>
+
+GrammarRules::GrammarRules(const Grammar& grammar)
+    : variable_count(grammar.variableCount()), terminal_count(grammar.terminalCount()),
+    start_variable(grammar.startVariable()) {
+    for (std::uint32_t variable = 0; variable < variable_count; ++variable) {
+        variable_names.push_back(std::string(grammar.symbolName(variable)));
+        for (const auto& rule : grammar.rules(variable)) {
+            lhs.push_back(variable);
+            rhs.push_back(std::vector<std::uint32_t>(rule.begin(), rule.end()));
+        }
+    }
+    for (std::uint32_t terminal = 0; terminal < terminal_count; ++terminal) {
+        terminal_names.push_back(std::string(grammar.terminalSymbols().name(terminal)));
+    }
+}
+
+std::string GrammarRules::symbolName(std::uint32_t symbol) const {
+    if (Grammar::isTerminalSymbol(symbol)) {
+        std::uint32_t terminal = Grammar::terminalId(symbol);
+        return terminal < terminal_count ? terminal_names[terminal] : "$";
+    }
+    return symbol < variable_count ? variable_names[symbol] : "S'";
+}
+
+std::string GrammarRules::ruleString(std::uint32_t rule) const {
+    std::string result = symbolName(lhs[rule]) + " ->";
+    if (rhs[rule].empty()) {
+        result += " e";
+    }
+    for (std::uint32_t symbol : rhs[rule]) {
+        result += " " + symbolName(symbol);
+    }
+    return result;
+}
+
+std::string GrammarRules::toString() const {
+    std::string result;
+    for (std::uint32_t variable = 0; variable < variable_count; ++variable) {
+        result += (variable > 0 ? "," : "") + variable_names[variable];
+    }
+    result += "\n";
+    for (std::uint32_t terminal = 0; terminal < terminal_count; ++terminal) {
+        result += (terminal > 0 ? "," : "") + terminal_names[terminal];
+    }
+    result += "\n";
+    if (start_variable < variable_count) {
+        result += variable_names[start_variable];
+    }
+    result += "\n";
+    for (std::uint32_t rule = 0; rule < size(); ++rule) {
+        result += ruleString(rule) + "\n";
+    }
+    return result;
+}
+
+FirstFollow::FirstFollow(const GrammarRules& rules)
+    : nullable(rules.variable_count, false),
+    first_sets(rules.variable_count, StateSet(rules.terminal_count + 1)),
+    follow_sets(rules.variable_count, StateSet(rules.terminal_count + 1)) {
+    // FIRST sets and nullability, iterated to a fixpoint
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (std::uint32_t rule = 0; rule < rules.size(); ++rule) {
+            std::uint32_t variable = rules.lhs[rule];
+            StateSet updated = first_sets[variable];
+            bool rule_nullable = firstOfSequence(rules.rhs[rule], 0, updated);
+
+            if (updated != first_sets[variable]) {
+                first_sets[variable] = updated;
+                changed = true;
+            }
+            if (rule_nullable && !nullable[variable]) {
+                nullable[variable] = true;
+                changed = true;
+            }
+        }
+    }
+
+    // FOLLOW sets: the end marker follows the start variable
+    if (rules.start_variable < rules.variable_count) {
+        follow_sets[rules.start_variable].insert(rules.terminal_count);
+    }
+
+    changed = true;
+    while (changed) {
+        changed = false;
+        for (std::uint32_t rule = 0; rule < rules.size(); ++rule) {
+            const std::vector<std::uint32_t>& symbols = rules.rhs[rule];
+
+            for (size_t i = 0; i < symbols.size(); ++i) {
+                if (Grammar::isTerminalSymbol(symbols[i])) {
+                    continue;
+                }
+
+                StateSet updated = follow_sets[symbols[i]];
+                if (firstOfSequence(symbols, i + 1, updated)) {
+                    updated |= follow_sets[rules.lhs[rule]];
+                }
+                if (updated != follow_sets[symbols[i]]) {
+                    follow_sets[symbols[i]] = updated;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+bool FirstFollow::firstOfSequence(const std::vector<std::uint32_t>& symbols, size_t from, StateSet& result) const {
+    for (size_t i = from; i < symbols.size(); ++i) {
+        if (Grammar::isTerminalSymbol(symbols[i])) {
+            result.insert(Grammar::terminalId(symbols[i]));
+            return false;
+        }
+
+        result |= first_sets[symbols[i]];
+        if (!nullable[symbols[i]]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+LL1Table::LL1Table(const GrammarRules& rules, const FirstFollow& sets)
+    : rules(rules), columns(rules.terminal_count + 1),
+    table(rules.variable_count * (rules.terminal_count + 1), NO_RULE) {
+    for (std::uint32_t rule = 0; rule < rules.size(); ++rule) {
+        std::uint32_t variable = rules.lhs[rule];
+
+        // Predict this rule on FIRST(rhs), and on FOLLOW(lhs) when rhs can vanish
+        StateSet lookaheads(columns);
+        if (sets.firstOfSequence(rules.rhs[rule], 0, lookaheads)) {
+            lookaheads |= sets.follow(variable);
+        }
+
+        lookaheads.forEach([&](std::uint32_t terminal) {
+            std::uint32_t& entry = table[variable * columns + terminal];
+            if (entry != NO_RULE && entry != rule) {
+                conflicts.push_back("LL(1) conflict on " + rules.symbolName(variable) + " with lookahead '"
+                    + rules.symbolName(terminal | Grammar::TERMINAL_FLAG) + "': " + rules.ruleString(entry)
+                    + " | " + rules.ruleString(rule));
+                return;
+            }
+            entry = rule;
+        });
+    }
+}
+
+bool LL1Table::recognize(const std::vector<std::uint32_t>& tokens) const {
+    if (rules.start_variable >= rules.variable_count) {
+        return false;
+    }
+
+    std::vector<std::uint32_t> stack;
+    stack.push_back(rules.start_variable);
+    size_t position = 0;
+
+    while (!stack.empty()) {
+        ResourceBudget::checkpoint();
+        std::uint32_t symbol = stack.back();
+        std::uint32_t lookahead = position < tokens.size() ? tokens[position] : rules.terminal_count;
+        stack.pop_back();
+
+        if (Grammar::isTerminalSymbol(symbol)) {
+            if (Grammar::terminalId(symbol) != lookahead) {
+                return false;
+            }
+            ++position;
+            continue;
+        }
+
+        std::uint32_t rule = table[symbol * columns + lookahead];
+        if (rule == NO_RULE) {
+            return false;
+        }
+        const std::vector<std::uint32_t>& symbols = rules.rhs[rule];
+        stack.insert(stack.end(), symbols.rbegin(), symbols.rend());
+    }
+
+    return position == tokens.size();
+}
+
+// An LR(0) item: a production with a dot position
+struct LRItem {
+    std::uint32_t rule;
+    std::uint32_t dot;
+
+    bool operator<(const LRItem& other) const {
+        return rule != other.rule ? rule < other.rule : dot < other.dot;
+    }
+    bool operator==(const LRItem& other) const { return rule == other.rule && dot == other.dot; }
+};
+
+LALRTable::LALRTable(const GrammarRules& rules, const FirstFollow& sets)
+    : rules(rules), terminal_columns(rules.terminal_count + 1) {
+    if (rules.start_variable >= rules.variable_count) {
+        return;
+    }
+
+    // Augment with S' -> S as the last rule; its left-hand side is variable_count
+    const std::uint32_t augmented = rules.size();
+    const std::uint32_t end_marker = rules.terminal_count;
+    const std::uint32_t lookahead_universe = rules.terminal_count + 1;
+    const std::vector<std::uint32_t> augmented_rhs(1, rules.start_variable);
+
+    auto rhsOf = [&](std::uint32_t rule) -> const std::vector<std::uint32_t>& {
+        return rule == augmented ? augmented_rhs : rules.rhs[rule];
+    };
+    std::vector<std::vector<std::uint32_t>> rules_by_variable(rules.variable_count);
+    for (std::uint32_t rule = 0; rule < rules.size(); ++rule) {
+        rules_by_variable[rules.lhs[rule]].push_back(rule);
+    }
+
+    // Canonical LR(0) collection, identified by sorted kernels. Each state's closure is built
+    // once as a flat item list, kernel items first, and kept for the lookahead and table passes.
+    // Every item gets a lookahead node: kernel items their own, and the items a state predicts
+    // for one variable all share one, since the closure gives them the same lookaheads.
+    std::vector<std::vector<LRItem>> kernels;
+    std::vector<std::vector<LRItem>> closures;
+    std::vector<std::vector<std::uint32_t>> item_nodes;
+    std::vector<std::map<std::uint32_t, std::uint32_t>> transitions;
+    std::map<std::vector<LRItem>, std::uint32_t> kernel_ids;
+    std::uint32_t node_count = 0;
+    // Node of each variable's predicted items in the state being closed; predicted_in marks
+    // which state that is, as state + 1
+    std::vector<std::uint32_t> predicted_node(rules.variable_count);
+    std::vector<std::uint32_t> predicted_in(rules.variable_count, 0);
+
+    kernels.push_back(std::vector<LRItem>(1, LRItem{ augmented, 0 }));
+    kernel_ids.emplace(kernels[0], 0);
+
+    for (std::uint32_t state = 0; state < kernels.size(); ++state) {
+        std::vector<LRItem> items = kernels[state];
+        std::vector<std::uint32_t> nodes;
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            nodes.push_back(node_count++);
+        }
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            ResourceBudget::checkpoint();
+            const std::vector<std::uint32_t>& symbols = rhsOf(items[i].rule);
+            if (items[i].dot >= symbols.size() || Grammar::isTerminalSymbol(symbols[items[i].dot])) {
+                continue;
+            }
+            std::uint32_t variable = symbols[items[i].dot];
+            if (predicted_in[variable] == state + 1) {
+                continue;
+            }
+            predicted_in[variable] = state + 1;
+            predicted_node[variable] = node_count++;
+            for (std::uint32_t rule : rules_by_variable[variable]) {
+                items.push_back(LRItem{ rule, 0 });
+                nodes.push_back(predicted_node[variable]);
+            }
+        }
+
+        std::map<std::uint32_t, std::vector<LRItem>> successors;
+        for (const LRItem& item : items) {
+            const std::vector<std::uint32_t>& symbols = rhsOf(item.rule);
+            if (item.dot < symbols.size()) {
+                successors[symbols[item.dot]].push_back(LRItem{ item.rule, item.dot + 1 });
+            }
+        }
+
+        transitions.emplace_back();
+        for (auto& successor : successors) {
+            std::sort(successor.second.begin(), successor.second.end());
+            auto it = kernel_ids.find(successor.second);
+            std::uint32_t target;
+            if (it == kernel_ids.end()) {
+                target = static_cast<std::uint32_t>(kernels.size());
+                ResourceBudget::chargeStates();
+                kernel_ids.emplace(successor.second, target);
+                kernels.push_back(successor.second);
+            }
+            else {
+                target = it->second;
+            }
+            transitions[state][successor.first] = target;
+        }
+        closures.push_back(std::move(items));
+        item_nodes.push_back(std::move(nodes));
+    }
+    state_count = static_cast<std::uint32_t>(kernels.size());
+
+    // Lookaheads: FIRST of what follows a predicted variable is generated spontaneously, and
+    // an item's lookaheads propagate to its successor kernel item and, when the rest of the
+    // rule is nullable, to the variable it predicts (Dragon book 4.7.5, over nodes instead of
+    // per-kernel-item closures)
+    std::vector<StateSet> lookaheads(node_count, StateSet(lookahead_universe));
+    std::vector<std::vector<std::uint32_t>> links(node_count);
+    std::vector<std::uint32_t> kernel_base(state_count);
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        kernel_base[state] = item_nodes[state][0];
+    }
+    lookaheads[kernel_base[0]].insert(end_marker);
+
+    auto kernelNode = [&](std::uint32_t state, const LRItem& item) {
+        const std::vector<LRItem>& kernel = kernels[state];
+        return kernel_base[state] + static_cast<std::uint32_t>(std::lower_bound(kernel.begin(), kernel.end(), item) - kernel.begin());
+    };
+
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        const std::vector<LRItem>& items = closures[state];
+        for (std::size_t j = kernels[state].size(); j < items.size(); ++j) {
+            predicted_node[rules.lhs[items[j].rule]] = item_nodes[state][j];
+        }
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            ResourceBudget::checkpoint();
+            const std::vector<std::uint32_t>& symbols = rhsOf(items[i].rule);
+            if (items[i].dot >= symbols.size()) {
+                continue;
+            }
+            std::uint32_t node = item_nodes[state][i];
+            std::uint32_t symbol = symbols[items[i].dot];
+            std::uint32_t target = transitions[state][symbol];
+            links[node].push_back(kernelNode(target, LRItem{ items[i].rule, items[i].dot + 1 }));
+            if (Grammar::isTerminalSymbol(symbol)) {
+                continue;
+            }
+
+            std::uint32_t predicted = predicted_node[symbol];
+            if (sets.firstOfSequence(symbols, items[i].dot + 1, lookaheads[predicted])) {
+                links[node].push_back(predicted);
+            }
+        }
+    }
+
+    std::vector<std::uint32_t> worklist(node_count);
+    std::vector<bool> queued(node_count, true);
+    for (std::uint32_t node = 0; node < node_count; ++node) {
+        worklist[node] = node_count - 1 - node;
+    }
+    while (!worklist.empty()) {
+        ResourceBudget::checkpoint();
+        std::uint32_t node = worklist.back();
+        worklist.pop_back();
+        queued[node] = false;
+        for (std::uint32_t target : links[node]) {
+            if (!lookaheads[node].isSubsetOf(lookaheads[target])) {
+                lookaheads[target] |= lookaheads[node];
+                if (!queued[target]) {
+                    queued[target] = true;
+                    worklist.push_back(target);
+                }
+            }
+        }
+    }
+
+    // ACTION and GOTO tables
+    action.assign(state_count * terminal_columns, ERROR);
+    goto_table.assign(state_count * rules.variable_count, SymbolTable::NO_SYMBOL);
+
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        const std::vector<LRItem>& items = closures[state];
+        for (std::size_t i = 0; i < items.size(); ++i) {
+            ResourceBudget::checkpoint();
+            const std::vector<std::uint32_t>& symbols = rhsOf(items[i].rule);
+            if (items[i].dot < symbols.size()) {
+                std::uint32_t symbol = symbols[items[i].dot];
+                if (Grammar::isTerminalSymbol(symbol)) {
+                    addAction(state, Grammar::terminalId(symbol), SHIFT | transitions[state][symbol]);
+                }
+                continue;
+            }
+
+            if (items[i].rule == augmented) {
+                addAction(state, end_marker, ACCEPT);
+                continue;
+            }
+            lookaheads[item_nodes[state][i]].forEach([&](std::uint32_t terminal) {
+                addAction(state, terminal, REDUCE | items[i].rule);
+            });
+        }
+
+        for (const auto& transition : transitions[state]) {
+            if (!Grammar::isTerminalSymbol(transition.first) && transition.first < rules.variable_count) {
+                goto_table[state * rules.variable_count + transition.first] = transition.second;
+            }
+        }
+    }
+}
+
+void LALRTable::addAction(std::uint32_t state, std::uint32_t terminal, std::uint32_t entry) {
+    std::uint32_t& existing = action[state * terminal_columns + terminal];
+    if (existing == ERROR || existing == entry) {
+        existing = entry;
+        return;
+    }
+
+    auto describe = [this](std::uint32_t value) {
+        if ((value & KIND_MASK) == SHIFT) return std::string("shift");
+        if ((value & KIND_MASK) == ACCEPT) return std::string("accept");
+        return "reduce " + rules.ruleString(value & ~KIND_MASK);
+    };
+    conflicts.push_back("LALR(1) conflict in state " + std::to_string(state) + " on '"
+        + rules.symbolName(terminal | Grammar::TERMINAL_FLAG) + "': " + describe(existing) + " | " + describe(entry));
+}
+
+bool LALRTable::recognize(const std::vector<std::uint32_t>& tokens) const {
+    if (state_count == 0) {
+        return false;
+    }
+
+    std::vector<std::uint32_t> stack;
+    stack.push_back(0);
+    size_t position = 0;
+
+    while (true) {
+        ResourceBudget::checkpoint();
+        std::uint32_t lookahead = position < tokens.size() ? tokens[position] : rules.terminal_count;
+        std::uint32_t entry = action[stack.back() * terminal_columns + lookahead];
+
+        switch (entry & KIND_MASK) {
+        case SHIFT:
+            stack.push_back(entry & ~KIND_MASK);
+            ++position;
+            break;
+        case REDUCE: {
+            std::uint32_t rule = entry & ~KIND_MASK;
+            stack.resize(stack.size() - rules.rhs[rule].size());
+            std::uint32_t next_state = goto_table[stack.back() * rules.variable_count + rules.lhs[rule]];
+            if (next_state == SymbolTable::NO_SYMBOL) {
+                return false;
+            }
+            stack.push_back(next_state);
+            break;
+        }
+        case ACCEPT:
+            return true;
+        default:
+            return false;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef PARSE_TABLES_HPP
+#define PARSE_TABLES_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "grammar.hpp"
+#include "state_set.hpp"
+
+// Productions of a grammar numbered 0..n-1, in the integer encoding used by Grammar.
+// Owns copies of everything it needs so tables built on it outlive the grammar.
+struct GrammarRules {
+    std::vector<std::uint32_t> lhs;
+    std::vector<std::vector<std::uint32_t>> rhs;
+    std::uint32_t variable_count = 0;
+    std::uint32_t terminal_count = 0;
+    std::uint32_t start_variable = SymbolTable::NO_SYMBOL;
+    std::vector<std::string> variable_names;
+    std::vector<std::string> terminal_names;
+
+    GrammarRules() = default;
+    explicit GrammarRules(const Grammar& grammar);
+    std::uint32_t size() const { return static_cast<std::uint32_t>(lhs.size()); }
+    std::string symbolName(std::uint32_t symbol) const;
+    std::string ruleString(std::uint32_t rule) const;
+    // The grammar in the text format CFG parses, one rule per line with spaced symbols
+    std::string toString() const;
+};
+
+// FIRST and FOLLOW sets over terminal ids; bit terminal_count stands for the end of input
+class FirstFollow {
+public:
+    explicit FirstFollow(const GrammarRules& rules);
+
+    bool isNullable(std::uint32_t variable) const { return nullable[variable]; }
+    const StateSet& first(std::uint32_t variable) const { return first_sets[variable]; }
+    const StateSet& follow(std::uint32_t variable) const { return follow_sets[variable]; }
+
+    // Adds FIRST(symbols[from..]) to result and returns whether that suffix is nullable
+    bool firstOfSequence(const std::vector<std::uint32_t>& symbols, size_t from, StateSet& result) const;
+
+private:
+    std::vector<bool> nullable;
+    std::vector<StateSet> first_sets;
+    std::vector<StateSet> follow_sets;
+};
+
+class LL1Table {
+public:
+    LL1Table(const GrammarRules& rules, const FirstFollow& sets);
+
+    bool isDeterministic() const { return conflicts.empty(); }
+    const std::vector<std::string>& conflictList() const { return conflicts; }
+    // Predictive parse of a sequence of terminal ids in O(n)
+    bool recognize(const std::vector<std::uint32_t>& tokens) const;
+
+private:
+    static constexpr std::uint32_t NO_RULE = 0xffffffffu;
+
+    const GrammarRules& rules;
+    std::uint32_t columns;
+    // table[variable * columns + lookahead] is the production to expand with
+    std::vector<std::uint32_t> table;
+    std::vector<std::string> conflicts;
+};
+
+class LALRTable {
+public:
+    LALRTable(const GrammarRules& rules, const FirstFollow& sets);
+
+    bool isDeterministic() const { return conflicts.empty(); }
+    const std::vector<std::string>& conflictList() const { return conflicts; }
+    std::uint32_t stateCount() const { return state_count; }
+    // Shift-reduce parse of a sequence of terminal ids in O(n)
+    bool recognize(const std::vector<std::uint32_t>& tokens) const;
+
+private:
+    // Actions are packed as (kind << 30) | argument
+    static constexpr std::uint32_t ERROR = 0;
+    static constexpr std::uint32_t SHIFT = 1u << 30;
+    static constexpr std::uint32_t REDUCE = 2u << 30;
+    static constexpr std::uint32_t ACCEPT = 3u << 30;
+    static constexpr std::uint32_t KIND_MASK = 3u << 30;
+
+    const GrammarRules& rules;
+    std::uint32_t state_count = 0;
+    std::uint32_t terminal_columns = 0;
+    std::vector<std::uint32_t> action;     // state x (terminals + end marker)
+    std::vector<std::uint32_t> goto_table; // state x variables, NO_SYMBOL if undefined
+    std::vector<std::string> conflicts;
+
+    void addAction(std::uint32_t state, std::uint32_t terminal, std::uint32_t entry);
+};
+
+#endif
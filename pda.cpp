@@ -1,98 +1,154 @@
 #include "pda.hpp"
+#include "budget.hpp"
 #include <sstream>
 #include <algorithm>
 
-PDA::PDA(const std::string& pda_str) : Automaton("", "", "", "") {
+// Splits a definition line on commas and whitespace, dropping empty fields
+static std::vector<std::string> splitFields(const std::string& line) {
+    std::vector<std::string> fields;
+    std::string field;
+
+    for (char c : line) {
+        if (c == ',' || c == ' ' || c == '\t' || c == '\r') {
+            if (!field.empty()) fields.push_back(field);
+            field.clear();
+        }
+        else {
+            field += c;
+        }
+    }
+    if (!field.empty()) fields.push_back(field);
+
+    return fields;
+}
+
+PDA::PDA(const std::string& pda_str, std::pmr::memory_resource* memory)
+    : Automaton(memory), stack_alphabet(memory), stack_start_symbol(NO_STATE), transitions(memory),
+    deterministic(true) {
     std::istringstream iss(pda_str);
     std::string line;
 
+    // The PDA format is one section per line, so it does not use the
+    // single-line section parsers shared by the DFA and NFA
     std::getline(iss, line);
-    parseStates(line);
+    for (const std::string& state : splitFields(line)) {
+        states.intern(state);
+    }
     std::getline(iss, line);
-    parseAlphabet(line);
+    for (const std::string& symbol : splitFields(line)) {
+        alphabet.intern(symbol);
+    }
     std::getline(iss, line);
     parseStackStartSymbol(line);
     std::getline(iss, line);
-    parseStartState(line);
+    std::vector<std::string> start_fields = splitFields(line);
+    start_state = start_fields.empty() ? NO_STATE : states.find(start_fields[0]);
     std::getline(iss, line);
-    parseAcceptStates(line);
+    accept_states.resize(states.size());
+    for (const std::string& accept_state : splitFields(line)) {
+        std::uint32_t id = states.find(accept_state);
+        if (id == NO_STATE) {
+            has_unknown_names = true;
+        }
+        else {
+            accept_states.insert(id);
+        }
+    }
 
+    transitions.resize(states.size());
     while (std::getline(iss, line)) {
         parseTransitions(line);
     }
+    tokenizer.build(alphabet);
+
+    // Two moves of a state compete when their inputs and their pops could both match
+    auto overlap = [](std::uint32_t a, std::uint32_t b) { return a == b || a == EPSILON || b == EPSILON; };
+    for (const std::pmr::vector<PDATransition>& outgoing : transitions) {
+        for (std::size_t i = 0; i < outgoing.size() && deterministic; ++i) {
+            for (std::size_t j = i + 1; j < outgoing.size(); ++j) {
+                if (overlap(outgoing[i].input, outgoing[j].input) && overlap(outgoing[i].pop, outgoing[j].pop)) {
+                    deterministic = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::size_t table_size = std::size_t(states.size()) * (stack_alphabet.size() + 1) * (alphabet.size() + 1);
+    if (deterministic && validate() && table_size <= DeterministicPDA::MAX_TABLE_SIZE) {
+        fast_path = std::make_shared<const DeterministicPDA>(*this);
+    }
 }
 
 bool PDA::validate() const {
-    // Check if the start state is a valid state
-    if (std::find(states.begin(), states.end(), start_state) == states.end()) {
+    // Start state, accept states and every transition were resolved to ids
+    // while parsing, so all that is left is to check nothing failed to resolve
+    return validateNames() && stack_start_symbol != NO_STATE;
+}
+
+bool PDA::accepts(const std::string& input_str) const {
+    if (start_state == NO_STATE || stack_start_symbol == NO_STATE) {
         return false;
     }
 
-    // Check if all accept states are valid states
-    for (const std::string& accept_state : accept_states) {
-        if (std::find(states.begin(), states.end(), accept_state) == states.end()) {
-            return false;
+    if (fast_path) {
+        DeterministicPDA::Outcome outcome = fast_path->run(tokenizer, input_str);
+        if (outcome != DeterministicPDA::Outcome::Undecided) {
+            return outcome == DeterministicPDA::Outcome::Accept;
         }
     }
 
-    return true;
-}
-
-bool PDA::accepts(const std::string& input_str) const {
-    // TODO: simulate PDA on the input string
-    return false;
+    PDARun run(*this);
+    bool consumed = tokenizer.forEach(input_str, [&run](std::uint32_t symbol_id) { return run.step(symbol_id); });
+    return consumed && run.accepting();
 }
 
 std::string PDA::toString() const {
     std::ostringstream oss;
 
     // Convert states to string
-    for (const std::string& state : states) {
-        oss << state << ",";
+    for (std::uint32_t i = 0; i < states.size(); ++i) {
+        oss << states.name(i) << (i < states.size() - 1 ? "," : "");
     }
-    oss.seekp(-1, std::ios_base::end);
     oss << "\n";
 
     // Convert alphabet to string
-    for (const std::string& symbol : alphabet) {
-        oss << symbol << ",";
+    for (std::uint32_t i = 0; i < alphabet.size(); ++i) {
+        oss << alphabet.name(i) << (i < alphabet.size() - 1 ? "," : "");
     }
-    oss.seekp(-1, std::ios_base::end);
     oss << "\n";
 
     // Convert stack start symbol to string
-    oss << stack_start_symbol << "\n";
+    if (stack_start_symbol != NO_STATE) {
+        oss << stack_alphabet.name(stack_start_symbol);
+    }
+    oss << "\n";
 
     // Convert start state to string
-    oss << start_state << "\n";
+    if (start_state != NO_STATE) {
+        oss << states.name(start_state);
+    }
+    oss << "\n";
 
     // Convert accept states to string
-    for (const std::string& accept_state : accept_states) {
-        oss << accept_state << ",";
-    }
-    oss.seekp(-1, std::ios_base::end);
+    bool first = true;
+    accept_states.forEach([&](std::uint32_t accept_state) {
+        oss << (first ? "" : ",") << states.name(accept_state);
+        first = false;
+    });
     oss << "\n";
 
     // Convert transitions to string
-    for (const auto& state_entry : transitions) {
-        const std::string& state = state_entry.first;
-        const auto& input_map = state_entry.second;
-
-        for (const auto& input_entry : input_map) {
-            const std::string& input_symbol = input_entry.first;
-            const auto& stack_map = input_entry.second;
-
-            for (const auto& stack_entry : stack_map) {
-                const std::string& stack_symbol = stack_entry.first;
-                const auto& next_state_stack_ops = stack_entry.second;
-
-                for (const auto& next_state_stack_op : next_state_stack_ops) {
-                    const std::string& next_state = next_state_stack_op.first;
-                    const std::string& stack_op = next_state_stack_op.second;
-
-                    oss << state << " " << input_symbol << " " << stack_symbol << " " << next_state << " " << stack_op << "\n";
-                }
+    for (std::uint32_t state = 0; state < states.size(); ++state) {
+        for (const PDATransition& transition : transitions[state]) {
+            oss << states.name(state) << " "
+                << (transition.input == EPSILON ? "e" : alphabet.name(transition.input)) << " "
+                << (transition.pop == EPSILON ? "e" : stack_alphabet.name(transition.pop)) << " "
+                << states.name(transition.next_state) << " ";
+            for (std::uint32_t symbol : transition.push) {
+                oss << stack_alphabet.name(symbol);
             }
+            oss << (transition.push.empty() ? "e" : "") << "\n";
         }
     }
 
@@ -101,17 +157,261 @@ std::string PDA::toString() const {
 
 CFG PDA::toCFG() const {
     // TODO: convert PDA to  CFG
-    return CFG("");
+    return CFG("", memory);
 }
 
 void PDA::parseStackStartSymbol(const std::string& stack_start_symbol_str) {
-    stack_start_symbol = stack_start_symbol_str;
+    std::vector<std::string> fields = splitFields(stack_start_symbol_str);
+    if (!fields.empty()) {
+        stack_start_symbol = stack_alphabet.intern(fields[0]);
+    }
 }
 
 void PDA::parseTransitions(const std::string& transitions_str) {
-    std::istringstream iss(transitions_str);
-    std::string state, input_symbol, stack_symbol, next_state, stack_op;
+    std::vector<std::string> fields = splitFields(transitions_str);
+    if (fields.empty()) {
+        return;
+    }
+    if (fields.size() != 5) {
+        has_unknown_names = true;
+        return;
+    }
+
+    const std::string& state = fields[0];
+    const std::string& input_symbol = fields[1];
+    const std::string& stack_symbol = fields[2];
+    const std::string& next_state = fields[3];
+    const std::string& stack_op = fields[4];
+
+    PDATransition transition{ EPSILON, EPSILON, states.find(next_state), std::pmr::vector<std::uint32_t>(memory) };
+    std::uint32_t state_id = states.find(state);
+    if (input_symbol != "e") {
+        transition.input = alphabet.find(input_symbol);
+    }
+    if (stack_symbol != "e") {
+        transition.pop = stack_alphabet.intern(stack_symbol);
+    }
+
+    // Stack symbols are single characters; the push string is written top first
+    if (stack_op != "e") {
+        for (char symbol : stack_op) {
+            transition.push.push_back(stack_alphabet.intern(std::string_view(&symbol, 1)));
+        }
+    }
+
+    if (state_id == NO_STATE || transition.input == SymbolTable::NO_SYMBOL || transition.next_state == NO_STATE) {
+        has_unknown_names = true;
+        return;
+    }
+
+    transitions[state_id].push_back(std::move(transition));
+}
+
+DeterministicPDA::DeterministicPDA(const PDA& pda)
+    : state_count(pda.stateCount()), tops(pda.stackSymbolCount() + 1), columns(pda.symbolCount() + 1),
+    start_state(pda.startState()), stack_start_symbol(pda.stackStartSymbol()), accepting(state_count),
+    table(std::size_t(state_count) * tops * columns, NO_MOVE) {
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        accepting[state] = pda.isAccepting(state);
+        for (const PDATransition& transition : pda.transitionsFrom(state)) {
+            std::uint32_t move = static_cast<std::uint32_t>(moves.size());
+            std::uint32_t push_begin = static_cast<std::uint32_t>(push_symbols.size());
+            push_symbols.insert(push_symbols.end(), transition.push.rbegin(), transition.push.rend());
+            moves.push_back(Move{ transition.next_state, transition.pop != PDA::EPSILON, push_begin,
+                static_cast<std::uint32_t>(push_symbols.size()) });
+
+            // A move that pops nothing applies whatever the top is, including an empty stack
+            std::uint32_t column = transition.input == PDA::EPSILON ? columns - 1 : transition.input;
+            std::uint32_t first_top = transition.pop == PDA::EPSILON ? 0 : transition.pop;
+            std::uint32_t last_top = transition.pop == PDA::EPSILON ? tops - 1 : transition.pop;
+            for (std::uint32_t top = first_top; top <= last_top; ++top) {
+                table[(std::size_t(state) * tops + top) * columns + column] = move;
+            }
+        }
+    }
+}
+
+DeterministicPDA::Outcome DeterministicPDA::run(const SymbolTokenizer& tokenizer, std::string_view input) const {
+    std::vector<std::uint32_t> stack(1, stack_start_symbol);
+    std::uint32_t state = start_state;
+    const std::uint32_t empty_top = tops - 1;
+    const std::uint32_t epsilon_column = columns - 1;
+
+    auto lookup = [&](std::uint32_t column) {
+        std::uint32_t top = stack.empty() ? empty_top : stack.back();
+        return table[(std::size_t(state) * tops + top) * columns + column];
+    };
+    auto apply = [&](const Move& move) {
+        if (move.pop) {
+            stack.pop_back();
+        }
+        stack.insert(stack.end(), push_symbols.begin() + move.push_begin, push_symbols.begin() + move.push_end);
+        state = move.next_state;
+    };
 
-    iss >> state >> input_symbol >> stack_symbol >> next_state >> stack_op;
-    transitions[state][input_symbol][stack_symbol].push_back(std::make_pair(next_state, stack_op));
-}
\ No newline at end of file
+    // Epsilon moves after each input symbol. Like PDARun they may not grow the stack more than
+    // MAX_EPSILON_GROWTH past where they started; a move that would is dropped, which leaves
+    // the run stuck. accepted records whether any configuration on the way accepts.
+    bool stuck = false;
+    bool accepted = false;
+    bool undecided = false;
+    // Epoch in which each state was last reached; the epoch moves on whenever the stack changes,
+    // so reaching a state twice in one epoch means the chain repeats a configuration
+    std::vector<std::uint64_t> reached(state_count, 0);
+    std::uint64_t epoch = 0;
+    auto followEpsilon = [&]() {
+        std::size_t max_depth = stack.size() + PDARun::MAX_EPSILON_GROWTH;
+        // A chain this long is all but certainly looping; the general search settles loops
+        // with its duplicate check
+        std::size_t chain_limit = (std::size_t(state_count) + 1) * (max_depth + 1);
+        accepted = accepting[state];
+        reached[state] = ++epoch;
+        for (std::size_t length = 0;; ++length) {
+            std::uint32_t next = lookup(epsilon_column);
+            if (next == NO_MOVE) {
+                return;
+            }
+            const Move& move = moves[next];
+            if (stack.size() - move.pop + (move.push_end - move.push_begin) > max_depth) {
+                stuck = true;
+                return;
+            }
+            if (length == chain_limit) {
+                undecided = true;
+                return;
+            }
+            ResourceBudget::checkpoint();
+            bool keeps_stack = move.push_end - move.push_begin == (move.pop ? 1u : 0u) &&
+                (!move.pop || push_symbols[move.push_begin] == stack.back());
+            apply(move);
+            accepted |= accepting[state];
+            if (!keeps_stack) {
+                ++epoch;
+            }
+            else if (reached[state] == epoch) {
+                undecided = true;
+                return;
+            }
+            reached[state] = epoch;
+        }
+    };
+
+    followEpsilon();
+    bool consumed = tokenizer.forEach(input, [&](std::uint32_t symbol) {
+        ResourceBudget::checkpoint();
+        std::uint32_t next = stuck || undecided ? NO_MOVE : lookup(symbol);
+        if (next == NO_MOVE) {
+            return false;
+        }
+        apply(moves[next]);
+        followEpsilon();
+        return true;
+    });
+
+    if (undecided) {
+        return Outcome::Undecided;
+    }
+    return consumed && accepted ? Outcome::Accept : Outcome::Reject;
+}
+
+PDARun::PDARun(const PDA& pda) : pda(pda) {
+    reset();
+}
+
+void PDARun::reset() {
+    current.clear();
+    seen.clear();
+    nodes.clear();
+    node_ids.clear();
+    if (pda.startState() == PDA::NO_STATE || pda.stackStartSymbol() == PDA::NO_STATE) {
+        return;
+    }
+    add(PDAConfiguration{ pda.startState(), push(pda.stackStartSymbol(), EMPTY_STACK) });
+    followEpsilon();
+}
+
+bool PDARun::step(std::uint32_t symbol) {
+    std::vector<PDAConfiguration> previous;
+    previous.swap(current);
+    seen.clear();
+
+    PDAConfiguration next{};
+    for (const PDAConfiguration& configuration : previous) {
+        for (const PDATransition& transition : pda.transitionsFrom(configuration.state)) {
+            if (transition.input == symbol && apply(configuration, transition, 0xffffffffu, next)) {
+                add(next);
+            }
+        }
+    }
+    followEpsilon();
+    return !current.empty();
+}
+
+bool PDARun::accepting() const {
+    for (const PDAConfiguration& configuration : current) {
+        if (pda.isAccepting(configuration.state)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::uint32_t PDARun::push(std::uint32_t symbol, std::uint32_t below) {
+    std::uint64_t key = (std::uint64_t(symbol) << 32) | below;
+    auto it = node_ids.find(key);
+    if (it != node_ids.end()) {
+        return it->second;
+    }
+
+    nodes.push_back(StackNode{ symbol, below, depth(below) + 1 });
+    node_ids.emplace(key, static_cast<std::uint32_t>(nodes.size() - 1));
+    return static_cast<std::uint32_t>(nodes.size() - 1);
+}
+
+bool PDARun::apply(const PDAConfiguration& from, const PDATransition& transition, std::uint32_t max_depth,
+    PDAConfiguration& to) {
+    std::uint32_t stack = from.stack;
+    if (transition.pop != PDA::EPSILON) {
+        if (stack == EMPTY_STACK || nodes[stack].symbol != transition.pop) {
+            return false;
+        }
+        stack = nodes[stack].below;
+    }
+
+    if (depth(stack) + transition.push.size() > max_depth) {
+        return false;
+    }
+    // push[0] ends up on top, so push the string back to front
+    for (auto it = transition.push.rbegin(); it != transition.push.rend(); ++it) {
+        stack = push(*it, stack);
+    }
+
+    to = PDAConfiguration{ transition.next_state, stack };
+    return true;
+}
+
+void PDARun::add(const PDAConfiguration& configuration) {
+    if (seen.insert((std::uint64_t(configuration.state) << 32) | configuration.stack).second) {
+        ResourceBudget::chargeStates();
+        current.push_back(configuration);
+    }
+}
+
+void PDARun::followEpsilon() {
+    std::uint32_t max_depth = 0;
+    for (const PDAConfiguration& configuration : current) {
+        max_depth = std::max(max_depth, depth(configuration.stack));
+    }
+    max_depth += MAX_EPSILON_GROWTH;
+
+    // current doubles as the worklist: configurations added here are expanded in turn
+    PDAConfiguration next{};
+    for (std::size_t i = 0; i < current.size(); ++i) {
+        PDAConfiguration configuration = current[i];
+        for (const PDATransition& transition : pda.transitionsFrom(configuration.state)) {
+            if (transition.input == PDA::EPSILON && apply(configuration, transition, max_depth, next)) {
+                add(next);
+            }
+        }
+    }
+}
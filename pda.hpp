@@ -3,25 +3,149 @@
 
 #include <string>
 #include <vector>
-#include <unordered_set>
 #include <unordered_map>
+#include <unordered_set>
+#include <memory>
 #include "automaton.hpp"
 #include "cfg.hpp"
 
+struct PDATransition {
+    std::uint32_t input;            // alphabet id, or PDA::EPSILON
+    std::uint32_t pop;              // stack symbol id, or PDA::EPSILON
+    std::uint32_t next_state;
+    std::pmr::vector<std::uint32_t> push;  // push[0] ends up on top of the stack
+};
+
+class DeterministicPDA;
+
 class PDA : public Automaton {
 public:
-    PDA(const std::string& pda_str);
+    static constexpr std::uint32_t EPSILON = 0xfffffffeu;
+
+    PDA(const std::string& pda_str, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
     bool validate() const override;
     bool accepts(const std::string& input_str) const override;
     std::string toString() const override;
     CFG toCFG() const;
 
+    // Read access to the transition map for the engines built on top of it
+    std::uint32_t stateCount() const { return states.size(); }
+    std::uint32_t symbolCount() const { return alphabet.size(); }
+    std::uint32_t stackSymbolCount() const { return stack_alphabet.size(); }
+    std::uint32_t startState() const { return start_state; }
+    std::uint32_t stackStartSymbol() const { return stack_start_symbol; }
+    bool isAccepting(std::uint32_t state) const { return accept_states.contains(state); }
+    const std::pmr::string& stateName(std::uint32_t state) const { return states.name(state); }
+    const std::pmr::string& symbolName(std::uint32_t symbol) const { return alphabet.name(symbol); }
+    const std::pmr::string& stackSymbolName(std::uint32_t symbol) const { return stack_alphabet.name(symbol); }
+    std::uint32_t symbolId(std::string_view symbol) const { return alphabet.find(symbol); }
+    const std::pmr::vector<PDATransition>& transitionsFrom(std::uint32_t state) const { return transitions[state]; }
+
+    // True when no configuration ever has two moves to choose from: no two transitions of a
+    // state agree on the input (or one reads nothing) and on the popped symbol (or one pops
+    // nothing)
+    bool isDeterministic() const { return deterministic; }
+
 private:
-    std::string stack_start_symbol;
-    std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>>>> transitions;
+    SymbolTable stack_alphabet;
+    std::uint32_t stack_start_symbol;
+    // transitions[state] lists every transition leaving that state
+    std::pmr::vector<std::pmr::vector<PDATransition>> transitions;
+    bool deterministic;
+    // Compiled once the definition is complete when the PDA is deterministic; shared between copies
+    std::shared_ptr<const DeterministicPDA> fast_path;
 
     void parseStackStartSymbol(const std::string& stack_start_symbol_str);
     void parseTransitions(const std::string& transitions_str);
 };
 
-#endif
\ No newline at end of file
+// Linear-time run of a deterministic PDA: one stack in a flat vector and one table lookup
+// per move. table[(state * (stack symbols + 1) + top) * (symbols + 1) + input] is the only move
+// that applies, with top = stack symbols on an empty stack and input = symbols for the
+// epsilon move. Epsilon moves follow the same rules as PDARun, so both always agree, except
+// that an epsilon chain longer than the general search could ever need leaves the answer to
+// PDARun.
+class DeterministicPDA {
+public:
+    enum class Outcome { Accept, Reject, Undecided };
+
+    // Largest table worth building; bigger machines always take the general search
+    static constexpr std::size_t MAX_TABLE_SIZE = std::size_t(1) << 22;
+
+    explicit DeterministicPDA(const PDA& pda);
+
+    Outcome run(const SymbolTokenizer& tokenizer, std::string_view input) const;
+
+private:
+    static constexpr std::uint32_t NO_MOVE = 0xffffffffu;
+
+    struct Move {
+        std::uint32_t next_state;
+        std::uint32_t pop;              // 1 when the move pops the top symbol
+        std::uint32_t push_begin;       // into push_symbols, bottom of the pushed string first
+        std::uint32_t push_end;
+    };
+
+    std::uint32_t state_count;
+    std::uint32_t tops;
+    std::uint32_t columns;
+    std::uint32_t start_state;
+    std::uint32_t stack_start_symbol;
+    std::vector<bool> accepting;
+    std::vector<std::uint32_t> table;
+    std::vector<Move> moves;
+    std::vector<std::uint32_t> push_symbols;
+};
+
+struct PDAConfiguration {
+    std::uint32_t state;
+    std::uint32_t stack;    // node in the run's stack tree, PDARun::EMPTY_STACK when empty
+};
+
+// Nondeterministic simulation of a PDA, one input symbol at a time. Stacks live in a
+// hash-consed tree, so configurations share common stack suffixes and two configurations with
+// the same state and stack contents compare equal as two integers. Epsilon moves may grow a
+// stack by at most MAX_EPSILON_GROWTH past the deepest stack they start from; configurations
+// beyond that are dropped, which stops runaway epsilon pushes.
+class PDARun {
+public:
+    static constexpr std::uint32_t EMPTY_STACK = 0xffffffffu;
+    static constexpr std::uint32_t MAX_EPSILON_GROWTH = 256;
+
+    explicit PDARun(const PDA& pda);
+
+    // Back to the start configuration, followed by its epsilon moves
+    void reset();
+    // Consumes one input symbol and follows the epsilon moves after it; false once no configuration is left
+    bool step(std::uint32_t symbol);
+    // Acceptance by final state
+    bool accepting() const;
+
+    const std::vector<PDAConfiguration>& configurations() const { return current; }
+    // Top stack symbol of a configuration, or PDA::EPSILON when its stack is empty
+    std::uint32_t top(const PDAConfiguration& configuration) const {
+        return configuration.stack == EMPTY_STACK ? PDA::EPSILON : nodes[configuration.stack].symbol;
+    }
+
+private:
+    struct StackNode {
+        std::uint32_t symbol;
+        std::uint32_t below;
+        std::uint32_t depth;
+    };
+
+    const PDA& pda;
+    std::vector<StackNode> nodes;
+    // (symbol, below) -> node, so equal stacks always get the same node
+    std::unordered_map<std::uint64_t, std::uint32_t> node_ids;
+    std::vector<PDAConfiguration> current;
+    std::unordered_set<std::uint64_t> seen;
+
+    std::uint32_t push(std::uint32_t symbol, std::uint32_t below);
+    std::uint32_t depth(std::uint32_t stack) const { return stack == EMPTY_STACK ? 0 : nodes[stack].depth; }
+    bool apply(const PDAConfiguration& from, const PDATransition& transition, std::uint32_t max_depth, PDAConfiguration& to);
+    void add(const PDAConfiguration& configuration);
+    void followEpsilon();
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef PHASE_TIMER_HPP
+#define PHASE_TIMER_HPP
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <sstream>
+#include <utility>
+
+// Phase timing is on in debug builds and compiled out when NDEBUG is set.
+// Build with -DTOC_SERVER_TIMING=0/1 to override either way.
+#ifndef TOC_SERVER_TIMING
+#ifdef NDEBUG
+#define TOC_SERVER_TIMING 0
+#else
+#define TOC_SERVER_TIMING 1
+#endif
+#endif
+
+#if TOC_SERVER_TIMING
+
+class PhaseTimer {
+public:
+    // Records the time between construction and destruction under the given name
+    class Scope {
+    public:
+        Scope(PhaseTimer& timer, const char* name)
+            : timer(timer), name(name), start(std::chrono::steady_clock::now()) {}
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope() {
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            timer.phases.emplace_back(name, elapsed.count());
+        }
+
+    private:
+        PhaseTimer& timer;
+        const char* name;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // Value of the Server-Timing header, e.g. "parse;dur=0.012, build;dur=0.104"
+    std::string header() const {
+        std::ostringstream oss;
+        for (size_t i = 0; i < phases.size(); ++i) {
+            if (i > 0) {
+                oss << ", ";
+            }
+            oss << phases[i].first << ";dur=" << phases[i].second;
+        }
+        return oss.str();
+    }
+
+    // JSON object with the same durations in milliseconds
+    std::string json() const {
+        std::ostringstream oss;
+        oss << "{";
+        for (size_t i = 0; i < phases.size(); ++i) {
+            if (i > 0) {
+                oss << ", ";
+            }
+            oss << "\"" << phases[i].first << "\": " << phases[i].second;
+        }
+        oss << "}";
+        return oss.str();
+    }
+
+    bool empty() const { return phases.empty(); }
+
+private:
+    std::vector<std::pair<const char*, double>> phases;
+};
+
+#else
+
+class PhaseTimer {
+public:
+    class Scope {
+    public:
+        Scope(PhaseTimer&, const char*) {}
+    };
+
+    std::string header() const { return std::string(); }
+    std::string json() const { return std::string(); }
+    bool empty() const { return true; }
+};
+
+#endif
+
+#endif
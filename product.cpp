@@ -0,0 +1,241 @@
+#include "product.hpp"
+#include "metrics.hpp"
+#include "budget.hpp"
+#include <unordered_map>
+#include <algorithm>
+
+namespace {
+
+// Both halves of a pair packed into one integer key; NO_STATE stands for the dead state
+std::uint64_t pairKey(std::uint32_t left_state, std::uint32_t right_state) {
+    return (std::uint64_t(left_state) << 32) | right_state;
+}
+
+std::string pairName(const DFA& left, const DFA& right, std::uint32_t left_state, std::uint32_t right_state) {
+    std::string name = left_state == DFA::NO_STATE ? "dead" : std::string(left.stateName(left_state));
+    name += "_";
+    name += right_state == DFA::NO_STATE ? "dead" : std::string(right.stateName(right_state));
+    return name;
+}
+
+// Walks parent links back to the start to spell out the string that reached a state
+std::string spellPath(const std::vector<std::uint32_t>& parents, const std::vector<std::uint32_t>& parent_symbols,
+                      std::uint32_t state, const SymbolTable& alphabet) {
+    std::vector<std::uint32_t> path;
+    for (; parents[state] != DFA::NO_STATE; state = parents[state]) {
+        path.push_back(parent_symbols[state]);
+    }
+
+    std::string word;
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        word += alphabet.name(*it);
+    }
+    return word;
+}
+
+}
+
+DFAProduct::DFAProduct(const DFA& left, const DFA& right, std::pmr::memory_resource* memory)
+    : left(left), right(right), memory(memory), alphabet(memory), left_symbols(memory), right_symbols(memory) {
+    for (std::uint32_t symbol = 0; symbol < left.symbolCount(); ++symbol) {
+        alphabet.intern(left.symbolName(symbol));
+    }
+    for (std::uint32_t symbol = 0; symbol < right.symbolCount(); ++symbol) {
+        alphabet.intern(right.symbolName(symbol));
+    }
+
+    for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+        left_symbols.push_back(left.symbolId(alphabet.name(symbol)));
+        right_symbols.push_back(right.symbolId(alphabet.name(symbol)));
+    }
+}
+
+DFA DFAProduct::build(ProductOperation operation) const {
+    DFA dfa(alphabet, memory);
+    if (!isLive(operation, left.startState(), right.startState())) {
+        return dfa;
+    }
+
+    std::pmr::unordered_map<std::uint64_t, std::uint32_t> pair_ids(memory);
+    std::pmr::vector<std::uint64_t> pairs(memory);
+
+    auto addPair = [&](std::uint32_t left_state, std::uint32_t right_state) {
+        std::string name = pairName(left, right, left_state, right_state);
+        std::uint32_t id = dfa.stateCount();
+        while (dfa.addState(name, isAccepting(operation, left_state, right_state)) != id) {
+            name += "'";
+        }
+        pairs.push_back(pairKey(left_state, right_state));
+        pair_ids.emplace(pairs.back(), id);
+        Metrics::count(EngineCounter::DfaStatesBuilt);
+        ResourceBudget::chargeStates();
+        return id;
+    };
+
+    dfa.setStartState(addPair(left.startState(), right.startState()));
+
+    for (std::uint32_t current = 0; current < pairs.size(); ++current) {
+        std::uint32_t left_state = static_cast<std::uint32_t>(pairs[current] >> 32);
+        std::uint32_t right_state = static_cast<std::uint32_t>(pairs[current]);
+
+        for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+            std::uint32_t left_next = leftNext(left_state, symbol);
+            std::uint32_t right_next = rightNext(right_state, symbol);
+            if (!isLive(operation, left_next, right_next)) {
+                continue;
+            }
+
+            auto it = pair_ids.find(pairKey(left_next, right_next));
+            std::uint32_t next_state = it != pair_ids.end() ? it->second : addPair(left_next, right_next);
+            dfa.setTransition(current, symbol, next_state);
+        }
+    }
+
+    return dfa;
+}
+
+bool DFAProduct::findWitness(ProductOperation operation, std::string& witness) const {
+    if (!isLive(operation, left.startState(), right.startState())) {
+        return false;
+    }
+
+    std::pmr::unordered_map<std::uint64_t, std::uint32_t> pair_ids(memory);
+    std::vector<std::uint64_t> pairs;
+    std::vector<std::uint32_t> parents;
+    std::vector<std::uint32_t> parent_symbols;
+
+    pairs.push_back(pairKey(left.startState(), right.startState()));
+    pair_ids.emplace(pairs.back(), 0);
+    parents.push_back(DFA::NO_STATE);
+    parent_symbols.push_back(0);
+
+    for (std::uint32_t current = 0; current < pairs.size(); ++current) {
+        std::uint32_t left_state = static_cast<std::uint32_t>(pairs[current] >> 32);
+        std::uint32_t right_state = static_cast<std::uint32_t>(pairs[current]);
+
+        // Pairs leave the queue in order of distance, so the first accepting one is a shortest witness
+        if (isAccepting(operation, left_state, right_state)) {
+            witness = spellPath(parents, parent_symbols, current, alphabet);
+            return true;
+        }
+
+        for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+            std::uint32_t left_next = leftNext(left_state, symbol);
+            std::uint32_t right_next = rightNext(right_state, symbol);
+            if (!isLive(operation, left_next, right_next)) {
+                continue;
+            }
+
+            if (pair_ids.emplace(pairKey(left_next, right_next), pairs.size()).second) {
+                ResourceBudget::chargeStates();
+                pairs.push_back(pairKey(left_next, right_next));
+                parents.push_back(current);
+                parent_symbols.push_back(symbol);
+            }
+        }
+    }
+
+    return false;
+}
+
+std::uint32_t DFAProduct::leftNext(std::uint32_t state, std::uint32_t symbol) const {
+    if (state == DFA::NO_STATE || left_symbols[symbol] == SymbolTable::NO_SYMBOL) {
+        return DFA::NO_STATE;
+    }
+    return left.next(state, left_symbols[symbol]);
+}
+
+std::uint32_t DFAProduct::rightNext(std::uint32_t state, std::uint32_t symbol) const {
+    if (state == DFA::NO_STATE || right_symbols[symbol] == SymbolTable::NO_SYMBOL) {
+        return DFA::NO_STATE;
+    }
+    return right.next(state, right_symbols[symbol]);
+}
+
+bool DFAProduct::isLive(ProductOperation operation, std::uint32_t left_state, std::uint32_t right_state) const {
+    // A dead side never accepts again, so some pairs can be dropped without changing the language
+    switch (operation) {
+    case ProductOperation::Intersection:
+        return left_state != DFA::NO_STATE && right_state != DFA::NO_STATE;
+    case ProductOperation::Difference:
+        return left_state != DFA::NO_STATE;
+    default:
+        return left_state != DFA::NO_STATE || right_state != DFA::NO_STATE;
+    }
+}
+
+bool DFAProduct::isAccepting(ProductOperation operation, std::uint32_t left_state, std::uint32_t right_state) const {
+    bool left_accepts = left_state != DFA::NO_STATE && left.isAccepting(left_state);
+    bool right_accepts = right_state != DFA::NO_STATE && right.isAccepting(right_state);
+
+    switch (operation) {
+    case ProductOperation::Union:
+        return left_accepts || right_accepts;
+    case ProductOperation::Intersection:
+        return left_accepts && right_accepts;
+    case ProductOperation::Difference:
+        return left_accepts && !right_accepts;
+    default:
+        return left_accepts != right_accepts;
+    }
+}
+
+DFA complementDFA(const DFA& dfa, std::pmr::memory_resource* memory) {
+    DFA complement(dfa.symbols(), memory);
+    for (std::uint32_t state = 0; state < dfa.stateCount(); ++state) {
+        complement.addState(dfa.stateName(state), !dfa.isAccepting(state));
+    }
+
+    // The dead state absorbs every missing transition, and is accepting once flipped
+    std::string dead_name = "dead";
+    while (dfa.stateId(dead_name) != DFA::NO_STATE) {
+        dead_name += "'";
+    }
+    std::uint32_t dead = complement.addState(dead_name, true);
+
+    complement.setStartState(dfa.startState() == DFA::NO_STATE ? dead : dfa.startState());
+    for (std::uint32_t state = 0; state <= dead; ++state) {
+        for (std::uint32_t symbol = 0; symbol < dfa.symbolCount(); ++symbol) {
+            std::uint32_t next_state = state == dead ? DFA::NO_STATE : dfa.next(state, symbol);
+            complement.setTransition(state, symbol, next_state == DFA::NO_STATE ? dead : next_state);
+        }
+    }
+
+    return complement;
+}
+
+bool findAccepted(const DFA& dfa, std::string& witness) {
+    if (dfa.startState() == DFA::NO_STATE) {
+        return false;
+    }
+
+    std::vector<std::uint32_t> parents(dfa.stateCount(), DFA::NO_STATE);
+    std::vector<std::uint32_t> parent_symbols(dfa.stateCount(), 0);
+    std::vector<bool> seen(dfa.stateCount(), false);
+    std::vector<std::uint32_t> queue{ dfa.startState() };
+    seen[dfa.startState()] = true;
+
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        std::uint32_t state = queue[head];
+        if (dfa.isAccepting(state)) {
+            witness = spellPath(parents, parent_symbols, state, dfa.symbols());
+            return true;
+        }
+
+        for (std::uint32_t symbol = 0; symbol < dfa.symbolCount(); ++symbol) {
+            std::uint32_t next_state = dfa.next(state, symbol);
+            if (next_state != DFA::NO_STATE && !seen[next_state]) {
+                seen[next_state] = true;
+                parents[next_state] = state;
+                parent_symbols[next_state] = symbol;
+                queue.push_back(next_state);
+            }
+        }
+    }
+
+    return false;
+}
+
+bool isSubset(const DFA& left, const DFA& right, std::string& counterexample) {
+    return !DFAProduct(left, right).findWitness(ProductOperation::Difference, counterexample);
+}
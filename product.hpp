@@ -0,0 +1,49 @@
+#ifndef PRODUCT_HPP
+#define PRODUCT_HPP
+
+#include <string>
+#include <cstdint>
+#include "dfa.hpp"
+
+enum class ProductOperation { Union, Intersection, Difference, SymmetricDifference };
+
+// Pair automaton over two DFAs, explored on the fly from the start pair so only reachable
+// pairs are ever created. Alphabets are matched by symbol name; a symbol or transition
+// missing on one side leads to that side's implicit dead state, so neither input has to be
+// complete. Pairs that can no longer accept under the operation (e.g. a dead left side for
+// a difference) are pruned instead of being expanded.
+class DFAProduct {
+public:
+    DFAProduct(const DFA& left, const DFA& right, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    // Materializes the reachable part of the product as a DFA over the union alphabet
+    DFA build(ProductOperation operation) const;
+    // Breadth-first search for an accepted pair, stopping at the first one found; writes a
+    // shortest string reaching it. Returns false when the product language is empty.
+    bool findWitness(ProductOperation operation, std::string& witness) const;
+
+private:
+    const DFA& left;
+    const DFA& right;
+    std::pmr::memory_resource* memory;
+    SymbolTable alphabet;
+    // Per union-alphabet symbol, the matching symbol id on each side (NO_SYMBOL if absent)
+    std::pmr::vector<std::uint32_t> left_symbols;
+    std::pmr::vector<std::uint32_t> right_symbols;
+
+    std::uint32_t leftNext(std::uint32_t state, std::uint32_t symbol) const;
+    std::uint32_t rightNext(std::uint32_t state, std::uint32_t symbol) const;
+    bool isLive(ProductOperation operation, std::uint32_t left_state, std::uint32_t right_state) const;
+    bool isAccepting(ProductOperation operation, std::uint32_t left_state, std::uint32_t right_state) const;
+};
+
+// Completes the DFA with a dead state over its own alphabet and flips the accept states
+DFA complementDFA(const DFA& dfa, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+// Shortest accepted string, or false if the language is empty
+bool findAccepted(const DFA& dfa, std::string& witness);
+
+// L(left) ⊆ L(right), checked as emptiness of left \ right; on failure writes a shortest counterexample
+bool isSubset(const DFA& left, const DFA& right, std::string& counterexample);
+
+#endif
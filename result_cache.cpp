@@ -0,0 +1,286 @@
+#include "result_cache.hpp"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace {
+    bool readAt(int fd, void* data, std::size_t size, std::uint64_t offset) {
+        char* out = static_cast<char*>(data);
+        while (size > 0) {
+            ssize_t n = ::pread(fd, out, size, static_cast<off_t>(offset));
+            if (n <= 0) {
+                return false;
+            }
+            out += n;
+            size -= static_cast<std::size_t>(n);
+            offset += static_cast<std::uint64_t>(n);
+        }
+        return true;
+    }
+
+    bool writeAt(int fd, const void* data, std::size_t size, std::uint64_t offset) {
+        const char* in = static_cast<const char*>(data);
+        while (size > 0) {
+            ssize_t n = ::pwrite(fd, in, size, static_cast<off_t>(offset));
+            if (n <= 0) {
+                return false;
+            }
+            in += n;
+            size -= static_cast<std::size_t>(n);
+            offset += static_cast<std::uint64_t>(n);
+        }
+        return true;
+    }
+}
+
+ResultCacheOptions ResultCacheOptions::fromEnvironment() {
+    ResultCacheOptions options;
+    if (const char* path = std::getenv("TOC_CACHE_PATH")) {
+        options.path = path;
+    }
+    if (const char* bytes = std::getenv("TOC_CACHE_BYTES")) {
+        char* end = nullptr;
+        unsigned long long parsed = std::strtoull(bytes, &end, 10);
+        if (end != bytes && *end == '\0' && parsed > 0) {
+            options.max_bytes = static_cast<std::size_t>(parsed);
+        }
+    }
+    return options;
+}
+
+ResultCache::ResultCache(const ResultCacheOptions& options) : options(options) {
+    if (!options.path.empty()) {
+        open();
+    }
+}
+
+ResultCache::~ResultCache() {
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+std::size_t ResultCache::entries() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.size();
+}
+
+std::string ResultCache::normalize(std::string_view definition) {
+    std::string normalized;
+    normalized.reserve(definition.size());
+    std::size_t line_end = 0;
+    for (char c : definition) {
+        if (c == '\r') {
+            continue;
+        }
+        if (c == '\n') {
+            // Trailing blanks of the line just finished
+            normalized.resize(line_end);
+            normalized += '\n';
+            line_end = normalized.size();
+            continue;
+        }
+        normalized += c;
+        if (c != ' ' && c != '\t') {
+            line_end = normalized.size();
+        }
+    }
+    normalized.resize(line_end);
+    while (!normalized.empty() && normalized.back() == '\n') {
+        normalized.pop_back();
+    }
+    return normalized;
+}
+
+// FNV-1a over the kind and key; only used in memory and in record headers, never as identity
+std::uint64_t ResultCache::hashKey(ResultKind kind, std::string_view key) {
+    std::uint64_t hash = 0xcbf29ce484222325ull;
+    hash = (hash ^ static_cast<std::uint8_t>(kind)) * 0x100000001b3ull;
+    for (char c : key) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::uint32_t ResultCache::checksum(const RecordHeader& header, std::string_view key, std::string_view value) {
+    uLong crc = crc32(0L, Z_NULL, 0);
+    const Bytef* fields = reinterpret_cast<const Bytef*>(&header) + sizeof(header.checksum);
+    crc = crc32(crc, fields, sizeof(RecordHeader) - sizeof(header.checksum));
+    crc = crc32(crc, reinterpret_cast<const Bytef*>(key.data()), static_cast<uInt>(key.size()));
+    crc = crc32(crc, reinterpret_cast<const Bytef*>(value.data()), static_cast<uInt>(value.size()));
+    return static_cast<std::uint32_t>(crc);
+}
+
+bool ResultCache::lookup(ResultKind kind, std::string_view definition, std::string& value) {
+    if (fd < 0) {
+        return false;
+    }
+    std::string key = normalize(definition);
+    std::uint64_t key_hash = hashKey(kind, key);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key_hash);
+    if (it == index.end() || it->second.key_size != key.size()) {
+        return false;
+    }
+
+    Entry& entry = it->second;
+    RecordHeader header;
+    std::string record(entry.key_size + entry.value_size, '\0');
+    if (!readAt(fd, &header, sizeof(header), entry.offset) ||
+        !readAt(fd, record.data(), record.size(), entry.offset + sizeof(header))) {
+        return false;
+    }
+    std::string_view stored_key(record.data(), entry.key_size);
+    std::string_view stored_value(record.data() + entry.key_size, entry.value_size);
+    if (header.kind != static_cast<std::uint8_t>(kind) || stored_key != key ||
+        header.checksum != checksum(header, stored_key, stored_value)) {
+        return false;
+    }
+
+    entry.last_used = ++clock;
+    value.assign(stored_value);
+    return true;
+}
+
+void ResultCache::store(ResultKind kind, std::string_view definition, std::string_view value) {
+    if (fd < 0) {
+        return;
+    }
+    std::string key = normalize(definition);
+    // A record that would fill most of the cache on its own is not worth keeping
+    if (sizeof(RecordHeader) + key.size() + value.size() > options.max_bytes / 2) {
+        return;
+    }
+    std::uint64_t key_hash = hashKey(kind, key);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!append(fd, end, kind, key_hash, key, value)) {
+        std::cerr << "Result cache: write to " << options.path << " failed\n";
+        return;
+    }
+    Entry entry{ end, static_cast<std::uint32_t>(key.size()), static_cast<std::uint32_t>(value.size()), ++clock };
+    index[key_hash] = entry;
+    end += recordSize(entry);
+
+    if (end > options.max_bytes) {
+        compact();
+    }
+}
+
+void ResultCache::open() {
+    fd = ::open(options.path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "Result cache: cannot open " << options.path << ", caching disabled\n";
+        return;
+    }
+    load();
+}
+
+// Rebuilds the index from the record headers; a later record for the same key replaces the
+// earlier one. A log with another format is started over.
+void ResultCache::load() {
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        fd = -1;
+        return;
+    }
+    std::uint64_t size = static_cast<std::uint64_t>(info.st_size);
+
+    char magic[sizeof(MAGIC)];
+    if (size < sizeof(MAGIC) || !readAt(fd, magic, sizeof(magic), 0) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        if (::ftruncate(fd, 0) != 0 || !writeAt(fd, MAGIC, sizeof(MAGIC), 0)) {
+            ::close(fd);
+            fd = -1;
+            return;
+        }
+        end = sizeof(MAGIC);
+        return;
+    }
+
+    std::uint64_t offset = sizeof(MAGIC);
+    RecordHeader header;
+    while (offset + sizeof(header) <= size && readAt(fd, &header, sizeof(header), offset)) {
+        Entry entry{ offset, header.key_size, header.value_size, 0 };
+        if (offset + recordSize(entry) > size) {
+            break;
+        }
+        index[header.key_hash] = entry;
+        offset += recordSize(entry);
+    }
+    if (offset < size && ::ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+        std::cerr << "Result cache: cannot truncate " << options.path << "\n";
+    }
+    end = offset;
+}
+
+bool ResultCache::append(int file, std::uint64_t offset, ResultKind kind, std::uint64_t key_hash,
+    std::string_view key, std::string_view value) {
+    RecordHeader header{};
+    header.kind = static_cast<std::uint8_t>(kind);
+    header.key_size = static_cast<std::uint32_t>(key.size());
+    header.value_size = static_cast<std::uint32_t>(value.size());
+    header.key_hash = key_hash;
+    header.checksum = checksum(header, key, value);
+
+    std::string record(reinterpret_cast<const char*>(&header), sizeof(header));
+    record.append(key);
+    record.append(value);
+    return writeAt(file, record.data(), record.size(), offset);
+}
+
+// Copies the most recently used records, up to half of max_bytes, into a new log in their
+// original order and renames it over the old one
+void ResultCache::compact() {
+    std::vector<std::pair<std::uint64_t, Entry>> live(index.begin(), index.end());
+    std::sort(live.begin(), live.end(),
+        [](const auto& a, const auto& b) { return a.second.last_used > b.second.last_used; });
+    std::uint64_t kept_size = sizeof(MAGIC);
+    std::size_t kept = 0;
+    while (kept < live.size() && kept_size + recordSize(live[kept].second) <= options.max_bytes / 2) {
+        kept_size += recordSize(live[kept].second);
+        ++kept;
+    }
+    live.resize(kept);
+    std::sort(live.begin(), live.end(),
+        [](const auto& a, const auto& b) { return a.second.offset < b.second.offset; });
+
+    std::string temporary = options.path + ".compact";
+    int out = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        std::cerr << "Result cache: cannot create " << temporary << "\n";
+        return;
+    }
+    bool ok = writeAt(out, MAGIC, sizeof(MAGIC), 0);
+    std::uint64_t offset = sizeof(MAGIC);
+    std::string record;
+    for (auto& [key_hash, entry] : live) {
+        if (!ok) {
+            break;
+        }
+        record.resize(recordSize(entry));
+        ok = readAt(fd, record.data(), record.size(), entry.offset) && writeAt(out, record.data(), record.size(), offset);
+        entry.offset = offset;
+        offset += record.size();
+    }
+    if (!ok || ::fsync(out) != 0 || std::rename(temporary.c_str(), options.path.c_str()) != 0) {
+        std::cerr << "Result cache: compaction of " << options.path << " failed\n";
+        ::close(out);
+        std::remove(temporary.c_str());
+        return;
+    }
+
+    ::close(fd);
+    fd = out;
+    end = offset;
+    index.clear();
+    index.insert(live.begin(), live.end());
+}
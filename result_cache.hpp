@@ -0,0 +1,94 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+// Conversions whose results are kept; the kind is part of the key. Kind 2 was PDA to CFG,
+// dropped while that conversion is unimplemented; records of it in old logs never match
+enum class ResultKind : std::uint8_t { NfaToDfa = 1 };
+
+struct ResultCacheOptions {
+    // Log file; empty, the default, disables the cache. It holds every client's definitions, so
+    // it belongs outside the directory the server serves files from
+    std::string path;
+    // Compaction starts once the log grows past this and keeps the most recently used half
+    std::size_t max_bytes = std::size_t(64) << 20;
+
+    // Defaults overridden by the TOC_CACHE_PATH and TOC_CACHE_BYTES environment variables
+    static ResultCacheOptions fromEnvironment();
+};
+
+// Disk-backed cache of conversion results, which are deterministic functions of the
+// definition text, so they survive restarts. The file is an append-only log of records
+// (header, key, value), each with a CRC over its contents. Opening the cache reads only the
+// record headers to rebuild the in-memory index from key hash to record; values are read
+// from disk on a hit, and the key stored with the record is compared so hash collisions
+// miss instead of returning another machine's result. A torn record at the end of the log,
+// left by a crash mid-write, is cut off when the cache is opened.
+//
+// Once the log passes max_bytes it is rewritten with the most recently used live records up
+// to half that size, then renamed over the old log, so a crash during compaction leaves the
+// old log intact.
+class ResultCache {
+public:
+    explicit ResultCache(const ResultCacheOptions& options = ResultCacheOptions());
+    ~ResultCache();
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    bool enabled() const { return fd >= 0; }
+    const std::string& path() const { return options.path; }
+    std::size_t entries() const;
+
+    // Looks up the result for definition, normalized first; false on a miss
+    bool lookup(ResultKind kind, std::string_view definition, std::string& value);
+    void store(ResultKind kind, std::string_view definition, std::string_view value);
+
+    // Line endings and trailing blanks do not change a definition's meaning, so they are
+    // dropped before hashing and comparing
+    static std::string normalize(std::string_view definition);
+
+private:
+    struct RecordHeader {
+        std::uint32_t checksum;
+        std::uint8_t kind;
+        std::uint8_t padding[3];
+        std::uint32_t key_size;
+        std::uint32_t value_size;
+        std::uint64_t key_hash;
+    };
+    struct Entry {
+        std::uint64_t offset;
+        std::uint32_t key_size;
+        std::uint32_t value_size;
+        std::uint64_t last_used;
+    };
+
+    static constexpr char MAGIC[8] = { 'T', 'O', 'C', 'R', 'C', '0', '0', '1' };
+
+    static std::uint64_t hashKey(ResultKind kind, std::string_view key);
+    static std::uint32_t checksum(const RecordHeader& header, std::string_view key, std::string_view value);
+    static std::uint64_t recordSize(const Entry& entry) {
+        return sizeof(RecordHeader) + entry.key_size + entry.value_size;
+    }
+
+    void open();
+    void load();
+    bool append(int file, std::uint64_t offset, ResultKind kind, std::uint64_t key_hash, std::string_view key,
+        std::string_view value);
+    void compact();
+
+    ResultCacheOptions options;
+    int fd = -1;
+    std::uint64_t end = 0;
+    std::uint64_t clock = 0;
+    std::unordered_map<std::uint64_t, Entry> index;
+    mutable std::mutex mutex;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include "search.hpp"
+#include "budget.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr std::uint64_t ONES = 0x0101010101010101ull;
+constexpr std::uint64_t HIGH_BITS = 0x8080808080808080ull;
+
+inline std::uint64_t zeroBytes(std::uint64_t word) {
+    return (word - ONES) & ~word & HIGH_BITS;
+}
+
+// First position at or after from holding one of the two or three given bytes
+std::size_t findAny(const char* data, std::size_t from, std::size_t size, const std::vector<unsigned char>& bytes) {
+    std::uint64_t a = ONES * bytes[0], b = ONES * bytes[1], c = ONES * bytes[bytes.size() - 1];
+    std::size_t i = from;
+    for (; i + 8 <= size; i += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        if (zeroBytes(word ^ a) | zeroBytes(word ^ b) | zeroBytes(word ^ c)) {
+            break;
+        }
+    }
+    for (; i < size; ++i) {
+        if (std::find(bytes.begin(), bytes.end(), static_cast<unsigned char>(data[i])) != bytes.end()) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+}
+
+DFASearcher::DFASearcher(const DFA& dfa)
+    : classes(dfa.symbolCount() + 1), accepting(dfa.stateCount()), start(DEAD), pending_offset(0) {
+    std::uint32_t state_count = dfa.stateCount();
+    std::uint32_t other = dfa.symbolCount();
+
+    // Bytes that are not a single-character symbol share the last class, which is always dead
+    std::fill(std::begin(byte_class), std::end(byte_class), other);
+    for (std::uint32_t symbol = 0; symbol < dfa.symbolCount(); ++symbol) {
+        if (dfa.symbolName(symbol).size() == 1) {
+            byte_class[static_cast<unsigned char>(dfa.symbolName(symbol)[0])] = symbol;
+        }
+    }
+
+    // States that can still reach an accept state, by a backward search from the accept states
+    std::vector<std::vector<std::uint32_t>> predecessors(state_count);
+    std::vector<std::uint32_t> worklist;
+    std::vector<bool> live(state_count, false);
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        accepting[state] = dfa.isAccepting(state);
+        if (accepting[state]) {
+            live[state] = true;
+            worklist.push_back(state);
+        }
+        for (std::uint32_t symbol = 0; symbol < dfa.symbolCount(); ++symbol) {
+            std::uint32_t next = dfa.next(state, symbol);
+            if (next != Automaton::NO_STATE) {
+                predecessors[next].push_back(state);
+            }
+        }
+    }
+    while (!worklist.empty()) {
+        std::uint32_t state = worklist.back();
+        worklist.pop_back();
+        for (std::uint32_t previous : predecessors[state]) {
+            if (!live[previous]) {
+                live[previous] = true;
+                worklist.push_back(previous);
+            }
+        }
+    }
+
+    table.assign(std::size_t(state_count) * classes, DEAD);
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        for (std::uint32_t symbol = 0; symbol < dfa.symbolCount(); ++symbol) {
+            std::uint32_t next = dfa.next(state, symbol);
+            if (next != Automaton::NO_STATE && live[next]) {
+                table[std::size_t(state) * classes + symbol] = next;
+            }
+        }
+    }
+    if (dfa.startState() != Automaton::NO_STATE && live[dfa.startState()]) {
+        start = dfa.startState();
+    }
+
+    for (int c = 0; c < 256; ++c) {
+        first_byte[c] = start != DEAD && table[std::size_t(start) * classes + byte_class[c]] != DEAD;
+        if (first_byte[c]) {
+            first_bytes.push_back(static_cast<unsigned char>(c));
+        }
+    }
+
+    // Follow the start state while exactly one byte keeps the run alive and nothing is accepted yet
+    std::uint32_t state = start;
+    while (state != DEAD && !accepting[state] && literal_prefix.size() < MAX_PREFIX) {
+        int only = -1;
+        for (int c = 0; c < 256; ++c) {
+            if (table[std::size_t(state) * classes + byte_class[c]] != DEAD) {
+                only = only < 0 ? c : 256;
+            }
+        }
+        if (only < 0 || only == 256) {
+            break;
+        }
+        literal_prefix += static_cast<char>(only);
+        state = table[std::size_t(state) * classes + byte_class[only]];
+    }
+}
+
+std::size_t DFASearcher::nextCandidate(const char* data, std::size_t from, std::size_t size) const {
+    if (from >= size || first_bytes.empty()) {
+        return std::string_view::npos;
+    }
+
+    if (literal_prefix.size() >= 2) {
+        const void* found = memmem(data + from, size - from, literal_prefix.data(), literal_prefix.size());
+        return found ? static_cast<const char*>(found) - data : std::string_view::npos;
+    }
+    if (first_bytes.size() == 1) {
+        const void* found = std::memchr(data + from, first_bytes[0], size - from);
+        return found ? static_cast<const char*>(found) - data : std::string_view::npos;
+    }
+    if (first_bytes.size() <= 3) {
+        return findAny(data, from, size, first_bytes);
+    }
+    if (first_bytes.size() == 256) {
+        return from;
+    }
+    for (std::size_t i = from; i < size; ++i) {
+        if (first_byte[static_cast<unsigned char>(data[i])]) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+void DFASearcher::scan(const char* data, std::size_t size, std::uint64_t base, bool final) {
+    std::size_t pos = 0;
+    for (;;) {
+        ResourceBudget::checkpoint();
+        std::size_t candidate = nextCandidate(data, pos, size);
+        if (candidate == std::string_view::npos) {
+            // The start of the literal prefix may be the last few bytes of the chunk
+            std::size_t keep = size;
+            if (!final && literal_prefix.size() >= 2) {
+                keep = std::max(pos, size - std::min(size, literal_prefix.size() - 1));
+            }
+            pending.assign(data + keep, size - keep);
+            pending_offset = base + keep;
+            return;
+        }
+
+        std::uint32_t state = start;
+        std::size_t last_accept = std::string_view::npos;
+        std::size_t i = candidate;
+        while (i < size) {
+            state = table[std::size_t(state) * classes + byte_class[static_cast<unsigned char>(data[i])]];
+            if (state == DEAD) {
+                break;
+            }
+            ++i;
+            if (accepting[state]) {
+                last_accept = i;
+            }
+        }
+
+        // Still alive at the end of the chunk: the match may go on in the next one
+        if (state != DEAD && !final && size - candidate < MAX_PENDING) {
+            pending.assign(data + candidate, size - candidate);
+            pending_offset = base + candidate;
+            return;
+        }
+
+        if (last_accept != std::string_view::npos) {
+            matches.push_back(SearchMatch{ base + candidate, base + last_accept });
+            pos = last_accept;
+        }
+        else {
+            pos = candidate + 1;
+        }
+    }
+}
+
+const std::vector<SearchMatch>& DFASearcher::feed(std::string_view chunk) {
+    matches.clear();
+    if (pending.empty()) {
+        scan(chunk.data(), chunk.size(), pending_offset, false);
+    }
+    else {
+        std::string buffer = std::move(pending);
+        buffer.append(chunk.data(), chunk.size());
+        scan(buffer.data(), buffer.size(), pending_offset, false);
+    }
+    return matches;
+}
+
+const std::vector<SearchMatch>& DFASearcher::finish() {
+    matches.clear();
+    std::string buffer = std::move(pending);
+    scan(buffer.data(), buffer.size(), pending_offset, true);
+    return matches;
+}
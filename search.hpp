@@ -0,0 +1,65 @@
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "dfa.hpp"
+
+struct SearchMatch {
+    std::uint64_t start;
+    std::uint64_t end;
+};
+
+// Grep-style search for the substrings a DFA accepts. Matches are leftmost-longest, do not
+// overlap and are never empty; unlike DFA::accepts, only single-character symbols can match.
+// Text is fed in chunks of any size and matches are reported as soon as they are settled, with
+// offsets counted from the start of the stream.
+//
+// Candidate start positions come from a prefilter instead of trying every byte: memmem for
+// the literal every match has to start with, or a scan for the bytes that can begin a match
+// (memchr for one, eight bytes at a time for two or three). From a candidate the DFA runs
+// anchored until it dies, remembering the last accepting position.
+class DFASearcher {
+public:
+    // Lookahead kept for a match still in progress at the end of a chunk; a run that needs more
+    // is settled as if the text ended there
+    static constexpr std::size_t MAX_PENDING = 1 << 20;
+
+    explicit DFASearcher(const DFA& dfa);
+
+    // Matches settled by this chunk; the vector is reused by the next call
+    const std::vector<SearchMatch>& feed(std::string_view chunk);
+    // Settles whatever the last chunk left open
+    const std::vector<SearchMatch>& finish();
+
+    // Literal every match starts with; empty when there is none
+    const std::string& prefix() const { return literal_prefix; }
+
+private:
+    static constexpr std::uint32_t DEAD = 0xffffffffu;
+    static constexpr std::size_t MAX_PREFIX = 64;
+
+    std::uint32_t classes;
+    // table[state * classes + byte_class[c]]; DEAD for missing transitions and for states that
+    // can no longer reach an accept state, so a run stops as early as possible
+    std::vector<std::uint32_t> table;
+    std::uint32_t byte_class[256];
+    std::vector<bool> accepting;
+    std::uint32_t start;
+
+    std::string literal_prefix;
+    bool first_byte[256];
+    std::vector<unsigned char> first_bytes;
+
+    std::string pending;
+    std::uint64_t pending_offset;
+    std::vector<SearchMatch> matches;
+
+    std::size_t nextCandidate(const char* data, std::size_t from, std::size_t size) const;
+    void scan(const char* data, std::size_t size, std::uint64_t base, bool final);
+};
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef STATE_SET_HPP
+#define STATE_SET_HPP
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+
+// Fixed-universe bitset over interned state ids. Used for accept states and
+// for the state sets handled by subset construction and NFA simulation.
+class StateSet {
+public:
+    explicit StateSet(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : words(memory) {}
+    StateSet(std::uint32_t universe, std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : words((universe + 63) / 64, 0, memory) {}
+    StateSet(const StateSet& other, std::pmr::memory_resource* memory)
+        : words(other.words, memory) {}
+
+    void resize(std::uint32_t universe) { words.resize((universe + 63) / 64, 0); }
+    std::uint32_t universe() const { return static_cast<std::uint32_t>(words.size() * 64); }
+
+    void insert(std::uint32_t id) { words[id >> 6] |= std::uint64_t(1) << (id & 63); }
+    void erase(std::uint32_t id) { words[id >> 6] &= ~(std::uint64_t(1) << (id & 63)); }
+    bool contains(std::uint32_t id) const {
+        return (id >> 6) < words.size() && (words[id >> 6] >> (id & 63)) & 1;
+    }
+
+    void clear() {
+        for (std::uint64_t& word : words) word = 0;
+    }
+
+    bool empty() const {
+        for (std::uint64_t word : words) {
+            if (word) return false;
+        }
+        return true;
+    }
+
+    std::uint32_t count() const {
+        std::uint32_t total = 0;
+        for (std::uint64_t word : words) total += __builtin_popcountll(word);
+        return total;
+    }
+
+    StateSet& operator|=(const StateSet& other) {
+        for (size_t i = 0; i < words.size() && i < other.words.size(); ++i) words[i] |= other.words[i];
+        return *this;
+    }
+
+    bool intersects(const StateSet& other) const {
+        for (size_t i = 0; i < words.size() && i < other.words.size(); ++i) {
+            if (words[i] & other.words[i]) return true;
+        }
+        return false;
+    }
+
+    bool isSubsetOf(const StateSet& other) const {
+        for (size_t i = 0; i < words.size(); ++i) {
+            std::uint64_t other_word = i < other.words.size() ? other.words[i] : 0;
+            if (words[i] & ~other_word) return false;
+        }
+        return true;
+    }
+
+    bool operator==(const StateSet& other) const { return words == other.words; }
+    bool operator!=(const StateSet& other) const { return words != other.words; }
+
+    // Calls f(id) for every member in increasing id order
+    template <typename Function>
+    void forEach(Function f) const {
+        for (size_t i = 0; i < words.size(); ++i) {
+            std::uint64_t word = words[i];
+            while (word) {
+                f(static_cast<std::uint32_t>(i * 64 + __builtin_ctzll(word)));
+                word &= word - 1;
+            }
+        }
+    }
+
+    std::size_t hash() const {
+        std::size_t seed = words.size();
+        for (std::uint64_t word : words) {
+            seed ^= static_cast<std::size_t>(word * 0x9e3779b97f4a7c15ull) + (seed << 6) + (seed >> 2);
+        }
+        return seed;
+    }
+
+    struct Hash {
+        std::size_t operator()(const StateSet& set) const { return set.hash(); }
+    };
+
+private:
+    std::pmr::vector<std::uint64_t> words;
+};
+
+#endif
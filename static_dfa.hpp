@@ -0,0 +1,264 @@
+#ifndef STATIC_DFA_HPP
+#define STATIC_DFA_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+// Compile-time DFAs for machines that are fixed in the source. The definition uses the same
+// text format as dfaAcceptInput.txt (or the single-line form with literal \n separators that
+// the web client sends) and is parsed entirely by the compiler:
+//
+//     constexpr auto ends_in_one = TOC_STATIC_DFA("q0,q1,\n,0,1,\n,q0,\n,q1,\n"
+//                                                 ",q0,0,q0,\n,q0,1,q1,\n,q1,0,q0,\n,q1,1,q1");
+//     static_assert(ends_in_one.valid(), "bad definition");
+//     static_assert(ends_in_one.accepts("0101"), "");
+//
+// Unlike DFA::accepts, which tokenizes multi-character symbols, matching reads one character per
+// step, so only single-character symbols can match; a missing transition rejects.
+
+enum class StaticDFAError {
+    None,
+    MissingStartState,
+    UnknownStartState,
+    UnknownAcceptState,
+    UnknownTransitionName,
+    MalformedTransition,
+    TooManyStates,
+    TooManySymbols
+};
+
+namespace static_dfa {
+
+constexpr std::uint32_t NO_STATE = 0xffffffffu;
+
+// Splits a definition into words and section breaks. A section ends at a newline or a
+// literal \n token; a blank line ends the definition (dfaAcceptInput.txt puts the input
+// string after one).
+class Tokenizer {
+public:
+    enum Kind { Word, SectionBreak, End };
+
+    constexpr explicit Tokenizer(std::string_view text) : text(text) {}
+
+    constexpr Kind next(std::string_view& word) {
+        while (pos < text.size()) {
+            char c = text[pos];
+            if (c == ' ' || c == '\t' || c == '\r') {
+                ++pos;
+                continue;
+            }
+            if (c == ',') {
+                after_newline = false;
+                ++pos;
+                continue;
+            }
+            if (c == '\n') {
+                ++pos;
+                if (after_newline) {
+                    pos = text.size();
+                    return End;
+                }
+                after_newline = true;
+                return SectionBreak;
+            }
+            after_newline = false;
+            if (c == '\\' && pos + 1 < text.size() && text[pos + 1] == 'n') {
+                pos += 2;
+                return SectionBreak;
+            }
+
+            std::size_t start = pos;
+            while (pos < text.size() && text[pos] != ',' && text[pos] != '\n' && text[pos] != '\r' &&
+                !(text[pos] == '\\' && pos + 1 < text.size() && text[pos + 1] == 'n')) {
+                ++pos;
+            }
+            word = text.substr(start, pos - start);
+            return Word;
+        }
+        return End;
+    }
+
+private:
+    std::string_view text;
+    std::size_t pos = 0;
+    bool after_newline = false;
+};
+
+// Number of words in the given section, used to size the tables
+constexpr std::size_t countWords(std::string_view text, std::size_t section) {
+    Tokenizer tokens(text);
+    std::string_view word;
+    std::size_t current = 0, count = 0;
+    for (auto kind = tokens.next(word); kind != Tokenizer::End && current <= section; kind = tokens.next(word)) {
+        if (kind == Tokenizer::SectionBreak) {
+            ++current;
+        }
+        else if (current == section) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+constexpr std::size_t countStates(std::string_view text) { return countWords(text, 0); }
+constexpr std::size_t countSymbols(std::string_view text) { return countWords(text, 1); }
+
+}
+
+template <std::size_t MaxStates, std::size_t MaxSymbols>
+class StaticDFA {
+public:
+    constexpr explicit StaticDFA(std::string_view text) {
+        for (std::uint32_t& entry : transitions) entry = static_dfa::NO_STATE;
+        for (std::uint32_t& entry : char_symbols) entry = static_dfa::NO_STATE;
+
+        static_dfa::Tokenizer tokens(text);
+        std::string_view word;
+        std::string_view triple[3];
+        std::size_t section = 0, triple_size = 0;
+        bool seen_start = false;
+
+        for (auto kind = tokens.next(word); ; kind = tokens.next(word)) {
+            if (kind != static_dfa::Tokenizer::Word) {
+                // Every section from the fifth on holds one transition
+                if (section >= 4 && triple_size != 0) {
+                    addTransition(triple, triple_size);
+                }
+                triple_size = 0;
+                if (kind == static_dfa::Tokenizer::End) break;
+                ++section;
+                continue;
+            }
+
+            if (section == 0) {
+                if (findState(word) == static_dfa::NO_STATE) addState(word);
+            }
+            else if (section == 1) {
+                if (findSymbol(word) == static_dfa::NO_STATE) addSymbol(word);
+            }
+            else if (section == 2) {
+                seen_start = true;
+                start = findState(word);
+                if (start == static_dfa::NO_STATE) fail(StaticDFAError::UnknownStartState);
+            }
+            else if (section == 3) {
+                std::uint32_t state = findState(word);
+                if (state == static_dfa::NO_STATE) fail(StaticDFAError::UnknownAcceptState);
+                else accepting[state] = true;
+            }
+            else if (triple_size < 3) {
+                triple[triple_size++] = word;
+            }
+            else {
+                fail(StaticDFAError::MalformedTransition);
+            }
+        }
+
+        if (!seen_start) fail(StaticDFAError::MissingStartState);
+    }
+
+    // Same conditions as DFA::validate: a declared start state and no undeclared names
+    constexpr bool valid() const { return error == StaticDFAError::None; }
+    constexpr StaticDFAError status() const { return error; }
+
+    constexpr bool accepts(std::string_view input) const {
+        std::uint32_t state = start;
+        if (!valid() || state == static_dfa::NO_STATE) {
+            return false;
+        }
+        for (char c : input) {
+            std::uint32_t symbol = char_symbols[static_cast<unsigned char>(c)];
+            if (symbol == static_dfa::NO_STATE) {
+                return false;
+            }
+            state = transitions[state * MaxSymbols + symbol];
+            if (state == static_dfa::NO_STATE) {
+                return false;
+            }
+        }
+        return accepting[state];
+    }
+
+    constexpr std::size_t stateCount() const { return state_count; }
+    constexpr std::size_t symbolCount() const { return symbol_count; }
+    constexpr std::uint32_t startState() const { return start; }
+    constexpr std::uint32_t next(std::uint32_t state, std::uint32_t symbol) const {
+        return transitions[state * MaxSymbols + symbol];
+    }
+    constexpr bool isAccepting(std::uint32_t state) const { return accepting[state]; }
+    constexpr std::string_view stateName(std::uint32_t state) const { return state_names[state]; }
+    constexpr std::string_view symbolName(std::uint32_t symbol) const { return symbol_names[symbol]; }
+
+private:
+    std::array<std::string_view, MaxStates> state_names{};
+    std::array<std::string_view, MaxSymbols> symbol_names{};
+    std::array<bool, MaxStates> accepting{};
+    // Row-major |Q| x |Σ| table, NO_STATE where no transition is defined
+    std::array<std::uint32_t, MaxStates * MaxSymbols> transitions{};
+    // Symbol id for each single-character symbol, by character
+    std::array<std::uint32_t, 256> char_symbols{};
+    std::size_t state_count = 0;
+    std::size_t symbol_count = 0;
+    std::uint32_t start = static_dfa::NO_STATE;
+    StaticDFAError error = StaticDFAError::None;
+
+    constexpr void fail(StaticDFAError reason) {
+        if (error == StaticDFAError::None) error = reason;
+    }
+
+    constexpr std::uint32_t findState(std::string_view name) const {
+        for (std::size_t i = 0; i < state_count; ++i) {
+            if (state_names[i] == name) return static_cast<std::uint32_t>(i);
+        }
+        return static_dfa::NO_STATE;
+    }
+
+    constexpr std::uint32_t findSymbol(std::string_view name) const {
+        for (std::size_t i = 0; i < symbol_count; ++i) {
+            if (symbol_names[i] == name) return static_cast<std::uint32_t>(i);
+        }
+        return static_dfa::NO_STATE;
+    }
+
+    constexpr void addState(std::string_view name) {
+        if (state_count == MaxStates) {
+            fail(StaticDFAError::TooManyStates);
+            return;
+        }
+        state_names[state_count++] = name;
+    }
+
+    constexpr void addSymbol(std::string_view name) {
+        if (symbol_count == MaxSymbols) {
+            fail(StaticDFAError::TooManySymbols);
+            return;
+        }
+        if (name.size() == 1) {
+            char_symbols[static_cast<unsigned char>(name[0])] = static_cast<std::uint32_t>(symbol_count);
+        }
+        symbol_names[symbol_count++] = name;
+    }
+
+    constexpr void addTransition(const std::string_view* triple, std::size_t size) {
+        if (size != 3) {
+            fail(StaticDFAError::MalformedTransition);
+            return;
+        }
+        std::uint32_t from = findState(triple[0]);
+        std::uint32_t symbol = findSymbol(triple[1]);
+        std::uint32_t to = findState(triple[2]);
+        if (from == static_dfa::NO_STATE || symbol == static_dfa::NO_STATE || to == static_dfa::NO_STATE) {
+            fail(StaticDFAError::UnknownTransitionName);
+            return;
+        }
+        transitions[from * MaxSymbols + symbol] = to;
+    }
+};
+
+// Sizes the tables from the definition itself, so built-in machines need no manual counts
+#define TOC_STATIC_DFA(text) \
+    StaticDFA<static_dfa::countStates(text), static_dfa::countSymbols(text)>(text)
+
+#endif
@@ -0,0 +1,41 @@
+#include "symbol_table.hpp"
+
+SymbolTable::SymbolTable(std::pmr::memory_resource* memory) : names(memory), ids(memory) {}
+
+// Copies use the default resource, like any other pmr container copy
+SymbolTable::SymbolTable(const SymbolTable& other) : SymbolTable() {
+    *this = other;
+}
+
+SymbolTable& SymbolTable::operator=(const SymbolTable& other) {
+    if (this != &other) {
+        // Rebuild the index so its views point into our own copies of the names
+        names.clear();
+        ids.clear();
+        max_name_length = 0;
+        for (const std::pmr::string& symbol : other.names) {
+            intern(symbol);
+        }
+    }
+    return *this;
+}
+
+std::uint32_t SymbolTable::intern(std::string_view name) {
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        return it->second;
+    }
+
+    std::uint32_t id = static_cast<std::uint32_t>(names.size());
+    names.emplace_back(name.begin(), name.end());
+    ids.emplace(std::string_view(names.back()), id);
+    if (name.size() > max_name_length) {
+        max_name_length = name.size();
+    }
+    return id;
+}
+
+std::uint32_t SymbolTable::find(std::string_view name) const {
+    auto it = ids.find(name);
+    return it != ids.end() ? it->second : NO_SYMBOL;
+}
@@ -0,0 +1,37 @@
+#ifndef SYMBOL_TABLE_HPP
+#define SYMBOL_TABLE_HPP
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+#include <memory_resource>
+
+// Interns names (states, alphabet symbols, grammar variables and terminals)
+// to dense integer ids in order of first appearance. Ids index directly into
+// the flat tables the automaton and grammar engines are built on.
+class SymbolTable {
+public:
+    static constexpr std::uint32_t NO_SYMBOL = 0xffffffffu;
+
+    explicit SymbolTable(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    SymbolTable(const SymbolTable& other);
+    SymbolTable& operator=(const SymbolTable& other);
+
+    // Returns the id of name, adding it if it has not been seen before
+    std::uint32_t intern(std::string_view name);
+    // Returns the id of name, or NO_SYMBOL if it was never interned
+    std::uint32_t find(std::string_view name) const;
+    const std::pmr::string& name(std::uint32_t id) const { return names[id]; }
+    std::uint32_t size() const { return static_cast<std::uint32_t>(names.size()); }
+    std::size_t maxNameLength() const { return max_name_length; }
+
+private:
+    // A deque never relocates its elements, so the views used as keys stay valid
+    std::pmr::deque<std::pmr::string> names;
+    std::pmr::unordered_map<std::string_view, std::uint32_t> ids;
+    std::size_t max_name_length = 0;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "symbol_tokenizer.hpp"
+#include <algorithm>
+#include <map>
+
+SymbolTokenizer::SymbolTokenizer(std::pmr::memory_resource* memory)
+    : single_characters(true), nodes(memory), edges(memory) {
+    std::fill(std::begin(root_symbol), std::end(root_symbol), SymbolTable::NO_SYMBOL);
+    std::fill(std::begin(root_child), std::end(root_child), NO_NODE);
+}
+
+void SymbolTokenizer::build(const SymbolTable& symbols) {
+    std::fill(std::begin(root_symbol), std::end(root_symbol), SymbolTable::NO_SYMBOL);
+    std::fill(std::begin(root_child), std::end(root_child), NO_NODE);
+    nodes.clear();
+    edges.clear();
+    single_characters = symbols.maxNameLength() <= 1;
+
+    // Build with ordered child maps, then flatten them into sorted edge runs
+    std::vector<std::map<unsigned char, std::uint32_t>> children;
+    std::vector<std::uint32_t> node_symbol;
+    for (std::uint32_t id = 0; id < symbols.size(); ++id) {
+        const std::pmr::string& name = symbols.name(id);
+        unsigned char first = static_cast<unsigned char>(name[0]);
+        if (name.size() == 1) {
+            root_symbol[first] = id;
+            continue;
+        }
+
+        if (root_child[first] == NO_NODE) {
+            root_child[first] = static_cast<std::uint32_t>(children.size());
+            children.emplace_back();
+            node_symbol.push_back(SymbolTable::NO_SYMBOL);
+        }
+        std::uint32_t node = root_child[first];
+        for (std::size_t i = 1; i < name.size(); ++i) {
+            unsigned char byte = static_cast<unsigned char>(name[i]);
+            auto it = children[node].find(byte);
+            if (it == children[node].end()) {
+                std::uint32_t child = static_cast<std::uint32_t>(children.size());
+                children[node].emplace(byte, child);
+                children.emplace_back();
+                node_symbol.push_back(SymbolTable::NO_SYMBOL);
+                node = child;
+            }
+            else {
+                node = it->second;
+            }
+        }
+        node_symbol[node] = id;
+    }
+
+    nodes.reserve(children.size());
+    for (std::uint32_t node = 0; node < children.size(); ++node) {
+        nodes.push_back(Node{ node_symbol[node], static_cast<std::uint32_t>(edges.size()),
+            static_cast<std::uint32_t>(children[node].size()) });
+        for (const auto& [byte, child] : children[node]) {
+            edges.push_back(Edge{ byte, child });
+        }
+    }
+}
+
+std::uint32_t SymbolTokenizer::longestMatch(std::string_view input, std::size_t pos, std::uint32_t symbol,
+    std::size_t& length) const {
+    std::uint32_t node = root_child[static_cast<unsigned char>(input[pos])];
+    for (std::size_t i = pos + 1; node != NO_NODE && i < input.size(); ++i) {
+        const Node& current = nodes[node];
+        const Edge* first = edges.data() + current.first_edge;
+        const Edge* last = first + current.edge_count;
+        unsigned char byte = static_cast<unsigned char>(input[i]);
+
+        // Runs are short, so a linear scan over the sorted bytes beats a binary search
+        const Edge* edge = first;
+        while (edge != last && edge->byte < byte) {
+            ++edge;
+        }
+        if (edge == last || edge->byte != byte) {
+            break;
+        }
+
+        node = edge->child;
+        if (nodes[node].symbol != SymbolTable::NO_SYMBOL) {
+            symbol = nodes[node].symbol;
+            length = i + 1 - pos;
+        }
+    }
+    return symbol;
+}
+
+bool SymbolTokenizer::splitsUniquely(const SymbolTable& symbols) {
+    if (symbols.maxNameLength() <= 1) {
+        return true;
+    }
+
+    // Whether rest is a prefix of some concatenation of symbols; completes[i] caches the
+    // answer for rest.substr(i), -1 while unknown
+    auto continues = [&symbols](std::string_view rest) {
+        std::vector<signed char> completes(rest.size() + 1, -1);
+        completes[rest.size()] = 1;
+        for (std::size_t i = rest.size(); i-- > 0;) {
+            std::string_view tail = rest.substr(i);
+            completes[i] = 0;
+            for (std::uint32_t id = 0; id < symbols.size() && completes[i] == 0; ++id) {
+                std::string_view name = symbols.name(id);
+                if (name.size() >= tail.size() ? name.compare(0, tail.size(), tail) == 0
+                    : tail.compare(0, name.size(), name) == 0 && completes[i + name.size()] == 1) {
+                    completes[i] = 1;
+                }
+            }
+        }
+        return completes[0] == 1;
+    };
+
+    for (std::uint32_t shorter = 0; shorter < symbols.size(); ++shorter) {
+        std::string_view prefix = symbols.name(shorter);
+        for (std::uint32_t longer = 0; longer < symbols.size(); ++longer) {
+            std::string_view name = symbols.name(longer);
+            if (name.size() > prefix.size() && name.compare(0, prefix.size(), prefix) == 0 &&
+                continues(name.substr(prefix.size()))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+#ifndef SYMBOL_TOKENIZER_HPP
+#define SYMBOL_TOKENIZER_HPP
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+#include "symbol_table.hpp"
+
+// Splits input text into the ids of an alphabet whose symbols may be longer than one
+// character. The names are compiled into a trie: the first byte indexes a flat table, deeper
+// bytes follow short sorted edge runs, and every step remembers the longest symbol seen so far.
+// Matching is greedy longest match without backtracking, the same rule grammar productions are
+// split by. When every symbol is a single character the trie is never touched and each byte is
+// one table lookup.
+class SymbolTokenizer {
+public:
+    explicit SymbolTokenizer(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+    // Recompiles from the current contents of symbols; call again after interning more names
+    void build(const SymbolTable& symbols);
+
+    // True when longest match splits every concatenation of symbols back into the same
+    // symbols, so symbol sequences and the strings they spell correspond one to one. It fails
+    // exactly when some symbol x is a proper prefix of a symbol y whose remainder can be
+    // continued by symbols, as with a, b and ab.
+    static bool splitsUniquely(const SymbolTable& symbols);
+
+    // Id of the longest symbol starting at input[pos], with its length; NO_SYMBOL if none does
+    std::uint32_t next(std::string_view input, std::size_t pos, std::size_t& length) const {
+        std::uint32_t symbol = root_symbol[static_cast<unsigned char>(input[pos])];
+        length = 1;
+        if (single_characters) {
+            return symbol;
+        }
+        return longestMatch(input, pos, symbol, length);
+    }
+
+    // Hands each symbol id of input to visit in order, without allocating. visit returns false
+    // to stop early; the result is true only when all of input was consumed.
+    template <typename Visit>
+    bool forEach(std::string_view input, Visit&& visit) const {
+        std::size_t pos = 0;
+        while (pos < input.size()) {
+            std::size_t length;
+            std::uint32_t symbol = next(input, pos, length);
+            if (symbol == SymbolTable::NO_SYMBOL || !visit(symbol)) {
+                return false;
+            }
+            pos += length;
+        }
+        return true;
+    }
+
+private:
+    static constexpr std::uint32_t NO_NODE = 0xffffffffu;
+
+    struct Node {
+        std::uint32_t symbol;
+        std::uint32_t first_edge;
+        std::uint32_t edge_count;
+    };
+    struct Edge {
+        unsigned char byte;
+        std::uint32_t child;
+    };
+
+    bool single_characters;
+    // Symbol spelled by exactly one byte, and the trie node for longer names starting with it
+    std::uint32_t root_symbol[256];
+    std::uint32_t root_child[256];
+    std::pmr::vector<Node> nodes;
+    // Each node's edges are contiguous and sorted by byte
+    std::pmr::vector<Edge> edges;
+
+    std::uint32_t longestMatch(std::string_view input, std::size_t pos, std::uint32_t symbol, std::size_t& length) const;
+};
+
+#endif
@@ -0,0 +1,449 @@
+// Offline batch runner over the same engines as the HTTP server, for bulk grading without
+// an HTTP round-trip per string. Definitions use the file formats of dfaAcceptInput.txt,
+// nfaInput.txt, pdaInput.txt and cfgInput.txt; corpora hold one input string per line.
+// Inputs are memory-mapped, work is spread over all cores, and results are written as
+// newline-delimited JSON in input order.
+//
+//     toc_batch accept <dfa|nfa|pda|cfg> <definition> [corpus] [-j threads] [-o output]
+//     toc_batch convert nfa <definition>... [-j threads] [-o output]
+//     toc_batch generate <dfa|nfa> <definition> [-n count] [-o output]
+//     toc_batch search <dfa|nfa> <definition> <text> [-o output]
+//
+// accept without a corpus checks the input string after the blank line of the definition
+// file, as dfaAcceptInput.txt has it. convert turns NFAs into DFAs; PDA to CFG conversion is
+// not implemented yet (PDA::toCFG returns an empty grammar), so convert pda is refused.
+// Build from the repository root with every source file except main.cpp:
+//
+//     g++ -std=c++17 -O2 -I. tools/batch.cpp $(ls *.cpp | grep -v main.cpp) -lpthread -lz -o toc_batch
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "dfa.hpp"
+#include "dfa_language.hpp"
+#include "nfa.hpp"
+#include "pda.hpp"
+#include "cfg.hpp"
+#include "search.hpp"
+#include "json.hpp"
+
+namespace {
+
+// Read-only mapping of a whole file; empty files map to an empty view
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot stat " + path);
+        }
+        size = static_cast<std::size_t>(info.st_size);
+        if (size > 0) {
+            void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("cannot map " + path);
+            }
+            ::madvise(mapping, size, MADV_SEQUENTIAL);
+            data = static_cast<const char*>(mapping);
+        }
+        ::close(fd);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+        if (data) ::munmap(const_cast<char*>(data), size);
+    }
+
+    std::string_view view() const { return std::string_view(data, size); }
+
+private:
+    const char* data = nullptr;
+    std::size_t size = 0;
+};
+
+enum class Kind { DFA, NFA, PDA, CFG };
+
+bool parseKind(const std::string& name, Kind& kind) {
+    if (name == "dfa") kind = Kind::DFA;
+    else if (name == "nfa") kind = Kind::NFA;
+    else if (name == "pda") kind = Kind::PDA;
+    else if (name == "cfg") kind = Kind::CFG;
+    else return false;
+    return true;
+}
+
+std::string_view chomp(std::string_view line) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return line;
+}
+
+// A definition file split at its first blank line into the machine and the trailing input
+struct Definition {
+    std::string text;
+    std::string input;
+};
+
+// DFA and NFA files put one section per line; the parsers want the single-line form with
+// literal \n separators the web client sends, and the NFA parser a '-' after the last transition
+Definition readDefinition(Kind kind, const std::string& path) {
+    MappedFile file(path);
+    std::string_view rest = file.view();
+    Definition definition;
+    bool in_input = false;
+
+    while (!rest.empty()) {
+        std::size_t end = rest.find('\n');
+        std::string_view line = chomp(rest.substr(0, end));
+        rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+
+        if (in_input) {
+            definition.input.append(line.data(), line.size());
+            continue;
+        }
+        if (line.empty()) {
+            in_input = true;
+            continue;
+        }
+        if (kind == Kind::DFA || kind == Kind::NFA) {
+            if (!definition.text.empty()) definition.text += "\\n";
+            definition.text.append(line.data(), line.size());
+        }
+        else {
+            definition.text.append(line.data(), line.size());
+            definition.text += '\n';
+        }
+    }
+
+    if (kind == Kind::NFA) {
+        definition.text += "-";
+    }
+    return definition;
+}
+
+// One of the four engines behind a single accepts call; everything lazy is built up front, so
+// the worker threads only ever read it
+class Machine {
+public:
+    Machine(Kind kind, const std::string& text) {
+        switch (kind) {
+        case Kind::DFA: automaton.reset(new DFA(text)); break;
+        case Kind::NFA: automaton.reset(new NFA(text)); break;
+        case Kind::PDA: automaton.reset(new PDA(text)); break;
+        case Kind::CFG:
+            grammar.reset(new CFG(text));
+            if (grammar->validate()) grammar->parserKind();
+            break;
+        }
+    }
+
+    bool validate() const { return grammar ? grammar->validate() : automaton->validate(); }
+    bool accepts(const std::string& input) const {
+        return grammar ? grammar->generates(input) : automaton->accepts(input);
+    }
+
+private:
+    std::unique_ptr<Automaton> automaton;
+    std::unique_ptr<CFG> grammar;
+};
+
+// Results are written in block order as blocks finish, so output memory stays bounded by
+// how far the fastest worker runs ahead of the slowest
+class OrderedWriter {
+public:
+    OrderedWriter(std::ostream& out, std::size_t blocks) : out(out), results(blocks), done(blocks, false) {}
+
+    void finish(std::size_t block, std::string result) {
+        std::lock_guard<std::mutex> guard(lock);
+        results[block] = std::move(result);
+        done[block] = true;
+        while (next < done.size() && done[next]) {
+            out.write(results[next].data(), results[next].size());
+            std::string().swap(results[next]);
+            ++next;
+        }
+    }
+
+private:
+    std::ostream& out;
+    std::mutex lock;
+    std::vector<std::string> results;
+    std::vector<bool> done;
+    std::size_t next = 0;
+};
+
+struct Block {
+    std::string_view lines;
+    std::uint64_t first_line;
+};
+
+constexpr std::size_t BLOCK_SIZE = 1 << 20;
+
+// Cuts the corpus at line ends into blocks of about BLOCK_SIZE bytes, numbering lines from 1
+std::vector<Block> splitBlocks(std::string_view corpus) {
+    std::vector<Block> blocks;
+    std::uint64_t line = 1;
+    while (!corpus.empty()) {
+        std::size_t end = std::min(corpus.size(), BLOCK_SIZE);
+        if (end < corpus.size()) {
+            const void* newline = std::memchr(corpus.data() + end, '\n', corpus.size() - end);
+            end = newline ? static_cast<const char*>(newline) - corpus.data() + 1 : corpus.size();
+        }
+        blocks.push_back(Block{ corpus.substr(0, end), line });
+        line += std::count(corpus.data(), corpus.data() + end, '\n');
+        corpus.remove_prefix(end);
+    }
+    return blocks;
+}
+
+template <typename Work>
+void runParallel(std::size_t jobs, unsigned threads, Work work) {
+    std::atomic<std::size_t> next_job{ 0 };
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < std::max(1u, std::min<unsigned>(threads, jobs)); ++i) {
+        workers.emplace_back([&]() {
+            for (std::size_t job = next_job++; job < jobs; job = next_job++) {
+                work(job);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+int runAccept(Kind kind, const std::vector<std::string>& files, unsigned threads, std::ostream& out) {
+    if (files.empty() || files.size() > 2) {
+        std::cerr << "accept takes one definition and an optional corpus\n";
+        return 2;
+    }
+
+    Definition definition = readDefinition(kind, files[0]);
+    Machine machine(kind, definition.text);
+    if (!machine.validate()) {
+        std::cerr << files[0] << ": invalid definition\n";
+        return 1;
+    }
+
+    if (files.size() == 1) {
+        out << "{\"line\": 1, \"accepted\": " << (machine.accepts(definition.input) ? "true" : "false") << "}\n";
+        return 0;
+    }
+
+    MappedFile corpus(files[1]);
+    std::vector<Block> blocks = splitBlocks(corpus.view());
+    OrderedWriter writer(out, blocks.size());
+
+    runParallel(blocks.size(), threads, [&](std::size_t index) {
+        std::string result;
+        std::string input;
+        std::string_view rest = blocks[index].lines;
+        for (std::uint64_t line = blocks[index].first_line; !rest.empty(); ++line) {
+            std::size_t end = rest.find('\n');
+            std::string_view text = chomp(rest.substr(0, end));
+            rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+
+            input.assign(text.data(), text.size());
+            result += "{\"line\": ";
+            result += std::to_string(line);
+            result += machine.accepts(input) ? ", \"accepted\": true}\n" : ", \"accepted\": false}\n";
+        }
+        writer.finish(index, std::move(result));
+    });
+    return 0;
+}
+
+int runConvert(Kind kind, const std::vector<std::string>& files, unsigned threads, std::ostream& out) {
+    if (kind == Kind::PDA) {
+        std::cerr << "convert pda: PDA to CFG conversion is not implemented\n";
+        return 2;
+    }
+    if (kind != Kind::NFA) {
+        std::cerr << "convert takes nfa definitions\n";
+        return 2;
+    }
+
+    OrderedWriter writer(out, files.size());
+    std::atomic<bool> failed{ false };
+
+    runParallel(files.size(), threads, [&](std::size_t index) {
+        std::string result = "{";
+        appendJsonField(result, "file", files[index]);
+        try {
+            Definition definition = readDefinition(kind, files[index]);
+            NFA nfa(definition.text);
+            bool valid = nfa.validate();
+            result += std::string(", \"valid\": ") + (valid ? "true" : "false");
+            if (valid) {
+                result += ", ";
+                appendJsonField(result, "dfa", nfa.reduced().toDFA().toString());
+            }
+        }
+        catch (const std::exception& e) {
+            failed = true;
+            result += ", ";
+            appendJsonField(result, "error", e.what());
+        }
+        writer.finish(index, result + "}\n");
+    });
+    return failed ? 1 : 0;
+}
+
+int runGenerate(Kind kind, const std::vector<std::string>& files, std::uint64_t count, std::ostream& out) {
+    if ((kind != Kind::DFA && kind != Kind::NFA) || files.size() != 1) {
+        std::cerr << "generate takes one dfa or nfa definition\n";
+        return 2;
+    }
+
+    Definition definition = readDefinition(kind, files[0]);
+    std::unique_ptr<DFA> dfa;
+    if (kind == Kind::DFA) {
+        dfa.reset(new DFA(definition.text));
+        if (!dfa->validate()) dfa.reset();
+    }
+    else {
+        NFA nfa(definition.text);
+        if (nfa.validate()) dfa.reset(new DFA(nfa.reduced().toDFA()));
+    }
+    if (!dfa) {
+        std::cerr << files[0] << ": invalid definition\n";
+        return 1;
+    }
+
+    // Enumeration is inherently sequential, so this one stays on a single thread
+    ShortlexEnumerator enumerator(*dfa);
+    std::string word, line;
+    for (std::uint64_t i = 0; i < count && enumerator.next(word); ++i) {
+        line = "{";
+        appendJsonField(line, "word", word);
+        line += "}\n";
+        out.write(line.data(), line.size());
+    }
+    return 0;
+}
+
+int runSearch(Kind kind, const std::vector<std::string>& files, std::ostream& out) {
+    if ((kind != Kind::DFA && kind != Kind::NFA) || files.size() != 2) {
+        std::cerr << "search takes one dfa or nfa definition and a text file\n";
+        return 2;
+    }
+
+    Definition definition = readDefinition(kind, files[0]);
+    std::unique_ptr<DFA> dfa;
+    if (kind == Kind::DFA) {
+        dfa.reset(new DFA(definition.text));
+        if (!dfa->validate()) dfa.reset();
+    }
+    else {
+        NFA nfa(definition.text);
+        if (nfa.validate()) dfa.reset(new DFA(nfa.reduced().toDFA()));
+    }
+    if (!dfa) {
+        std::cerr << files[0] << ": invalid definition\n";
+        return 1;
+    }
+
+    // The mapping is fed in slices so matches stream out while the rest is still being paged in
+    constexpr std::size_t SLICE_SIZE = std::size_t(16) << 20;
+    MappedFile text(files[1]);
+    std::string_view rest = text.view();
+    DFASearcher searcher(*dfa);
+    std::string lines;
+    auto write = [&](const std::vector<SearchMatch>& matches) {
+        lines.clear();
+        for (const SearchMatch& match : matches) {
+            lines += "{\"start\": " + std::to_string(match.start) + ", \"end\": " + std::to_string(match.end) + "}\n";
+        }
+        out.write(lines.data(), lines.size());
+    };
+    while (!rest.empty()) {
+        std::size_t size = std::min(rest.size(), SLICE_SIZE);
+        write(searcher.feed(rest.substr(0, size)));
+        rest.remove_prefix(size);
+    }
+    write(searcher.finish());
+    return 0;
+}
+
+void usage() {
+    std::cerr << "usage: toc_batch accept <dfa|nfa|pda|cfg> <definition> [corpus] [-j threads] [-o output]\n"
+        << "       toc_batch convert nfa <definition>... [-j threads] [-o output]\n"
+        << "       toc_batch generate <dfa|nfa> <definition> [-n count] [-o output]\n"
+        << "       toc_batch search <dfa|nfa> <definition> <text> [-o output]\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        usage();
+        return 2;
+    }
+
+    std::string job = argv[1];
+    Kind kind;
+    if (!parseKind(argv[2], kind)) {
+        usage();
+        return 2;
+    }
+
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::uint64_t count = 100;
+    std::string output_path;
+    std::vector<std::string> files;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-j" || arg == "-n" || arg == "-o") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (arg == "-j") threads = std::max(1, std::atoi(value.c_str()));
+            else if (arg == "-n") count = std::strtoull(value.c_str(), nullptr, 10);
+            else output_path = value;
+        }
+        else {
+            files.push_back(arg);
+        }
+    }
+
+    std::ofstream output_file;
+    if (!output_path.empty()) {
+        output_file.open(output_path, std::ios::binary);
+        if (!output_file) {
+            std::cerr << "cannot write " << output_path << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = output_path.empty() ? std::cout : output_file;
+    std::ios::sync_with_stdio(false);
+
+    try {
+        if (job == "accept") return runAccept(kind, files, threads, out);
+        if (job == "convert") return runConvert(kind, files, threads, out);
+        if (job == "generate") return runGenerate(kind, files, count, out);
+        if (job == "search") return runSearch(kind, files, out);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    usage();
+    return 2;
+}
@@ -0,0 +1,172 @@
+// Differential check of DFA::toCpp against DFA::accepts. Builds random DFAs (single- and
+// multi-character alphabets, missing transitions, names with backslashes, no start state),
+// writes their generated matchers and a driver into one source file, compiles it with
+// -Wall -Wextra -Werror, and compares the compiled matchers' answers on random inputs with
+// accepts(). Exits nonzero on a compile failure or any disagreement.
+//
+//     toc_codegen_check [-n machines] [-i inputs] [-s seed] [--cxx compiler] [--dir work_dir]
+//
+// The generated source and driver binary go to work_dir (a fresh directory under /tmp by
+// default) and are left there for inspection. Build from the repository root with every
+// source file except main.cpp:
+//
+//     g++ -std=c++17 -O2 -I. tools/codegen_check.cpp $(ls *.cpp | grep -v main.cpp) -lpthread -lz -o toc_codegen_check
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <cstdlib>
+#include <cstdint>
+#include <unistd.h>
+#include "dfa.hpp"
+
+namespace {
+
+// Symbol names share prefixes so longest match has something to decide
+const char* const SYMBOL_POOL[] = { "a", "b", "c", "0", "1", "\\", "ab", "abc", "ba", "cc", "a\\" };
+// Input characters include some no alphabet declares
+const char INPUT_CHARACTERS[] = "abc01\\xz";
+
+std::unique_ptr<DFA> randomDFA(std::mt19937& random) {
+    SymbolTable alphabet;
+    bool multi_character = random() % 2 == 0;
+    std::size_t pool_size = multi_character ? std::size(SYMBOL_POOL) : 6;
+    for (std::uint32_t count = 1 + random() % 4; count > 0; --count) {
+        alphabet.intern(SYMBOL_POOL[random() % pool_size]);
+    }
+
+    auto dfa = std::make_unique<DFA>(alphabet);
+    std::uint32_t state_count = 1 + random() % 6;
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        std::string name = state == 1 ? "q\\1" : "q" + std::to_string(state);
+        dfa->addState(name, random() % 3 == 0);
+    }
+    dfa->setStartState(random() % 16 == 0 ? DFA::NO_STATE : random() % state_count);
+    for (std::uint32_t state = 0; state < state_count; ++state) {
+        for (std::uint32_t symbol = 0; symbol < alphabet.size(); ++symbol) {
+            dfa->setTransition(state, symbol, random() % 6 == 0 ? DFA::NO_STATE : random() % state_count);
+        }
+    }
+    return dfa;
+}
+
+// Mostly whole symbol names, with the odd stray character, so runs get past the first step
+std::string randomInput(const DFA& dfa, std::mt19937& random) {
+    std::string input;
+    for (std::uint32_t length = random() % 8; length > 0; --length) {
+        if (random() % 8 == 0) {
+            input += INPUT_CHARACTERS[random() % (sizeof(INPUT_CHARACTERS) - 1)];
+        }
+        else {
+            input += dfa.symbolName(random() % dfa.symbolCount());
+        }
+    }
+    return input;
+}
+
+void usage() {
+    std::cerr << "usage: toc_codegen_check [-n machines] [-i inputs] [-s seed] [--cxx compiler] [--dir work_dir]\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::size_t machine_count = 200;
+    std::size_t inputs_per_machine = 200;
+    unsigned seed = 1;
+    std::string compiler = "c++";
+    std::string dir;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 < argc && (arg == "-n" || arg == "-i" || arg == "-s" || arg == "--cxx" || arg == "--dir")) {
+            std::string value = argv[++i];
+            if (arg == "-n") machine_count = std::strtoull(value.c_str(), nullptr, 10);
+            else if (arg == "-i") inputs_per_machine = std::strtoull(value.c_str(), nullptr, 10);
+            else if (arg == "-s") seed = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+            else if (arg == "--cxx") compiler = value;
+            else dir = value;
+        }
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (dir.empty()) {
+        char work_dir[] = "/tmp/toc_codegen_XXXXXX";
+        if (::mkdtemp(work_dir) == nullptr) {
+            std::cerr << "cannot create a work directory\n";
+            return 1;
+        }
+        dir = work_dir;
+    }
+
+    std::mt19937 random(seed);
+    std::vector<std::unique_ptr<DFA>> machines;
+    std::ostringstream source;
+    for (std::size_t i = 0; i < machine_count; ++i) {
+        machines.push_back(randomDFA(random));
+        source << machines.back()->toCpp("m" + std::to_string(i)) << "\n";
+    }
+
+    // The driver answers one "machine<TAB>input" line with one 0 or 1 line
+    source << "#include <iostream>\n#include <string>\n\n";
+    source << "static bool (*const machines[])(std::string_view) = {";
+    for (std::size_t i = 0; i < machine_count; ++i) {
+        source << (i > 0 ? ", m" : " m") << i;
+    }
+    source << " };\n\n";
+    source << "int main() {\n"
+        << "    std::string line;\n"
+        << "    while (std::getline(std::cin, line)) {\n"
+        << "        std::size_t tab = line.find('\\t');\n"
+        << "        std::cout << machines[std::stoul(line.substr(0, tab))](std::string_view(line).substr(tab + 1)) << '\\n';\n"
+        << "    }\n"
+        << "}\n";
+    std::ofstream(dir + "/matchers.cpp") << source.str();
+
+    std::string command = compiler + " -std=c++17 -O1 -Wall -Wextra -Werror -o " + dir + "/matchers " + dir + "/matchers.cpp";
+    if (std::system(command.c_str()) != 0) {
+        std::cerr << "generated code does not compile: " << command << "\n";
+        return 1;
+    }
+
+    std::vector<std::pair<std::size_t, std::string>> cases;
+    {
+        std::ofstream inputs(dir + "/inputs.txt", std::ios::binary);
+        for (std::size_t i = 0; i < machine_count; ++i) {
+            for (std::size_t j = 0; j < inputs_per_machine; ++j) {
+                cases.emplace_back(i, randomInput(*machines[i], random));
+                inputs << i << '\t' << cases.back().second << '\n';
+            }
+        }
+    }
+    command = dir + "/matchers < " + dir + "/inputs.txt > " + dir + "/results.txt";
+    if (std::system(command.c_str()) != 0) {
+        std::cerr << "generated matchers failed to run\n";
+        return 1;
+    }
+
+    std::ifstream results(dir + "/results.txt");
+    std::size_t mismatches = 0;
+    std::string line;
+    for (const auto& [machine, input] : cases) {
+        if (!std::getline(results, line)) {
+            std::cerr << "generated matchers stopped early\n";
+            return 1;
+        }
+        bool expected = machines[machine]->accepts(input);
+        if ((line == "1") != expected) {
+            if (++mismatches <= 10) {
+                std::cerr << "m" << machine << "(\"" << input << "\"): generated " << line << ", accepts " << expected << "\n";
+            }
+        }
+    }
+
+    std::cout << machine_count << " machines, " << cases.size() << " inputs, " << mismatches << " mismatches ("
+        << dir << ")\n";
+    return mismatches == 0 ? 0 : 1;
+}
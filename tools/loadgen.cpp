@@ -0,0 +1,439 @@
+// Load generator for the HTTP server: replays recorded requests or synthesizes a weighted mix
+// of /dfa, /nfa, /cfg, /pda and static GETs, and reports throughput, latency percentiles and
+// error rates overall and per route.
+//
+//     toc_loadgen [--replay requests.jsonl | --mix dfa=4,nfa=2,cfg=1,pda=1,static=2]
+//                 [-c connections] [-n requests | -d seconds] [-r rate] [--reuse]
+//                 [--host 127.0.0.1] [--port 8080] [--data dir]
+//
+// A replay file holds one request per line as {"method": "POST", "path": "/nfa", "body": "..."};
+// lines without a method and path are skipped, and the file is cycled through in order. The
+// mix builds its bodies from the sample definitions (dfaAcceptInput.txt, nfaInput.txt,
+// cfgInput.txt, pdaInput.txt) in the data directory, sent the way the web pages send them.
+//
+// Without -r the run is closed-loop: each of the -c workers sends its next request as soon as
+// the previous one is answered. With -r it is open-loop: request i is due at start + i / rate
+// whether or not earlier ones have been answered, and its latency is measured from when it was
+// due, so time spent waiting for a free worker counts against the server instead of being
+// hidden. --reuse keeps a connection open between requests when the server allows it and
+// reconnects when it does not. Every worker connects from the same address, so unless the
+// per-client limits are what is being measured, start the server with TOC_RATE, TOC_BURST and
+// TOC_MAX_CLIENT_PENDING raised (see admission.hpp). Build from the repository root:
+//
+//     g++ -std=c++17 -O2 -I. tools/loadgen.cpp json.cpp -lpthread -o toc_loadgen
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cerrno>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "json.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Request {
+    std::string method;
+    std::string path;
+    std::string body;
+};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    std::string port = "8080";
+    std::string data = ".";
+    std::string replay;
+    std::string mix = "dfa=4,nfa=2,cfg=1,pda=1,static=2";
+    unsigned connections = 8;
+    std::uint64_t requests = 1000;
+    double seconds = 0;
+    double rate = 0;
+    bool reuse = false;
+};
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// Contents of the string field key of a one-line JSON object, or false when it has none
+bool jsonStringField(std::string_view line, const std::string& key, std::string& value) {
+    std::size_t pos = line.find("\"" + key + "\"");
+    if (pos == std::string_view::npos) return false;
+    pos = line.find(':', pos + key.size() + 2);
+    if (pos == std::string_view::npos) return false;
+    pos = line.find_first_not_of(" \t", pos + 1);
+    if (pos == std::string_view::npos || line[pos] != '"') return false;
+
+    std::size_t end = pos + 1;
+    while (end < line.size() && line[end] != '"') {
+        end += line[end] == '\\' ? 2 : 1;
+    }
+    if (end >= line.size()) return false;
+    value = unescapeJson(line.substr(pos + 1, end - pos - 1));
+    return true;
+}
+
+std::vector<Request> loadReplay(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    std::vector<Request> requests;
+    std::string line;
+    while (std::getline(file, line)) {
+        Request request;
+        if (jsonStringField(line, "method", request.method) && jsonStringField(line, "path", request.path)) {
+            jsonStringField(line, "body", request.body);
+            requests.push_back(std::move(request));
+        }
+    }
+    if (requests.empty()) {
+        throw std::runtime_error(path + " holds no {\"method\", \"path\"} requests");
+    }
+    return requests;
+}
+
+// The DFA page posts JSON with the definition and input; the other pages post the text as is
+std::vector<Request> samples(const std::string& kind, const std::string& data) {
+    if (kind == "static") {
+        return { { "GET", "/", "" }, { "GET", "/style.css", "" }, { "GET", "/dfa.js", "" } };
+    }
+    if (kind == "dfa") {
+        std::string text = readFile(data + "/dfaAcceptInput.txt");
+        text.erase(std::remove(text.begin(), text.end(), '\r'), text.end());
+        std::size_t blank = text.find("\n\n");
+        std::string definition = text.substr(0, blank);
+        std::string input = blank == std::string::npos ? "" : text.substr(blank + 2);
+        while (!input.empty() && input.back() == '\n') input.pop_back();
+        return { { "POST", "/dfa", "{\"dfaDefinition\":\"" + escapeJson(definition) + "\",\"inputString\":\"" +
+            escapeJson(input) + "\"}" } };
+    }
+    if (kind == "nfa" || kind == "cfg" || kind == "pda") {
+        return { { "POST", "/" + kind, readFile(data + "/" + kind + "Input.txt") } };
+    }
+    throw std::runtime_error("unknown mix entry " + kind);
+}
+
+// Expands "dfa=4,nfa=2" into a list holding each kind's samples weight times over
+std::vector<Request> loadMix(const std::string& mix, const std::string& data) {
+    std::vector<Request> requests;
+    std::istringstream entries(mix);
+    std::string entry;
+    while (std::getline(entries, entry, ',')) {
+        std::size_t equals = entry.find('=');
+        std::string kind = entry.substr(0, equals);
+        int weight = equals == std::string::npos ? 1 : std::atoi(entry.c_str() + equals + 1);
+        std::vector<Request> kind_samples = samples(kind, data);
+        for (int i = 0; i < weight; ++i) {
+            requests.insert(requests.end(), kind_samples.begin(), kind_samples.end());
+        }
+    }
+    if (requests.empty()) {
+        throw std::runtime_error("empty mix");
+    }
+    return requests;
+}
+
+// Latencies and outcomes seen by one worker, merged once the run is over
+struct Stats {
+    std::map<std::string, std::vector<std::uint64_t>> latencies;
+    std::map<int, std::uint64_t> statuses;
+    std::uint64_t errors = 0;
+    std::uint64_t connects = 0;
+    std::uint64_t bytes_in = 0;
+
+    void merge(const Stats& other) {
+        for (const auto& [route, values] : other.latencies) {
+            latencies[route].insert(latencies[route].end(), values.begin(), values.end());
+        }
+        for (const auto& [status, count] : other.statuses) statuses[status] += count;
+        errors += other.errors;
+        connects += other.connects;
+        bytes_in += other.bytes_in;
+    }
+};
+
+class Connection {
+public:
+    Connection(const addrinfo* address, bool reuse) : address(address), reuse(reuse) {}
+    ~Connection() { disconnect(); }
+
+    // Sends request and reads the whole response; false on a transport error. A reused
+    // connection the server has already closed is reopened and the request sent again.
+    bool exchange(const std::string& request, int& status, std::size_t& received, Stats& stats) {
+        bool fresh = fd < 0;
+        if (fresh && !connect(stats)) {
+            return false;
+        }
+        if (sendAll(request) && readResponse(status, received)) {
+            if (!reuse || !keep_open) disconnect();
+            return true;
+        }
+        disconnect();
+        if (fresh || !connect(stats)) {
+            return false;
+        }
+        bool ok = sendAll(request) && readResponse(status, received);
+        if (!ok || !reuse || !keep_open) disconnect();
+        return ok;
+    }
+
+private:
+    bool connect(Stats& stats) {
+        fd = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (fd < 0) return false;
+        timeval timeout{ 30, 0 };
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (::connect(fd, address->ai_addr, address->ai_addrlen) != 0) {
+            disconnect();
+            return false;
+        }
+        ++stats.connects;
+        return true;
+    }
+
+    void disconnect() {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    bool sendAll(const std::string& data) {
+        std::size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    // Reads to the end of the body: Content-Length bytes after the head, or to end of stream
+    bool readResponse(int& status, std::size_t& received) {
+        std::string response;
+        char chunk[16384];
+        std::size_t head_end = std::string::npos;
+        std::size_t expected = std::string::npos;
+        keep_open = false;
+        while (true) {
+            if (head_end != std::string::npos && expected != std::string::npos && response.size() >= head_end + expected) {
+                break;
+            }
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n < 0) return false;
+            if (n == 0) {
+                if (head_end == std::string::npos ||
+                    (expected != std::string::npos && response.size() < head_end + expected)) return false;
+                keep_open = false;
+                break;
+            }
+            response.append(chunk, static_cast<std::size_t>(n));
+            if (head_end == std::string::npos && (head_end = response.find("\r\n\r\n")) != std::string::npos) {
+                head_end += 4;
+                std::string head = response.substr(0, head_end);
+                std::transform(head.begin(), head.end(), head.begin(), [](unsigned char c) { return std::tolower(c); });
+                std::size_t length = head.find("\r\ncontent-length:");
+                if (length != std::string::npos) {
+                    expected = std::strtoull(head.c_str() + length + 17, nullptr, 10);
+                    keep_open = head.find("\r\nconnection: close") == std::string::npos;
+                }
+            }
+        }
+        status = std::atoi(response.c_str() + std::min(response.size(), std::size_t(9)));
+        received = response.size();
+        return true;
+    }
+
+    const addrinfo* address;
+    bool reuse;
+    bool keep_open = false;
+    int fd = -1;
+};
+
+std::string routeOf(const Request& request) {
+    if (request.method == "GET") {
+        return request.path == "/" || request.path == "/metrics" ? request.path : "static";
+    }
+    return request.path;
+}
+
+double percentile(const std::vector<std::uint64_t>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    std::size_t rank = static_cast<std::size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[rank] / 1000.0;
+}
+
+void report(Stats& stats, double elapsed, std::ostream& out) {
+    std::uint64_t completed = 0;
+    std::uint64_t failed = stats.errors;
+    for (const auto& [status, count] : stats.statuses) {
+        completed += count;
+        if (status >= 500) failed += count;
+    }
+    std::uint64_t total = completed + stats.errors;
+
+    out << "requests " << total << " in " << elapsed << " s, " << (elapsed > 0 ? total / elapsed : 0) << " req/s, "
+        << stats.connects << " connections, " << stats.bytes_in / 1024 << " KiB received\n";
+    out << "errors " << stats.errors << " transport, " << failed - stats.errors << " 5xx ("
+        << (total > 0 ? 100.0 * failed / total : 0) << "%)\n";
+    out << "status";
+    for (const auto& [status, count] : stats.statuses) out << " " << status << ":" << count;
+    out << "\n";
+
+    std::vector<std::uint64_t> all;
+    for (const auto& [route, values] : stats.latencies) all.insert(all.end(), values.begin(), values.end());
+    stats.latencies["all"] = std::move(all);
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-18s %8s %9s %9s %9s %9s %9s\n", "route (ms)", "count", "p50", "p90", "p99", "p99.9", "max");
+    out << line;
+    for (auto& [route, values] : stats.latencies) {
+        std::sort(values.begin(), values.end());
+        std::snprintf(line, sizeof(line), "%-18s %8zu %9.2f %9.2f %9.2f %9.2f %9.2f\n", route.c_str(), values.size(),
+            percentile(values, 0.5), percentile(values, 0.9), percentile(values, 0.99), percentile(values, 0.999),
+            values.empty() ? 0.0 : values.back() / 1000.0);
+        out << line;
+    }
+}
+
+void usage() {
+    std::cerr << "usage: toc_loadgen [--replay file | --mix dfa=4,nfa=2,cfg=1,pda=1,static=2] [-c connections]\n"
+        << "                   [-n requests | -d seconds] [-r rate] [--reuse] [--host host] [--port port] [--data dir]\n";
+}
+
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--reuse") {
+            options.reuse = true;
+        }
+        else if (i + 1 < argc && (arg == "--replay" || arg == "--mix" || arg == "--host" || arg == "--port" ||
+            arg == "--data" || arg == "-c" || arg == "-n" || arg == "-d" || arg == "-r")) {
+            std::string value = argv[++i];
+            if (arg == "--replay") options.replay = value;
+            else if (arg == "--mix") options.mix = value;
+            else if (arg == "--host") options.host = value;
+            else if (arg == "--port") options.port = value;
+            else if (arg == "--data") options.data = value;
+            else if (arg == "-c") options.connections = std::max(1, std::atoi(value.c_str()));
+            else if (arg == "-n") options.requests = std::strtoull(value.c_str(), nullptr, 10);
+            else if (arg == "-d") options.seconds = std::atof(value.c_str());
+            else options.rate = std::atof(value.c_str());
+        }
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    std::vector<Request> requests;
+    try {
+        requests = options.replay.empty() ? loadMix(options.mix, options.data) : loadReplay(options.replay);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* address = nullptr;
+    if (::getaddrinfo(options.host.c_str(), options.port.c_str(), &hints, &address) != 0 || address == nullptr) {
+        std::cerr << "Error: cannot resolve " << options.host << ":" << options.port << "\n";
+        return 1;
+    }
+
+    // Requests are serialized once; the Connection header is the only part that depends on reuse
+    std::vector<std::string> wire;
+    for (const Request& request : requests) {
+        std::string message = request.method + " " + request.path + " HTTP/1.1\r\nHost: " + options.host + "\r\n";
+        if (!request.body.empty()) {
+            message += "Content-Type: text/plain\r\nContent-Length: " + std::to_string(request.body.size()) + "\r\n";
+        }
+        message += options.reuse ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+        wire.push_back(message + request.body);
+    }
+
+    // The mix is drawn at random so workers do not march through it in step; a replay keeps
+    // its recorded order
+    bool shuffle = options.replay.empty();
+    std::uint64_t limit = options.seconds > 0 ? UINT64_MAX : options.requests;
+    auto start = Clock::now();
+    auto deadline = options.seconds > 0
+        ? start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.seconds))
+        : Clock::time_point::max();
+
+    std::atomic<std::uint64_t> next{ 0 };
+    std::vector<Stats> stats(options.connections);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < options.connections; ++t) {
+        workers.emplace_back([&, t]() {
+            Connection connection(address, options.reuse);
+            std::mt19937_64 random(t + 1);
+            Stats& local = stats[t];
+            while (true) {
+                std::uint64_t index = next.fetch_add(1);
+                if (index >= limit) break;
+                auto due = Clock::now();
+                if (options.rate > 0) {
+                    due = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(index / options.rate));
+                    std::this_thread::sleep_until(due);
+                }
+                if (due >= deadline || Clock::now() >= deadline) break;
+
+                std::size_t pick = shuffle ? random() % requests.size() : index % requests.size();
+                int status = 0;
+                std::size_t received = 0;
+                if (connection.exchange(wire[pick], status, received, local)) {
+                    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - due).count();
+                    local.latencies[routeOf(requests[pick])].push_back(static_cast<std::uint64_t>(latency));
+                    ++local.statuses[status];
+                    local.bytes_in += received;
+                }
+                else {
+                    ++local.errors;
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    ::freeaddrinfo(address);
+
+    Stats total;
+    for (const Stats& worker_stats : stats) {
+        total.merge(worker_stats);
+    }
+    report(total, elapsed, std::cout);
+    return total.errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,207 @@
+#include "trace.hpp"
+#include "dfa.hpp"
+#include "nfa.hpp"
+#include "pda.hpp"
+#include "json.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+class DFATrace : public TraceMachine {
+public:
+    explicit DFATrace(const std::string& definition) : dfa(definition) { reset(); }
+
+    bool valid() const { return dfa.validate(); }
+
+    void reset() override {
+        current.clear();
+        if (dfa.startState() != Automaton::NO_STATE) {
+            current.push_back(dfa.startState());
+        }
+    }
+
+    bool accepting() const override { return !current.empty() && dfa.isAccepting(current[0]); }
+
+    std::vector<std::string> stateNames() const override {
+        std::vector<std::string> names;
+        for (std::uint32_t state = 0; state < dfa.stateCount(); ++state) names.emplace_back(dfa.stateName(state));
+        return names;
+    }
+
+    std::vector<std::string> symbolNames() const override {
+        std::vector<std::string> names;
+        for (std::uint32_t symbol = 0; symbol < dfa.symbolCount(); ++symbol) names.emplace_back(dfa.symbolName(symbol));
+        return names;
+    }
+
+protected:
+    const SymbolTokenizer& tokenizer() const override { return dfa.symbolTokenizer(); }
+
+    void advance(std::uint32_t symbol) override {
+        std::uint32_t next = dfa.next(current[0], symbol);
+        current.clear();
+        if (next != Automaton::NO_STATE) {
+            current.push_back(next);
+        }
+    }
+
+private:
+    DFA dfa;
+};
+
+class NFATrace : public TraceMachine {
+public:
+    explicit NFATrace(const std::string& definition) : nfa(definition) { reset(); }
+
+    bool valid() const { return nfa.validate(); }
+
+    void reset() override {
+        states = nfa.initialStates();
+        refill();
+    }
+
+    bool accepting() const override { return states.intersects(nfa.acceptStates()); }
+
+    std::vector<std::string> stateNames() const override {
+        std::vector<std::string> names;
+        for (std::uint32_t state = 0; state < nfa.stateCount(); ++state) names.emplace_back(nfa.stateName(state));
+        return names;
+    }
+
+    std::vector<std::string> symbolNames() const override {
+        std::vector<std::string> names;
+        for (std::uint32_t symbol = 0; symbol < nfa.symbolCount(); ++symbol) names.emplace_back(nfa.symbolName(symbol));
+        return names;
+    }
+
+protected:
+    const SymbolTokenizer& tokenizer() const override { return nfa.symbolTokenizer(); }
+
+    void advance(std::uint32_t symbol) override {
+        states = nfa.step(states, symbol);
+        refill();
+    }
+
+private:
+    NFA nfa;
+    StateSet states;
+
+    void refill() {
+        current.clear();
+        states.forEach([&](std::uint32_t state) { current.push_back(state); });
+    }
+};
+
+class PDATrace : public TraceMachine {
+public:
+    explicit PDATrace(const std::string& definition) : pda(definition), run(pda) { refill(); }
+
+    bool valid() const { return pda.validate(); }
+
+    void reset() override {
+        run.reset();
+        refill();
+    }
+
+    bool accepting() const override { return run.accepting(); }
+
+    std::vector<std::string> stateNames() const override {
+        std::vector<std::string> names;
+        for (std::uint32_t state = 0; state < pda.stateCount(); ++state) names.emplace_back(pda.stateName(state));
+        return names;
+    }
+
+    std::vector<std::string> symbolNames() const override {
+        std::vector<std::string> names;
+        for (std::uint32_t symbol = 0; symbol < pda.symbolCount(); ++symbol) names.emplace_back(pda.symbolName(symbol));
+        return names;
+    }
+
+    std::vector<std::string> stackSymbolNames() const override {
+        std::vector<std::string> names;
+        for (std::uint32_t symbol = 0; symbol < pda.stackSymbolCount(); ++symbol) names.emplace_back(pda.stackSymbolName(symbol));
+        return names;
+    }
+
+protected:
+    const SymbolTokenizer& tokenizer() const override { return pda.symbolTokenizer(); }
+
+    void advance(std::uint32_t symbol) override {
+        run.step(symbol);
+        refill();
+    }
+
+private:
+    PDA pda;
+    PDARun run;
+
+    void refill() {
+        std::uint32_t width = pda.stackSymbolCount() + 1;
+        current.clear();
+        for (const PDAConfiguration& configuration : run.configurations()) {
+            std::uint32_t top = run.top(configuration);
+            current.push_back(configuration.state * width + (top == PDA::EPSILON ? width - 1 : top));
+        }
+        std::sort(current.begin(), current.end());
+        current.erase(std::unique(current.begin(), current.end()), current.end());
+    }
+};
+
+// The PDA parser reads one section per line rather than the literal \n separators
+std::string withNewlines(const std::string& definition) {
+    std::string text;
+    for (std::size_t i = 0; i < definition.size(); ++i) {
+        if (definition[i] == '\\' && i + 1 < definition.size() && definition[i + 1] == 'n') {
+            text += '\n';
+            ++i;
+        }
+        else {
+            text += definition[i];
+        }
+    }
+    return text;
+}
+
+template <typename Trace>
+std::unique_ptr<TraceMachine> validated(std::unique_ptr<Trace> trace, std::string& error) {
+    if (!trace->valid()) {
+        error = "invalid definition";
+        return nullptr;
+    }
+    return trace;
+}
+
+}
+
+std::unique_ptr<TraceMachine> TraceMachine::load(Kind kind, const std::string& definition, std::string& error) {
+    switch (kind) {
+    case Kind::DFA:
+        return validated(std::make_unique<DFATrace>(definition), error);
+    case Kind::NFA:
+        return validated(std::make_unique<NFATrace>(nfaDefinition(definition)), error);
+    case Kind::PDA:
+        return validated(std::make_unique<PDATrace>(withNewlines(definition)), error);
+    }
+    return nullptr;
+}
+
+void TraceMachine::step(std::uint32_t symbol, TraceDelta& delta) {
+    delta.added.clear();
+    delta.removed.clear();
+    if (current.empty()) {
+        return;
+    }
+
+    std::vector<std::uint32_t> previous = current;
+    if (symbol == SymbolTable::NO_SYMBOL) {
+        current.clear();
+    }
+    else {
+        advance(symbol);
+    }
+
+    // Both lists are sorted, so the delta is two linear set differences
+    std::set_difference(current.begin(), current.end(), previous.begin(), previous.end(), std::back_inserter(delta.added));
+    std::set_difference(previous.begin(), previous.end(), current.begin(), current.end(), std::back_inserter(delta.removed));
+}
@@ -0,0 +1,59 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include "symbol_table.hpp"
+#include "symbol_tokenizer.hpp"
+
+// Configurations that appeared and disappeared in one step of a run
+struct TraceDelta {
+    std::vector<std::uint32_t> added;
+    std::vector<std::uint32_t> removed;
+};
+
+// A machine compiled once and then run one input symbol at a time, for clients that
+// animate a run step by step. The input is split by the same longest match accepts() uses,
+// so a step may consume several characters. The current configurations are reported as ids
+// in ascending order: the state id for a DFA or NFA, and state * (stack symbols + 1) + top
+// for a PDA, where top is the top stack symbol id or the stack symbol count on an empty
+// stack. Several PDA configurations that differ only below the top share one id.
+class TraceMachine {
+public:
+    enum class Kind { DFA, NFA, PDA };
+
+    // Builds the machine from the single-line form the JSON routes take (literal \n between
+    // sections); returns null with error set when the definition does not validate
+    static std::unique_ptr<TraceMachine> load(Kind kind, const std::string& definition, std::string& error);
+    virtual ~TraceMachine() = default;
+
+    // Back to the start configurations
+    virtual void reset() = 0;
+    // Symbol starting at input[pos] and its length in characters; SymbolTable::NO_SYMBOL, with
+    // length 1, when no declared symbol starts there
+    std::uint32_t nextSymbol(std::string_view input, std::size_t pos, std::size_t& length) const {
+        return tokenizer().next(input, pos, length);
+    }
+    // Consumes one symbol from nextSymbol() and reports the change; NO_SYMBOL or a missing
+    // transition ends the run with every configuration removed
+    void step(std::uint32_t symbol, TraceDelta& delta);
+    virtual bool accepting() const = 0;
+    const std::vector<std::uint32_t>& configurations() const { return current; }
+
+    virtual std::vector<std::string> stateNames() const = 0;
+    virtual std::vector<std::string> symbolNames() const = 0;
+    virtual std::vector<std::string> stackSymbolNames() const { return {}; }
+
+protected:
+    std::vector<std::uint32_t> current;
+
+    virtual const SymbolTokenizer& tokenizer() const = 0;
+    // Advances the underlying run and refills current
+    virtual void advance(std::uint32_t symbol) = 0;
+};
+
+#endif